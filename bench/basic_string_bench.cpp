@@ -0,0 +1,136 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include "basic_string.h"
+#include "bench.h"
+#include "vector.h"
+
+// Short strings of 4..23 chars fit dl::string's inline buffer; libstdc++
+// keeps 15 inline, libc++ 22.
+static dl::vector<std::string> words(size_t count, size_t min_len, size_t max_len) {
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<size_t> len(min_len, max_len);
+    dl::vector<std::string> out;
+    for (size_t i = 0; i < count; ++i) {
+        std::string w(len(gen), ' ');
+        for (auto& c : w) {
+            c = static_cast<char>('a' + gen() % 26);
+        }
+        out.push_back(std::move(w));
+    }
+    return out;
+}
+
+template<typename String>
+static void construct(bench::state& state, const std::string& label, const dl::vector<std::string>& src) {
+    state.measure(label, src.size(), 0, [&] {
+        dl::vector<String> out;
+        out.reserve(src.size());
+        for (auto& w : src) {
+            out.emplace_back(w.data(), w.size());
+        }
+        auto copy = out;
+        bench::do_not_optimize(copy.data());
+    });
+}
+
+template<typename String>
+static void append(bench::state& state, const std::string& label, const dl::vector<std::string>& src) {
+    state.measure(label, src.size(), 0, [&] {
+        String out;
+        for (auto& w : src) {
+            out.append(w.data(), w.size());
+            out.push_back(',');
+        }
+        bench::do_not_optimize(out.data());
+    });
+}
+
+template<typename String>
+static void search(bench::state& state, const std::string& label, const String& text, const String& needle) {
+    state.measure(label, text.size(), text.size(), [&] {
+        size_t hits = 0;
+        for (size_t pos = text.find(needle); pos != String::npos; pos = text.find(needle, pos + 1)) {
+            ++hits;
+        }
+        bench::do_not_optimize(hits);
+    });
+}
+
+BENCH(string_short) {
+    size_t count = bench::large() ? 10000000 : 1000000;
+    auto src = words(count, 4, 14);
+    construct<std::string>(state, "construct_4_14/std", src);
+    construct<dl::string>(state, "construct_4_14/dl", src);
+    src = words(count, 16, 23);
+    construct<std::string>(state, "construct_16_23/std", src);
+    construct<dl::string>(state, "construct_16_23/dl", src);
+    src = words(count / 10, 40, 200);
+    construct<std::string>(state, "construct_40_200/std", src);
+    construct<dl::string>(state, "construct_40_200/dl", src);
+}
+
+BENCH(string_long) {
+    size_t count = bench::large() ? 10000000 : 1000000;
+    auto src = words(count, 4, 14);
+    append<std::string>(state, "append/std", src);
+    append<dl::string>(state, "append/dl", src);
+
+    std::string text;
+    for (auto& w : src) {
+        text += w;
+        text += ' ';
+    }
+    std::string needle = "needle";
+    text.replace(text.size() / 2, needle.size(), needle);
+    dl::string dl_text(text.data(), text.size());
+    dl::string dl_needle(needle.data(), needle.size());
+    search<std::string>(state, "find_substr/std", text, needle);
+    search<dl::string>(state, "find_substr/dl", dl_text, dl_needle);
+    search<std::string>(state, "find_char/std", text, std::string("!"));
+    search<dl::string>(state, "find_char/dl", dl_text, dl::string("!"));
+
+    // many short keys, the parsing case: inline kernels, no libc call
+    auto keys = words(count, 8, 40);
+    dl::vector<dl::string> dl_keys;
+    for (auto& k : keys) {
+        dl_keys.emplace_back(k.data(), k.size());
+    }
+    state.measure("find_short/std", keys.size(), 0, [&] {
+        size_t hits = 0;
+        for (auto& k : keys) {
+            hits += k.find('q') != std::string::npos;
+        }
+        bench::do_not_optimize(hits);
+    });
+    state.measure("find_short/dl", keys.size(), 0, [&] {
+        size_t hits = 0;
+        for (auto& k : dl_keys) {
+            hits += k.find('q') != dl::string::npos;
+        }
+        bench::do_not_optimize(hits);
+    });
+    state.measure("compare_short/std", keys.size(), 0, [&] {
+        int r = 0;
+        for (size_t i = 1; i < keys.size(); ++i) {
+            r += keys[i].compare(keys[i - 1]) < 0;
+        }
+        bench::do_not_optimize(r);
+    });
+    state.measure("compare_short/dl", keys.size(), 0, [&] {
+        int r = 0;
+        for (size_t i = 1; i < dl_keys.size(); ++i) {
+            r += dl_keys[i].compare(dl_keys[i - 1]) < 0;
+        }
+        bench::do_not_optimize(r);
+    });
+
+    auto text2 = text;
+    auto dl_text2 = dl_text;
+    state.measure("compare/std", text.size(), text.size(), [&] {
+        bench::do_not_optimize(text.compare(text2));
+    });
+    state.measure("compare/dl", text.size(), text.size(), [&] {
+        bench::do_not_optimize(dl_text.compare(dl_text2));
+    });
+}
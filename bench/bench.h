@@ -0,0 +1,149 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include "perf_counters.h"
+
+namespace bench {
+
+struct options
+{
+    std::string filter;
+    size_t reps = 3;
+    bool large = false;
+    bool counters = true;
+};
+
+inline options& opts() {
+    static options o;
+    return o;
+}
+
+inline bool large() { return opts().large; }
+
+template<typename T>
+void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobber() {
+    asm volatile("" : : : "memory");
+}
+
+// Resident set size of the process, 0 where /proc is not available.
+inline size_t rss_bytes() {
+    unsigned long pages = 0, resident = 0;
+    if (auto f = std::fopen("/proc/self/statm", "r")) {
+        if (std::fscanf(f, "%lu %lu", &pages, &resident) != 2) {
+            resident = 0;
+        }
+        std::fclose(f);
+    }
+    return static_cast<size_t>(resident) * static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+}
+
+class state
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit state(std::string name) : name_(std::move(name)) {}
+
+    // Runs fn opts().reps times and reports the fastest run, with its
+    // hardware counters per item.
+    template<typename F>
+    double measure(const std::string& label, size_t items, size_t bytes, F&& fn) {
+        double best = 0;
+        counter_values best_counts;
+        for (size_t rep = 0; rep < std::max<size_t>(opts().reps, 1); ++rep) {
+            counter_values counts;
+            double sec;
+            {
+                std::optional<counter_scope> scope;
+                if (opts().counters) {
+                    scope.emplace(counts);
+                }
+                auto start = clock::now();
+                fn();
+                clobber();
+                sec = std::chrono::duration<double>(clock::now() - start).count();
+            }
+            if (rep == 0 || sec < best) {
+                best = sec;
+                best_counts = counts;
+            }
+        }
+        report(label, best, items, bytes);
+        if (opts().counters) {
+            report_counters(label, best_counts, items);
+        }
+        return best;
+    }
+
+    void note(const std::string& label, const char* key, double value) {
+        std::printf("%-48s %s=%.3f\n", (name_ + "/" + label).c_str(), key, value);
+    }
+
+private:
+    void report(const std::string& label, double sec, size_t items, size_t bytes) {
+        std::printf("%-48s %10.3f ms", (name_ + "/" + label).c_str(), sec * 1e3);
+        if (items != 0) {
+            std::printf(" %9.3f ns/item", sec * 1e9 / static_cast<double>(items));
+        }
+        if (bytes != 0) {
+            std::printf(" %8.3f GB/s", static_cast<double>(bytes) / sec / 1e9);
+        }
+        std::printf("\n");
+    }
+
+    // Per item, or per run when there are no items. Counters that are not
+    // available are left out.
+    void report_counters(const std::string& label, const counter_values& counts, size_t items) {
+        static const char* const keys[counter_count] = {"cyc", "ins", "l1d", "llc", "brmiss", "pf"};
+        double per = items != 0 ? static_cast<double>(items) : 1.0;
+        std::string line;
+        char buf[48];
+        for (size_t i = 0; i < counter_count; ++i) {
+            if (counts.values[i] >= 0) {
+                std::snprintf(buf, sizeof(buf), " %s=%.4g", keys[i], counts.values[i] / per);
+                line += buf;
+            }
+        }
+        if (counts.has(counter::cycles) && counts.has(counter::instructions) && counts[counter::cycles] > 0) {
+            std::snprintf(buf, sizeof(buf), " ipc=%.2f", counts[counter::instructions] / counts[counter::cycles]);
+            line += buf;
+        }
+        if (!line.empty()) {
+            std::printf("%-48s %s:%s\n", (name_ + "/" + label).c_str(), items != 0 ? "per_item" : "per_run", line.c_str());
+        }
+    }
+
+    std::string name_;
+};
+
+using bench_fn = void (*)(state&);
+
+inline std::vector<std::pair<const char*, bench_fn>>& registry() {
+    static std::vector<std::pair<const char*, bench_fn>> r;
+    return r;
+}
+
+struct registrar
+{
+    registrar(const char* name, bench_fn fn) {
+        registry().emplace_back(name, fn);
+    }
+};
+
+} // namespace bench
+
+#define BENCH(name)                                             \
+    static void name(bench::state&);                            \
+    static bench::registrar name##_registrar(#name, name);      \
+    static void name(bench::state& state)
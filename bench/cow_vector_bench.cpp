@@ -0,0 +1,84 @@
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "bench.h"
+#include "cow_vector.h"
+#include "vector.h"
+
+// Readers look up one entry of a shared table per request while a writer
+// replaces the table every millisecond. "locked_copy" is the deep copy under
+// a mutex that cow_vector replaces; "acquire" takes a snapshot per request,
+// "reader" keeps it until a new version is published.
+static constexpr size_t table_size = 1024;
+
+template<typename Snapshot, typename Publish>
+static void run(bench::state& state, const std::string& label, size_t threads, size_t lookups,
+                Snapshot&& snapshot, Publish&& publish) {
+    state.measure(label, threads * lookups, 0, [&] {
+        std::atomic<bool> done{false};
+        std::thread writer([&] {
+            for (uint64_t version = 1; !done.load(std::memory_order_relaxed); ++version) {
+                publish(version);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        dl::vector<std::thread> readers;
+        for (size_t t = 0; t < threads; ++t) {
+            readers.emplace_back([&, t] {
+                auto get = snapshot();
+                uint64_t sum = 0;
+                for (size_t i = 0; i < lookups; ++i) {
+                    sum += get()[(i * 7 + t) % table_size];
+                }
+                bench::do_not_optimize(sum);
+            });
+        }
+        for (auto& r : readers) {
+            r.join();
+        }
+        done = true;
+        writer.join();
+    });
+}
+
+static dl::vector<uint64_t> make_table(uint64_t version) {
+    return dl::vector<uint64_t>(table_size, version);
+}
+
+BENCH(cow_vector_readers) {
+    size_t lookups = bench::large() ? 2000000 : 200000;
+    for (size_t threads = 1; threads <= 2 * std::thread::hardware_concurrency(); threads *= 2) {
+        auto t = "/t" + std::to_string(threads);
+
+        std::mutex mutex;
+        auto table = make_table(0);
+        run(state, "locked_copy" + t, threads, lookups / 10,
+            [&] {
+                return [&] {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    return table;
+                };
+            },
+            [&](uint64_t version) {
+                auto next = make_table(version);
+                std::lock_guard<std::mutex> lock(mutex);
+                table.swap(next);
+            });
+
+        dl::atomic_cow_vector<uint64_t> slot(dl::cow_vector<uint64_t>(make_table(0)));
+        auto publish = [&](uint64_t version) {
+            slot.publish(dl::cow_vector<uint64_t>(make_table(version)));
+        };
+        run(state, "acquire" + t, threads, lookups,
+            [&] { return [&] { return slot.acquire(); }; }, publish);
+        run(state, "reader" + t, threads, lookups,
+            [&] {
+                return [reader = dl::cow_reader<uint64_t>(slot)]() mutable -> const dl::cow_vector<uint64_t>& {
+                    return reader.get();
+                };
+            },
+            publish);
+    }
+}
@@ -0,0 +1,45 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "bench.h"
+#include "file_loader.h"
+#include "vector.h"
+
+BENCH(load_file) {
+    std::string path = "/tmp/dl_bench_load_file";
+    size_t max_bytes = bench::large() ? (size_t(10) << 30) : (size_t(1) << 30);
+    for (size_t bytes = size_t(1) << 20; bytes <= max_bytes; bytes *= 8) {
+        {
+            dl::vector<char> content(bytes, 'x');
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(content.data(), static_cast<std::streamsize>(content.size()));
+        }
+        auto label = std::to_string(bytes >> 20) + "MB";
+        if (bytes <= (size_t(128) << 20)) {
+            state.measure(label + "/istreambuf_iterator", bytes, bytes, [&] {
+                std::ifstream in(path, std::ios::binary);
+                dl::vector<char> vec(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>{});
+                bench::do_not_optimize(vec.data());
+            });
+        }
+        state.measure(label + "/load_file_serial", bytes, bytes, [&] {
+            auto vec = dl::load_file(path, dl::par.with_threshold(~size_t(0)));
+            bench::do_not_optimize(vec.data());
+        });
+        state.measure(label + "/load_file_parallel", bytes, bytes, [&] {
+            auto vec = dl::load_file(path);
+            bench::do_not_optimize(vec.data());
+        });
+        state.measure(label + "/chunked", bytes, bytes, [&] {
+            dl::chunked_file_reader reader(path);
+            dl::vector<char> chunk;
+            size_t sum = 0;
+            while (reader.next(chunk)) {
+                sum += static_cast<size_t>(chunk.back());
+            }
+            bench::do_not_optimize(sum);
+        });
+    }
+    std::remove(path.c_str());
+}
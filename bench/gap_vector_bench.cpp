@@ -0,0 +1,80 @@
+#include <cstdint>
+#include <random>
+#include "bench.h"
+#include "gap_vector.h"
+#include "vector.h"
+
+struct edit
+{
+    uint32_t pos;
+    bool insert;
+};
+
+// Editing session: the cursor drifts a few positions between edits, most
+// edits type at the cursor, some delete before it.
+static dl::vector<edit> edit_stream(size_t initial, size_t edits) {
+    std::mt19937 gen(11);
+    dl::vector<edit> res;
+    res.reserve(edits);
+    size_t size = initial;
+    size_t cursor = initial / 2;
+    for (size_t i = 0; i < edits; ++i) {
+        auto step = static_cast<int>(gen() % 9) - 4;
+        cursor = static_cast<size_t>(std::clamp<int64_t>(static_cast<int64_t>(cursor) + step, 0, static_cast<int64_t>(size)));
+        bool insert = gen() % 4 != 0 || cursor == 0;
+        if (insert) {
+            res.push_back({static_cast<uint32_t>(cursor++), true});
+            ++size;
+        } else {
+            res.push_back({static_cast<uint32_t>(--cursor), false});
+            --size;
+        }
+    }
+    return res;
+}
+
+template<typename Container>
+static void replay(bench::state& state, const std::string& label, size_t initial, const dl::vector<edit>& edits) {
+    state.measure(label, edits.size(), 0, [&] {
+        Container text(initial, 'x');
+        for (auto e : edits) {
+            if (e.insert) {
+                text.insert(text.begin() + e.pos, 'a');
+            } else {
+                text.erase(text.begin() + e.pos);
+            }
+        }
+        bench::do_not_optimize(text.size());
+    });
+}
+
+BENCH(gap_vector_cursor_edits) {
+    size_t edits = bench::large() ? 2'000'000 : 200'000;
+    for (size_t initial : {size_t(1) << 10, size_t(1) << 16, size_t(1) << 20}) {
+        auto stream = edit_stream(initial, edits);
+        auto n = "/n" + std::to_string(initial);
+        replay<dl::vector<char>>(state, "vector" + n, initial, stream);
+        replay<dl::gap_vector<char>>(state, "gap_vector" + n, initial, stream);
+    }
+
+    // sequential scan after the edits, gap in the middle
+    size_t n = size_t(1) << 24;
+    dl::gap_vector<uint32_t> gap(n, 1);
+    gap.move_gap(n / 2);
+    gap.insert(gap.begin() + n / 2, 1);
+    dl::vector<uint32_t> vec(n, 1);
+    state.measure("scan/vector", n, n * sizeof(uint32_t), [&] {
+        uint64_t sum = 0;
+        for (auto v : vec) {
+            sum += v;
+        }
+        bench::do_not_optimize(sum);
+    });
+    state.measure("scan/gap_vector", n, n * sizeof(uint32_t), [&] {
+        uint64_t sum = 0;
+        for (auto v : gap) {
+            sum += v;
+        }
+        bench::do_not_optimize(sum);
+    });
+}
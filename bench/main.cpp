@@ -0,0 +1,42 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "bench.h"
+
+int main(int argc, char** argv) {
+    auto& o = bench::opts();
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--large") == 0) {
+            o.large = true;
+        } else if (std::strcmp(argv[i], "--no-counters") == 0) {
+            o.counters = false;
+        } else if (std::strncmp(argv[i], "--reps=", 7) == 0) {
+            o.reps = std::strtoul(argv[i] + 7, nullptr, 10);
+        } else {
+            o.filter = argv[i];
+        }
+    }
+
+    if (o.counters) {
+        std::string missing;
+        for (size_t i = 0; i < bench::counter_count; ++i) {
+            auto c = static_cast<bench::counter>(i);
+            if (!bench::counters().available(c)) {
+                missing += std::string(" ") + bench::counter_name(c);
+            }
+        }
+        if (!missing.empty()) {
+            std::fprintf(stderr, "counters not available:%s\n", missing.c_str());
+        }
+    }
+
+    for (auto& [name, fn] : bench::registry()) {
+        if (!o.filter.empty() && std::string(name).find(o.filter) == std::string::npos) {
+            continue;
+        }
+        bench::state st(name);
+        fn(st);
+    }
+    return 0;
+}
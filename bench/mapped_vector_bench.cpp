@@ -0,0 +1,44 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "bench.h"
+#include "mapped_vector.h"
+#include "vector.h"
+
+BENCH(mapped_vector_startup) {
+    size_t n = (bench::large() ? (size_t(8) << 30) : (size_t(512) << 20)) / sizeof(uint64_t);
+    std::string mapped_path = "/tmp/dl_bench_mapped_vector";
+    std::string raw_path = "/tmp/dl_bench_raw_vector";
+    {
+        dl::mapped_vector<uint64_t> vec(mapped_path, dl::mapped_mode::create);
+        vec.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            vec.push_back(i);
+        }
+        std::ofstream out(raw_path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(vec.data()), static_cast<std::streamsize>(n * sizeof(uint64_t)));
+    }
+
+    state.measure("read_into_vector", n, n * sizeof(uint64_t), [&] {
+        std::ifstream in(raw_path, std::ios::binary);
+        dl::vector<uint64_t> vec(n);
+        in.read(reinterpret_cast<char*>(vec.data()), static_cast<std::streamsize>(n * sizeof(uint64_t)));
+        bench::do_not_optimize(vec[n / 2]);
+    });
+    state.measure("open_mapped", n, 0, [&] {
+        dl::mapped_vector<uint64_t> vec(mapped_path, dl::mapped_mode::open);
+        bench::do_not_optimize(vec[n / 2]);
+    });
+    state.measure("open_mapped_and_scan", n, n * sizeof(uint64_t), [&] {
+        dl::mapped_vector<uint64_t> vec(mapped_path, dl::mapped_mode::open);
+        uint64_t sum = 0;
+        for (auto v : vec) {
+            sum += v;
+        }
+        bench::do_not_optimize(sum);
+    });
+
+    std::remove(mapped_path.c_str());
+    std::remove(raw_path.c_str());
+}
@@ -0,0 +1,66 @@
+#include <cstdint>
+#include "bench.h"
+#include "memory_resource.h"
+#include "vector.h"
+
+// Statically bound counterpart of polymorphic_allocator: the resource type is
+// known (and final), so allocate() is devirtualized and can be inlined.
+template<typename T, typename Resource>
+struct static_allocator
+{
+    using value_type = T;
+
+    explicit static_allocator(Resource* r) noexcept : resource(r) {}
+
+    template<typename U>
+    static_allocator(const static_allocator<U, Resource>& other) noexcept : resource(other.resource) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(resource->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T* p, size_t n) noexcept {
+        if (p != nullptr) {
+            resource->deallocate(p, n * sizeof(T), alignof(T));
+        }
+    }
+
+    bool operator==(const static_allocator& other) const noexcept { return resource == other.resource; }
+    bool operator!=(const static_allocator& other) const noexcept { return resource != other.resource; }
+
+    Resource* resource;
+};
+
+// Many short vectors grown by push_back: allocation dominated.
+template<typename Vector, typename Alloc>
+static void build(bench::state& state, const std::string& label, const Alloc& alloc, size_t vectors, size_t len) {
+    state.measure(label, vectors * len, 0, [&] {
+        for (size_t v = 0; v < vectors; ++v) {
+            Vector vec(alloc);
+            for (size_t i = 0; i < len; ++i) {
+                vec.push_back(static_cast<uint32_t>(i));
+            }
+            bench::do_not_optimize(vec.data());
+        }
+    });
+}
+
+BENCH(pmr_dispatch) {
+    size_t vectors = bench::large() ? 5'000'000 : 500'000;
+    size_t len = 32;
+
+    build<dl::vector<uint32_t>>(state, "std_allocator", std::allocator<uint32_t>(), vectors, len);
+    build<dl::pmr::vector<uint32_t>>(state, "pmr/new_delete", dl::pmr::polymorphic_allocator<uint32_t>(), vectors, len);
+
+    dl::pmr::unsynchronized_pool_resource pool;
+    using static_pool = static_allocator<uint32_t, dl::pmr::unsynchronized_pool_resource>;
+    build<dl::vector<uint32_t, static_pool>>(state, "static/pool", static_pool(&pool), vectors, len);
+    build<dl::pmr::vector<uint32_t>>(state, "pmr/pool", dl::pmr::polymorphic_allocator<uint32_t>(&pool), vectors, len);
+
+    dl::pmr::synchronized_pool_resource shared;
+    build<dl::pmr::vector<uint32_t>>(state, "pmr/synchronized_pool", dl::pmr::polymorphic_allocator<uint32_t>(&shared), vectors, len);
+
+    // the arena only grows; both variants start from a released one
+    dl::pmr::monotonic_buffer_resource arena(vectors * len * sizeof(uint32_t) * 2);
+    using static_arena = static_allocator<uint32_t, dl::pmr::monotonic_buffer_resource>;
+    build<dl::vector<uint32_t, static_arena>>(state, "static/monotonic", static_arena(&arena), vectors, len);
+    arena.release();
+    build<dl::pmr::vector<uint32_t>>(state, "pmr/monotonic", dl::pmr::polymorphic_allocator<uint32_t>(&arena), vectors, len);
+}
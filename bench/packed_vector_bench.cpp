@@ -0,0 +1,69 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include "bench.h"
+#include "packed_vector.h"
+#include "vector.h"
+
+BENCH(packed_vector) {
+    size_t n = bench::large() ? (size_t(1) << 28) : (size_t(1) << 22);
+    std::mt19937_64 gen(1);
+    for (unsigned width : {4u, 7u, 13u, 20u, 33u, 64u}) {
+        dl::packed_vector<uint64_t> vec(width);
+        vec.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            vec.push_back(gen() & dl::low_mask(width));
+        }
+        auto label = "w" + std::to_string(width);
+        state.note(label, "bytes/elem", static_cast<double>(vec.memory_bytes()) / static_cast<double>(n));
+
+        dl::vector<uint64_t> out;
+        vec.unpack(out);
+        state.measure(label + "/unpack", n, n * sizeof(uint64_t), [&] {
+            vec.unpack(0, n, out.data());
+            bench::do_not_optimize(out.data());
+        });
+
+        dl::vector<size_t> idx(1 << 20);
+        for (auto& i : idx) {
+            i = gen() % n;
+        }
+        state.measure(label + "/random", idx.size(), 0, [&] {
+            uint64_t sum = 0;
+            for (auto i : idx) {
+                sum += vec[i];
+            }
+            bench::do_not_optimize(sum);
+        });
+    }
+}
+
+BENCH(delta_packed_vector) {
+    size_t n = bench::large() ? (size_t(1) << 28) : (size_t(1) << 22);
+    std::mt19937_64 gen(2);
+    dl::delta_packed_vector<uint64_t> vec;
+    uint64_t id = 0;
+    for (size_t i = 0; i < n; ++i) {
+        id += 1 + gen() % 64;
+        vec.push_back(id);
+    }
+    state.note("sorted_ids", "bytes/elem", static_cast<double>(vec.memory_bytes()) / static_cast<double>(n));
+
+    dl::vector<uint64_t> out;
+    state.measure("sorted_ids/unpack", n, n * sizeof(uint64_t), [&] {
+        vec.unpack(out);
+        bench::do_not_optimize(out.data());
+    });
+
+    dl::vector<uint64_t> keys(1 << 18);
+    for (auto& k : keys) {
+        k = gen() % id;
+    }
+    state.measure("sorted_ids/lower_bound", keys.size(), 0, [&] {
+        size_t sum = 0;
+        for (auto k : keys) {
+            sum += vec.lower_bound(k);
+        }
+        bench::do_not_optimize(sum);
+    });
+}
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include "bench.h"
+#include "page_allocator.h"
+#include "prefault.h"
+#include "vector.h"
+
+template<typename Alloc>
+static void gather(bench::state& state, const char* label, const Alloc& alloc) {
+    size_t n = (bench::large() ? (size_t(16) << 30) : (size_t(1) << 30)) / sizeof(uint64_t);
+    dl::vector<uint64_t, Alloc> vec(n, 1, alloc);
+
+    std::mt19937_64 gen(5);
+    dl::vector<uint64_t> idx(size_t(1) << 22);
+    for (auto& i : idx) {
+        i = gen() % n;
+    }
+    state.measure(label, idx.size(), 0, [&] {
+        uint64_t sum = 0;
+        for (auto i : idx) {
+            sum += vec[i];
+        }
+        bench::do_not_optimize(sum);
+    });
+}
+
+BENCH(random_gather) {
+    gather(state, "std_allocator", std::allocator<uint64_t>());
+    gather(state, "hugepage", dl::hugepage_allocator<uint64_t>());
+    gather(state, "numa_interleave", dl::numa_allocator<uint64_t>(dl::numa_policy::interleave));
+    gather(state, "numa_local", dl::numa_allocator<uint64_t>(dl::numa_policy::local));
+}
+
+// Latency of writes into freshly reserved capacity, timed per 64 elements
+// (eight samples per 4 KiB page), so first-touch page faults land in the
+// tail. The reserve call itself is timed separately: prefaulting moves the
+// faults there.
+template<typename Vector, typename Reserve>
+static void first_touch(bench::state& state, const char* label, Reserve&& reserve) {
+    using clock = bench::state::clock;
+    constexpr size_t chunk = 64;
+    size_t n = (bench::large() ? (size_t(2) << 30) : (size_t(256) << 20)) / sizeof(uint64_t);
+    dl::vector<uint64_t> samples(n / chunk);
+    Vector vec;
+    auto start = clock::now();
+    reserve(vec, n);
+    auto reserve_ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+    for (size_t c = 0; c < samples.size(); ++c) {
+        auto t0 = clock::now();
+        for (size_t i = 0; i < chunk; ++i) {
+            vec.push_back(c * chunk + i);
+        }
+        bench::clobber();
+        samples[c] = static_cast<uint64_t>(std::chrono::duration<double, std::nano>(clock::now() - t0).count());
+    }
+    bench::do_not_optimize(vec.data());
+    std::sort(samples.begin(), samples.end());
+    auto pct = [&](double p) {
+        return static_cast<double>(samples[std::min(samples.size() - 1, static_cast<size_t>(p * static_cast<double>(samples.size())))]);
+    };
+    state.note(label, "reserve_ms", reserve_ns / 1e6);
+    state.note(label, "p50_ns", pct(0.5));
+    state.note(label, "p99_ns", pct(0.99));
+    state.note(label, "p99.9_ns", pct(0.999));
+    state.note(label, "max_ns", static_cast<double>(samples.back()));
+}
+
+BENCH(first_touch_latency) {
+    first_touch<dl::vector<uint64_t>>(state, "reserve", [](auto& vec, size_t n) { vec.reserve(n); });
+    first_touch<dl::vector<uint64_t>>(state, "reserve_prefault",
+                                      [](auto& vec, size_t n) { dl::reserve_prefault(vec, n); });
+    first_touch<dl::vector<uint64_t, dl::locked_allocator<uint64_t>>>(state, "locked_allocator",
+                                                                      [](auto& vec, size_t n) { vec.reserve(n); });
+}
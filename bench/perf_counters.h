@@ -0,0 +1,147 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace bench {
+
+enum class counter : size_t
+{
+    cycles,
+    instructions,
+    l1d_misses,
+    llc_misses,
+    branch_misses,
+    page_faults,
+};
+
+inline constexpr size_t counter_count = 6;
+
+inline const char* counter_name(counter c) {
+    static const char* const names[counter_count] = {
+        "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "page_faults"};
+    return names[static_cast<size_t>(c)];
+}
+
+// Counter totals; -1 marks a counter that is not available.
+struct counter_values
+{
+    std::array<double, counter_count> values{};
+
+    double operator[](counter c) const { return values[static_cast<size_t>(c)]; }
+    double& operator[](counter c) { return values[static_cast<size_t>(c)]; }
+    bool has(counter c) const { return (*this)[c] >= 0; }
+};
+
+// Hardware and software counters of the calling thread, user space only.
+// Every counter is opened on its own, so one the kernel does not offer
+// (no PMU in most VMs and containers, perf_event_paranoid, seccomp) drops
+// just that counter; page faults fall back to getrusage. Hardware counters
+// that the kernel multiplexes are scaled up to the full running time.
+class perf_counters
+{
+public:
+    perf_counters() {
+        fds_.fill(-1);
+        open(counter::cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        open(counter::instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        open(counter::l1d_misses, PERF_TYPE_HW_CACHE,
+             PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        open(counter::llc_misses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        open(counter::branch_misses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        open(counter::page_faults, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+    }
+
+    ~perf_counters() {
+        for (int fd : fds_) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    bool available(counter c) const {
+        return fds_[static_cast<size_t>(c)] >= 0 || c == counter::page_faults;
+    }
+
+    counter_values read() const {
+        counter_values out;
+        for (size_t i = 0; i < counter_count; ++i) {
+            out.values[i] = read_fd(fds_[i]);
+        }
+        if (!out.has(counter::page_faults)) {
+            rusage usage{};
+            if (::getrusage(RUSAGE_THREAD, &usage) == 0) {
+                out[counter::page_faults] = static_cast<double>(usage.ru_minflt + usage.ru_majflt);
+            }
+        }
+        return out;
+    }
+
+private:
+    void open(counter c, uint32_t type, uint64_t config) {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        fds_[static_cast<size_t>(c)] = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    static double read_fd(int fd) {
+        uint64_t data[3]; // value, time enabled, time running
+        if (fd < 0 || ::read(fd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+            return -1;
+        }
+        if (data[2] == 0 && data[1] != 0) {
+            return -1; // enabled but never scheduled on the PMU: no count at all
+        }
+        if (data[2] == data[1]) {
+            return static_cast<double>(data[0]);
+        }
+        return static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+    }
+
+    std::array<int, counter_count> fds_;
+};
+
+// The counters of the thread that runs the benchmarks; threads it starts
+// are not counted.
+inline const perf_counters& counters() {
+    static perf_counters c;
+    return c;
+}
+
+// Adds the counts of its lifetime to out; a counter that is unavailable at
+// either end leaves -1.
+class counter_scope
+{
+public:
+    explicit counter_scope(counter_values& out) : out_(out), start_(counters().read()) {}
+
+    ~counter_scope() {
+        auto end = counters().read();
+        for (size_t i = 0; i < counter_count; ++i) {
+            auto& v = out_.values[i];
+            v = (v < 0 || start_.values[i] < 0 || end.values[i] < 0) ? -1 : v + end.values[i] - start_.values[i];
+        }
+    }
+
+    counter_scope(const counter_scope&) = delete;
+    counter_scope& operator=(const counter_scope&) = delete;
+
+private:
+    counter_values& out_;
+    counter_values start_;
+};
+
+} // namespace bench
@@ -0,0 +1,191 @@
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include "bench.h"
+#include "persistent_vector.h"
+#include "vector.h"
+
+namespace {
+
+size_t counted_bytes = 0;
+
+template<typename T>
+struct counting_allocator : std::allocator<T>
+{
+    template<typename U>
+    struct rebind
+    {
+        using other = counting_allocator<U>;
+    };
+
+    counting_allocator() = default;
+
+    template<typename U>
+    counting_allocator(const counting_allocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        counted_bytes += n * sizeof(T);
+        return std::allocator<T>::allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) noexcept {
+        counted_bytes -= n * sizeof(T);
+        std::allocator<T>::deallocate(p, n);
+    }
+};
+
+dl::vector<uint32_t> random_indices(size_t count, size_t n) {
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<uint32_t> dist(0, static_cast<uint32_t>(n - 1));
+    dl::vector<uint32_t> idx(count);
+    for (auto& i : idx) {
+        i = dist(gen);
+    }
+    return idx;
+}
+
+} // namespace
+
+// Bytes each version adds when every version changes one random element
+// and all versions are kept, as for an undo history.
+BENCH(persistent_vector_version_memory) {
+    size_t versions = 10000;
+    for (size_t n : {size_t(1) << 10, size_t(1) << 16, size_t(1) << 20}) {
+        auto idx = random_indices(versions, n);
+        auto label = "n" + std::to_string(n);
+        counted_bytes = 0;
+        {
+            using pvec = dl::persistent_vector<uint32_t, counting_allocator<uint32_t>>;
+            auto t = pvec().transient();
+            for (size_t i = 0; i < n; ++i) {
+                t.push_back(static_cast<uint32_t>(i));
+            }
+            dl::vector<pvec> history(1, std::move(t).persistent());
+            history.reserve(versions + 1);
+            auto base = counted_bytes;
+            for (size_t v = 0; v < versions; ++v) {
+                history.push_back(history.back().set(idx[v], static_cast<uint32_t>(v)));
+            }
+            state.note(label, "base_bytes", static_cast<double>(base));
+            state.note(label, "persistent_bytes_per_version",
+                       static_cast<double>(counted_bytes - base) / static_cast<double>(versions));
+        }
+        state.note(label, "vector_bytes_per_version", static_cast<double>(n * sizeof(uint32_t)));
+    }
+}
+
+BENCH(persistent_vector_build) {
+    size_t n = bench::large() ? 10000000 : 1000000;
+    state.measure("vector", n, 0, [&] {
+        dl::vector<uint32_t> vec;
+        for (size_t i = 0; i < n; ++i) {
+            vec.push_back(static_cast<uint32_t>(i));
+        }
+        bench::do_not_optimize(vec.data());
+    });
+    state.measure("transient", n, 0, [&] {
+        auto t = dl::persistent_vector<uint32_t>().transient();
+        for (size_t i = 0; i < n; ++i) {
+            t.push_back(static_cast<uint32_t>(i));
+        }
+        bench::do_not_optimize(t.size());
+    });
+    state.measure("transient_std_alloc", n, 0, [&] {
+        auto t = dl::persistent_vector<uint32_t, std::allocator<uint32_t>>().transient();
+        for (size_t i = 0; i < n; ++i) {
+            t.push_back(static_cast<uint32_t>(i));
+        }
+        bench::do_not_optimize(t.size());
+    });
+    state.measure("versions", n, 0, [&] {
+        dl::persistent_vector<uint32_t> vec;
+        for (size_t i = 0; i < n; ++i) {
+            auto next = vec.push_back(static_cast<uint32_t>(i));
+            vec = next;
+        }
+        bench::do_not_optimize(vec.size());
+    });
+}
+
+BENCH(persistent_vector_set) {
+    size_t n = size_t(1) << 20;
+    size_t ops = bench::large() ? 10000000 : 1000000;
+    auto idx = random_indices(ops, n);
+    dl::vector<uint32_t> vec(n, 0);
+    auto t = dl::persistent_vector<uint32_t>().transient();
+    auto ts = dl::persistent_vector<uint32_t, std::allocator<uint32_t>>().transient();
+    for (size_t i = 0; i < n; ++i) {
+        t.push_back(0);
+        ts.push_back(0);
+    }
+    auto base = std::move(t).persistent();
+    auto base_std = std::move(ts).persistent();
+
+    state.measure("vector", ops, 0, [&] {
+        for (size_t i = 0; i < ops; ++i) {
+            vec[idx[i]] = static_cast<uint32_t>(i);
+        }
+        bench::do_not_optimize(vec.data());
+    });
+    // what keeping versions of a dl::vector costs: a full copy per change
+    size_t copies = ops / 1000;
+    state.measure("vector_copy", copies, 0, [&] {
+        auto cur = vec;
+        for (size_t i = 0; i < copies; ++i) {
+            auto next = cur;
+            next[idx[i]] = static_cast<uint32_t>(i);
+            cur.swap(next);
+        }
+        bench::do_not_optimize(cur.data());
+    });
+    state.measure("transient", ops, 0, [&] {
+        auto edit = base.transient();
+        for (size_t i = 0; i < ops; ++i) {
+            edit.set(idx[i], static_cast<uint32_t>(i));
+        }
+        bench::do_not_optimize(edit.size());
+    });
+    state.measure("versions", ops, 0, [&] {
+        auto cur = base;
+        for (size_t i = 0; i < ops; ++i) {
+            auto next = cur.set(idx[i], static_cast<uint32_t>(i));
+            cur = next;
+        }
+        bench::do_not_optimize(cur.size());
+    });
+    state.measure("versions_std_alloc", ops, 0, [&] {
+        auto cur = base_std;
+        for (size_t i = 0; i < ops; ++i) {
+            auto next = cur.set(idx[i], static_cast<uint32_t>(i));
+            cur = next;
+        }
+        bench::do_not_optimize(cur.size());
+    });
+
+    uint64_t sum = 0;
+    state.measure("vector_read", ops, 0, [&] {
+        for (size_t i = 0; i < ops; ++i) {
+            sum += vec[idx[i]];
+        }
+        bench::do_not_optimize(sum);
+    });
+    state.measure("persistent_read", ops, 0, [&] {
+        for (size_t i = 0; i < ops; ++i) {
+            sum += base[idx[i]];
+        }
+        bench::do_not_optimize(sum);
+    });
+    state.measure("vector_scan", n, n * sizeof(uint32_t), [&] {
+        for (auto x : vec) {
+            sum += x;
+        }
+        bench::do_not_optimize(sum);
+    });
+    state.measure("persistent_scan", n, n * sizeof(uint32_t), [&] {
+        for (auto x : base) {
+            sum += x;
+        }
+        bench::do_not_optimize(sum);
+    });
+}
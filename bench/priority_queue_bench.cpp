@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cstdint>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+#include "bench.h"
+#include "priority_queue.h"
+#include "vector.h"
+
+namespace {
+
+dl::vector<uint64_t> random_keys(size_t n) {
+    std::mt19937_64 gen(n);
+    dl::vector<uint64_t> keys(n);
+    for (auto& k : keys) {
+        k = gen();
+    }
+    return keys;
+}
+
+// Pushes n keys, then pops them all; small queues are filled and drained
+// several times so every size does about the same work.
+template<typename Queue>
+void push_pop(bench::state& state, const std::string& label, const dl::vector<uint64_t>& keys, size_t rounds) {
+    state.measure(label + "/push_pop", 2 * rounds * keys.size(), 0, [&] {
+        uint64_t sum = 0;
+        for (size_t r = 0; r < rounds; ++r) {
+            Queue queue;
+            for (auto k : keys) {
+                queue.push(k);
+            }
+            while (!queue.empty()) {
+                sum += queue.top();
+                queue.pop();
+            }
+        }
+        bench::do_not_optimize(sum);
+    });
+}
+
+// The hold model of event simulations: a full min-queue where every step
+// takes the earliest event and schedules a new one a random delay after it.
+template<typename Queue, typename Replace>
+void hold(bench::state& state, const std::string& label, const dl::vector<uint64_t>& keys, size_t steps,
+          Replace replace) {
+    Queue queue;
+    for (auto k : keys) {
+        queue.push(k >> 32);
+    }
+    state.measure(label + "/hold", steps, 0, [&] {
+        uint64_t x = 1;
+        for (size_t s = 0; s < steps; ++s) {
+            x = x * 6364136223846793005ull + 1442695040888963407ull;
+            replace(queue, queue.top() + (x >> 32));
+        }
+        bench::do_not_optimize(queue.top());
+    });
+}
+
+} // namespace
+
+// Throughput against std::priority_queue (a binary heap) from L1-resident
+// to far larger than the LLC. 10M and 100M elements run with --large.
+BENCH(priority_queue) {
+    dl::vector<size_t> sizes{1'000, 100'000, 1'000'000};
+    if (bench::large()) {
+        sizes.push_back(10'000'000);
+        sizes.push_back(100'000'000);
+    }
+    for (auto n : sizes) {
+        auto keys = random_keys(n);
+        auto rounds = std::max<size_t>(1, 1'000'000 / n);
+        auto suffix = "/n" + std::to_string(n);
+
+        push_pop<std::priority_queue<uint64_t>>(state, "std" + suffix, keys, rounds);
+        push_pop<dl::priority_queue<uint64_t, std::less<uint64_t>, 2>>(state, "dl_arity2" + suffix, keys, rounds);
+        push_pop<dl::priority_queue<uint64_t, std::less<uint64_t>, 4>>(state, "dl_arity4" + suffix, keys, rounds);
+        push_pop<dl::priority_queue<uint64_t, std::less<uint64_t>, 8>>(state, "dl_arity8" + suffix, keys, rounds);
+
+        constexpr size_t steps = 1'000'000;
+        auto pop_then_push = [](auto& q, uint64_t v) {
+            q.pop();
+            q.push(v);
+        };
+        auto pop_push = [](auto& q, uint64_t v) { q.pop_push(v); };
+        using min_first = std::greater<uint64_t>;
+        hold<std::priority_queue<uint64_t, std::vector<uint64_t>, min_first>>(state, "std" + suffix, keys, steps,
+                                                                               pop_then_push);
+        hold<dl::priority_queue<uint64_t, min_first, 4>>(state, "dl_arity4" + suffix, keys, steps, pop_then_push);
+        hold<dl::priority_queue<uint64_t, min_first, 4>>(state, "dl_arity4_pop_push" + suffix, keys, steps, pop_push);
+        hold<dl::priority_queue<uint64_t, min_first, 8>>(state, "dl_arity8_pop_push" + suffix, keys, steps, pop_push);
+
+        dl::vector<uint64_t> heap(n);
+        state.measure("std_make_heap" + suffix, rounds * n, 0, [&] {
+            for (size_t r = 0; r < rounds; ++r) {
+                std::copy(keys.begin(), keys.end(), heap.begin());
+                std::make_heap(heap.begin(), heap.end());
+            }
+            bench::do_not_optimize(heap.data());
+        });
+        state.measure("dl_make_dary_heap4" + suffix, rounds * n, 0, [&] {
+            for (size_t r = 0; r < rounds; ++r) {
+                std::copy(keys.begin(), keys.end(), heap.begin());
+                dl::make_dary_heap<4>(heap.begin(), heap.end());
+            }
+            bench::do_not_optimize(heap.data());
+        });
+    }
+}
@@ -0,0 +1,76 @@
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include "bench.h"
+#include "serialize.h"
+#include "vector.h"
+
+BENCH(serialize) {
+    size_t n = (bench::large() ? (size_t(4) << 30) : (size_t(256) << 20)) / sizeof(uint64_t);
+    auto bytes = n * sizeof(uint64_t);
+    std::string path = "/dev/shm/dl_bench_serialize";
+    dl::vector<uint64_t> vec(n);
+    for (size_t i = 0; i < n; ++i) {
+        vec[i] = i;
+    }
+
+    state.measure("ofstream_loop/write", n, bytes, [&] {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        uint64_t count = vec.size();
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        for (auto v : vec) {
+            out.write(reinterpret_cast<const char*>(&v), sizeof(v));
+        }
+    });
+    state.measure("ifstream_loop/read", n, bytes, [&] {
+        std::ifstream in(path, std::ios::binary);
+        uint64_t count = 0;
+        in.read(reinterpret_cast<char*>(&count), sizeof(count));
+        dl::vector<uint64_t> res;
+        res.reserve(count);
+        for (uint64_t v; count-- != 0 && in.read(reinterpret_cast<char*>(&v), sizeof(v));) {
+            res.push_back(v);
+        }
+        bench::do_not_optimize(res.data());
+    });
+
+    state.measure("dl/write", n, bytes, [&] {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        dl::write(fd, vec);
+        ::close(fd);
+    });
+    state.measure("dl/read", n, bytes, [&] {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        dl::vector<uint64_t> res;
+        dl::read(fd, res);
+        ::close(fd);
+        bench::do_not_optimize(res.data());
+    });
+
+    const size_t chunk = size_t(1) << 16;
+    state.measure("dl/stream_write", n, bytes, [&] {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        dl::vector_writer<uint64_t> writer(fd);
+        for (size_t i = 0; i < n; i += chunk) {
+            writer.write(vec.data() + i, std::min(chunk, n - i));
+        }
+        writer.finish();
+        ::close(fd);
+    });
+    state.measure("dl/stream_read", n, bytes, [&] {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        dl::vector_reader<uint64_t> reader(fd);
+        dl::vector<uint64_t> buf;
+        uint64_t sum = 0;
+        while (reader.next(buf)) {
+            sum += buf.back();
+        }
+        ::close(fd);
+        bench::do_not_optimize(sum);
+    });
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include "bench.h"
+#include "sort.h"
+#include "thread_pool.h"
+#include "vector.h"
+
+template<typename T>
+static dl::vector<T> random_input(size_t n) {
+    std::mt19937_64 gen(n);
+    dl::vector<T> vec(n);
+    for (auto& v : vec) {
+        v = static_cast<T>(gen());
+    }
+    return vec;
+}
+
+template<typename T>
+static void sort_cases(bench::state& state, const std::string& type) {
+    size_t n = bench::large() ? 100'000'000 : 10'000'000;
+    auto input = random_input<T>(n);
+    dl::vector<T> vec(n);
+    auto bytes = n * sizeof(T);
+
+    state.measure(type + "/std_sort", n, bytes, [&] {
+        std::copy(input.begin(), input.end(), vec.begin());
+        std::sort(vec.begin(), vec.end());
+    });
+    for (unsigned bits : {8u, 11u, 16u}) {
+        state.measure(type + "/radix" + std::to_string(bits), n, bytes, [&] {
+            std::copy(input.begin(), input.end(), vec.begin());
+            dl::radix_sort(vec, dl::identity_key(), bits);
+        });
+    }
+    for (size_t threads : {1, 4, 16, 64}) {
+        dl::thread_pool pool(threads);
+        state.measure(type + "/parallel_sort/t" + std::to_string(threads), n, bytes, [&] {
+            std::copy(input.begin(), input.end(), vec.begin());
+            dl::parallel_sort(vec, std::less<>(), pool);
+        });
+    }
+}
+
+BENCH(sort_u32) {
+    sort_cases<uint32_t>(state, "u32");
+}
+
+BENCH(sort_u64) {
+    sort_cases<uint64_t>(state, "u64");
+}
+
+BENCH(sort_key_value) {
+    using kv = std::pair<uint64_t, uint64_t>;
+    size_t n = bench::large() ? 100'000'000 : 10'000'000;
+    std::mt19937_64 gen(3);
+    dl::vector<kv> input;
+    input.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        input.push_back({gen(), i});
+    }
+    dl::vector<kv> vec(input);
+    auto by_key = [](const kv& a, const kv& b) { return a.first < b.first; };
+
+    state.measure("std_sort", n, n * sizeof(kv), [&] {
+        std::copy(input.begin(), input.end(), vec.begin());
+        std::sort(vec.begin(), vec.end(), by_key);
+    });
+    state.measure("radix11", n, n * sizeof(kv), [&] {
+        std::copy(input.begin(), input.end(), vec.begin());
+        dl::radix_sort(vec, [](const kv& p) { return p.first; }, 11);
+    });
+    for (size_t threads : {1, 4, 16, 64}) {
+        dl::thread_pool pool(threads);
+        state.measure("parallel_sort/t" + std::to_string(threads), n, n * sizeof(kv), [&] {
+            std::copy(input.begin(), input.end(), vec.begin());
+            dl::parallel_sort(vec, by_key, pool);
+        });
+    }
+}
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include "bench.h"
+#include "stream_copy.h"
+#include "vector.h"
+
+namespace {
+
+// A cache-sensitive tenant: a pointer chase through a working set that
+// fits in the LLC. Walking it right after a copy shows how much of it the
+// copy evicted.
+class tenant
+{
+public:
+    explicit tenant(size_t bytes) : next_(bytes / sizeof(uint32_t)) {
+        dl::vector<uint32_t> order(next_.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), std::mt19937(11));
+        for (size_t i = 0; i < order.size(); ++i) {
+            next_[order[i]] = order[(i + 1) % order.size()];
+        }
+    }
+
+    // One pass over the working set; returns ns per access.
+    double walk() {
+        auto start = bench::state::clock::now();
+        uint32_t i = 0;
+        for (size_t k = 0; k < next_.size(); ++k) {
+            i = next_[i];
+        }
+        bench::do_not_optimize(i);
+        return std::chrono::duration<double, std::nano>(bench::state::clock::now() - start).count()
+               / static_cast<double>(next_.size());
+    }
+
+    size_t size() const noexcept { return next_.size(); }
+
+private:
+    dl::vector<uint32_t> next_;
+};
+
+// Copies with the tenant's working set warm, then reports the tenant's
+// latency and LLC misses on its next pass.
+template<typename Copy>
+void copy_next_to(bench::state& state, tenant& t, const std::string& label, size_t bytes, Copy&& copy) {
+    bench::counter_values tenant;
+    double ns = 0;
+    size_t reps = std::max<size_t>(bench::opts().reps, 1);
+    state.measure(label, 0, bytes, [&] {
+        t.walk();
+        t.walk();
+        copy();
+        bench::counter_scope scope(tenant);
+        ns += t.walk();
+    });
+    auto misses = tenant[bench::counter::llc_misses];
+    state.note(label, "tenant_ns_per_access", ns / static_cast<double>(reps));
+    state.note(label, "tenant_llc_misses_per_1k",
+               misses < 0 ? -1.0 : misses * 1e3 / static_cast<double>(t.size() * reps));
+}
+
+} // namespace
+
+// A multi-GB copy next to a tenant whose working set lives in the LLC; the
+// timed runs include two tenant passes. "none" is the tenant on its own.
+// tenant_llc_misses_per_1k prints -1 where hardware counters are not
+// available.
+BENCH(stream_copy_tenant) {
+    size_t bytes = bench::large() ? (size_t(2) << 30) : (size_t(256) << 20);
+    dl::vector<char> src(bytes, 1);
+    dl::vector<char> dst(bytes, 0);
+    tenant t(size_t(1) << 20);
+
+    copy_next_to(state, t, "none", 0, [] {});
+    copy_next_to(state, t, "memcpy", bytes, [&] {
+        std::memcpy(dst.data(), src.data(), bytes);
+    });
+    copy_next_to(state, t, "stream_copy", bytes, [&] {
+        dl::stream_copy(dst.data(), src.data(), bytes);
+    });
+
+    // the vector paths that take it, with and without streaming
+    dl::vector<uint64_t> vec(bytes / sizeof(uint64_t), 1);
+    dl::vector<uint64_t> copy;
+    for (bool streaming : {false, true}) {
+        dl::set_stream_copy_threshold(streaming ? dl::default_stream_copy_threshold() : ~size_t(0));
+        std::string suffix = streaming ? "/stream" : "/regular";
+        copy_next_to(state, t, "vector_copy" + suffix, bytes, [&] {
+            copy = dl::vector<uint64_t>();
+            copy = vec;
+        });
+        copy_next_to(state, t, "vector_grow" + suffix, bytes, [&] {
+            copy.push_back(0);
+            copy.pop_back();
+            copy.shrink_to_fit();
+        });
+    }
+    dl::set_stream_copy_threshold(~size_t(0));
+}
@@ -0,0 +1,41 @@
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include "bench.h"
+#include "tcache_allocator.h"
+#include "vector.h"
+
+// Every thread repeatedly builds vectors of random length by push_back, so
+// each one walks the doubling capacities and frees the previous buffers.
+template<typename Alloc>
+static void build(bench::state& state, const std::string& label, size_t threads, size_t vectors) {
+    state.measure(label, threads * vectors, 0, [&] {
+        dl::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([t, vectors] {
+                std::mt19937 gen(static_cast<unsigned>(t));
+                std::uniform_int_distribution<uint32_t> len(1, 2000);
+                for (size_t v = 0; v < vectors; ++v) {
+                    dl::vector<uint64_t, Alloc> vec;
+                    for (uint32_t i = 0, n = len(gen); i < n; ++i) {
+                        vec.push_back(i);
+                    }
+                    bench::do_not_optimize(vec.data());
+                }
+            });
+        }
+        for (auto& w : workers) {
+            w.join();
+        }
+    });
+}
+
+BENCH(tcache_vector_build) {
+    size_t vectors = bench::large() ? 200000 : 20000;
+    for (size_t threads = 1; threads <= 2 * std::thread::hardware_concurrency(); threads *= 2) {
+        auto t = "/t" + std::to_string(threads);
+        build<std::allocator<uint64_t>>(state, "malloc" + t, threads, vectors);
+        build<dl::tcache_allocator<uint64_t>>(state, "tcache" + t, threads, vectors);
+    }
+}
@@ -0,0 +1,184 @@
+#include <cstdint>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "bench.h"
+#include "execution.h"
+#include "thread_pool.h"
+#include "vector.h"
+
+BENCH(vector_parallel_fill) {
+    size_t n = bench::large() ? (size_t(5) << 30) : (size_t(1) << 26);
+    auto bytes = n * sizeof(uint32_t);
+
+    state.measure("serial/ctor", n, bytes, [&] {
+        dl::vector<uint32_t> vec(n, 1);
+        bench::do_not_optimize(vec.data());
+    });
+    dl::vector<uint32_t> src(n, 1);
+    state.measure("serial/copy", n, bytes, [&] {
+        dl::vector<uint32_t> vec(src);
+        bench::do_not_optimize(vec.data());
+    });
+
+    for (size_t threads = 1; threads <= 2 * std::thread::hardware_concurrency(); threads *= 2) {
+        dl::thread_pool pool(threads);
+        auto policy = dl::par.on(pool);
+        auto t = "/t" + std::to_string(threads);
+        state.measure("par/ctor" + t, n, bytes, [&] {
+            dl::vector<uint32_t> vec(policy, n, 1);
+            bench::do_not_optimize(vec.data());
+        });
+        state.measure("par/copy" + t, n, bytes, [&] {
+            dl::vector<uint32_t> vec(policy, src);
+            bench::do_not_optimize(vec.data());
+        });
+        state.measure("par/resize" + t, n, bytes, [&] {
+            dl::vector<uint32_t> vec;
+            vec.resize(policy, n);
+            bench::do_not_optimize(vec.data());
+        });
+        dl::vector<uint32_t> vec(policy, n, 0);
+        state.measure("par/assign" + t, n, bytes, [&] {
+            vec.assign(policy, n, 2);
+            bench::do_not_optimize(vec.data());
+        });
+    }
+}
+
+static std::string number_text(size_t n) {
+    std::string text;
+    for (size_t i = 0; i < n; ++i) {
+        text += std::to_string(i % 1000);
+        text += ' ';
+    }
+    return text;
+}
+
+BENCH(vector_input_iterator) {
+    size_t n = bench::large() ? 10'000'000 : 1'000'000;
+    auto text = number_text(n);
+    using iter = std::istream_iterator<uint32_t>;
+
+    state.measure("ctor/iterator_pair", n, 0, [&] {
+        std::istringstream in(text);
+        dl::vector<uint32_t> vec(iter(in), iter{});
+        bench::do_not_optimize(vec.data());
+    });
+    state.measure("ctor/from_range_hint", n, 0, [&] {
+        std::istringstream in(text);
+        dl::vector<uint32_t> vec(dl::from_range, dl::hinted(iter(in), iter{}, n));
+        bench::do_not_optimize(vec.data());
+    });
+
+    dl::vector<uint32_t> base(n, 1);
+    state.measure("insert_middle/iterator_pair", n, 0, [&] {
+        dl::vector<uint32_t> vec(base);
+        std::istringstream in(text);
+        vec.insert(vec.begin() + n / 2, iter(in), iter{});
+        bench::do_not_optimize(vec.data());
+    });
+    state.measure("insert_middle/insert_range_hint", n, 0, [&] {
+        dl::vector<uint32_t> vec(base);
+        std::istringstream in(text);
+        vec.insert_range(vec.begin() + n / 2, dl::hinted(iter(in), iter{}, n));
+        bench::do_not_optimize(vec.data());
+    });
+}
+
+// Build with -O3 -fopt-info-vec-optimized (gcc) or -Rpass=loop-vectorize (clang)
+// to see which of the producing loops below get vectorized.
+BENCH(vector_batch_append) {
+    size_t n = bench::large() ? (size_t(1) << 28) : (size_t(1) << 24);
+    auto bytes = n * sizeof(uint32_t);
+
+    state.measure("emplace_back", n, bytes, [&] {
+        dl::vector<uint32_t> vec;
+        vec.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            vec.emplace_back(static_cast<uint32_t>(i * 3 + 1));
+        }
+        bench::do_not_optimize(vec.data());
+    });
+    state.measure("emplace_back_unchecked", n, bytes, [&] {
+        dl::vector<uint32_t> vec;
+        vec.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            vec.emplace_back_unchecked(static_cast<uint32_t>(i * 3 + 1));
+        }
+        bench::do_not_optimize(vec.data());
+    });
+    state.measure("appender", n, bytes, [&] {
+        dl::vector<uint32_t> vec;
+        dl::vector<uint32_t>::appender app(vec);
+        app.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            app.emplace_back_unchecked(static_cast<uint32_t>(i * 3 + 1));
+        }
+        app.commit();
+        bench::do_not_optimize(vec.data());
+    });
+    state.measure("append_n", n, bytes, [&] {
+        dl::vector<uint32_t> vec;
+        vec.append_n(n, [](size_t i) { return static_cast<uint32_t>(i * 3 + 1); });
+        bench::do_not_optimize(vec.data());
+    });
+}
+
+// Many long-lived vectors, each spiking to a large size once in a while and
+// draining back to a small working set; RSS is sampled after every cycle.
+template<typename Vector>
+void sawtooth(bench::state& state, const std::string& label) {
+    size_t vectors = 64;
+    size_t spike = bench::large() ? (size_t(1) << 22) : (size_t(1) << 19);
+    size_t cycles = bench::large() ? 2000 : 200;
+    auto base = static_cast<double>(bench::rss_bytes());
+    auto rss = [&] { return static_cast<double>(bench::rss_bytes()) - base; };
+    double peak = 0;
+    double steady = 0;
+
+    dl::vector<Vector> pool(vectors);
+    state.measure(label, cycles * spike, 0, [&] {
+        for (size_t c = 0; c < cycles; ++c) {
+            auto& vec = pool[(c * 7) % vectors];
+            vec.append_n(spike, [](size_t i) { return static_cast<uint64_t>(i); });
+            peak = std::max(peak, rss());
+            while (vec.size() > 64) {
+                vec.erase(vec.end() - std::min<size_t>(vec.size() - 64, 4096), vec.end());
+            }
+            steady += rss();
+        }
+    });
+    state.note(label, "peak_rss_mb", peak / 1e6);
+    state.note(label, "avg_rss_after_drain_mb", steady / static_cast<double>(cycles * std::max<size_t>(bench::opts().reps, 1)) / 1e6);
+}
+
+BENCH(vector_shrink_sawtooth) {
+    sawtooth<dl::vector<uint64_t>>(state, "no_shrink");
+    sawtooth<dl::vector<uint64_t, std::allocator<uint64_t>, dl::fraction_shrink<>>>(state, "fraction_shrink");
+}
+
+// A large value-initialized vector of which only one element per 64 KiB is
+// ever written, as for a sparse histogram or a lookup table indexed by id.
+template<typename Vector>
+static void sparse(bench::state& state, const std::string& label, size_t n) {
+    constexpr size_t stride = (size_t(64) << 10) / sizeof(uint64_t);
+    size_t rss = 0;
+    state.measure(label, n, 0, [&] {
+        Vector vec(n);
+        for (size_t i = 0; i < n; i += stride) {
+            vec[i] += i;
+        }
+        rss = bench::rss_bytes();
+        bench::do_not_optimize(vec.data());
+    });
+    state.note(label, "rss_mb", static_cast<double>(rss) / 1e6);
+}
+
+BENCH(vector_sparse_value_init) {
+    // 8 GiB needs that much memory for std_allocator, which zeroes every page
+    size_t n = (bench::large() ? (size_t(8) << 30) : (size_t(1) << 30)) / sizeof(uint64_t);
+    sparse<dl::vector<uint64_t>>(state, "std_allocator", n);
+    sparse<dl::vector<uint64_t, dl::zeroing_allocator<uint64_t>>>(state, "zeroing_allocator", n);
+}
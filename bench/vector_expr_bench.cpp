@@ -0,0 +1,114 @@
+#include <random>
+#include <string>
+#include "bench.h"
+#include "vector.h"
+#include "vector_expr.h"
+
+namespace {
+
+dl::vector<float> random_floats(size_t n, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    dl::vector<float> out(n);
+    for (auto& x : out) {
+        x = dist(gen);
+    }
+    return out;
+}
+
+// What the code looked like before: every operation produces a vector.
+dl::vector<float> mul(const dl::vector<float>& a, const dl::vector<float>& b) {
+    dl::vector<float> out(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        out[i] = a[i] * b[i];
+    }
+    return out;
+}
+
+dl::vector<float> add(const dl::vector<float>& a, const dl::vector<float>& b) {
+    dl::vector<float> out(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        out[i] = a[i] + b[i];
+    }
+    return out;
+}
+
+} // namespace
+
+BENCH(vector_expr) {
+    for (size_t n : {size_t(1) << 16, bench::large() ? size_t(1) << 26 : size_t(1) << 23}) {
+        auto a = random_floats(n, 1);
+        auto b = random_floats(n, 2);
+        auto d = random_floats(n, 3);
+        dl::vector<float> c(n);
+        auto rounds = (size_t(1) << 27) / n;
+        auto label = [&](const char* what) { return std::string(what) + "/n" + std::to_string(n); };
+        auto bytes = rounds * n * sizeof(float) * 4;
+
+        state.measure(label("fma_temporaries"), rounds * n, bytes, [&] {
+            for (size_t r = 0; r < rounds; ++r) {
+                c = add(mul(a, b), d);
+                bench::do_not_optimize(c.data());
+            }
+        });
+        state.measure(label("fma_loop"), rounds * n, bytes, [&] {
+            for (size_t r = 0; r < rounds; ++r) {
+                for (size_t i = 0; i < n; ++i) {
+                    c[i] = a[i] * b[i] + d[i];
+                }
+                bench::do_not_optimize(c.data());
+            }
+        });
+        state.measure(label("fma_expr"), rounds * n, bytes, [&] {
+            for (size_t r = 0; r < rounds; ++r) {
+                c = a * b + d;
+                bench::do_not_optimize(c.data());
+            }
+        });
+
+        float dot = 0;
+        state.measure(label("dot_temporaries"), rounds * n, 0, [&] {
+            for (size_t r = 0; r < rounds; ++r) {
+                auto p = mul(a, b);
+                float s = 0;
+                for (auto x : p) {
+                    s += x;
+                }
+                dot += s;
+            }
+            bench::do_not_optimize(dot);
+        });
+        state.measure(label("dot_loop"), rounds * n, 0, [&] {
+            for (size_t r = 0; r < rounds; ++r) {
+                float s = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    s += a[i] * b[i];
+                }
+                dot += s;
+            }
+            bench::do_not_optimize(dot);
+        });
+        state.measure(label("dot_expr"), rounds * n, 0, [&] {
+            for (size_t r = 0; r < rounds; ++r) {
+                dot += dl::sum(a * b);
+            }
+            bench::do_not_optimize(dot);
+        });
+
+        size_t hits = 0;
+        state.measure(label("count_loop"), rounds * n, 0, [&] {
+            for (size_t r = 0; r < rounds; ++r) {
+                for (size_t i = 0; i < n; ++i) {
+                    hits += a[i] < b[i] * 0.5f;
+                }
+            }
+            bench::do_not_optimize(hits);
+        });
+        state.measure(label("count_expr"), rounds * n, 0, [&] {
+            for (size_t r = 0; r < rounds; ++r) {
+                hits += dl::count(dl::lazy(a) < b * 0.5f);
+            }
+            bench::do_not_optimize(hits);
+        });
+    }
+}
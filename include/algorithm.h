@@ -1,10 +1,65 @@
 #pragma once
+#include <cstddef>
 #include <memory>
+#include <type_traits>
 
 namespace dl {
 
+template<typename A, typename T, typename = void>
+struct has_construct_member : std::false_type {};
+
+template<typename A, typename T>
+struct has_construct_member<A, T, std::void_t<decltype(std::declval<A&>().construct(std::declval<T*>(),
+                                                                                  std::declval<const T&>()))>>
+    : std::true_type {};
+
+template<typename A>
+struct is_std_allocator : std::false_type {};
+
+template<typename T>
+struct is_std_allocator<std::allocator<T>> : std::true_type {};
+
+// Copying [I, I + n) to uninitialized O may be done bytewise: both are raw
+// pointers to the same trivially copyable type and the allocator constructs
+// with placement new.
+template<typename Allocator, typename I, typename O>
+inline constexpr bool is_bitwise_copy_v = [] {
+    if constexpr (std::is_pointer_v<I> && std::is_pointer_v<O>) {
+        using T = std::remove_pointer_t<O>;
+        return std::is_same_v<std::remove_cv_t<std::remove_pointer_t<I>>, T> && std::is_trivially_copyable_v<T>
+               && (is_std_allocator<Allocator>::value || !has_construct_member<Allocator, T>::value);
+    }
+    return false;
+}();
+
+// Bytewise copies of at least min_bytes go through copy. Unset by default;
+// stream_copy.h installs its cache-bypassing kernel here. Read without
+// synchronization, so set it before other threads use vectors.
+struct large_copy_hook
+{
+    void (*copy)(void* dst, const void* src, size_t bytes) noexcept = nullptr;
+    size_t min_bytes = ~size_t(0);
+};
+
+inline large_copy_hook large_copy;
+
+template<typename I, typename O, typename Allocator>
+bool try_large_copy(I begin, I end, O res) noexcept {
+    if constexpr (is_bitwise_copy_v<Allocator, I, O>) {
+        auto bytes = static_cast<size_t>(end - begin) * sizeof(*res);
+        if (bytes >= large_copy.min_bytes) {
+            large_copy.copy(res, begin, bytes);
+            return true;
+        }
+    }
+    return false;
+}
+
 template<typename I, typename O, typename Allocator>
 O uninit_move(Allocator& alloc, I begin, I end, O res) {
+    if (try_large_copy<I, O, Allocator>(begin, end, res)) {
+        return res + (end - begin);
+    }
     for (; begin != end; ++begin, ++res) {
         std::allocator_traits<Allocator>::construct(alloc, res, std::move_if_noexcept(*begin));
     }
@@ -13,6 +68,9 @@ O uninit_move(Allocator& alloc, I begin, I end, O res) {
 
 template<typename I, typename O, typename Allocator>
 O uninit_copy(Allocator& alloc, I begin, I end, O res) {
+    if (try_large_copy<I, O, Allocator>(begin, end, res)) {
+        return res + (end - begin);
+    }
     for (; begin != end; ++begin, ++res) {
         std::allocator_traits<Allocator>::construct(alloc, res, *begin);
     }
@@ -0,0 +1,870 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "compressed_pair.h"
+#include "type_utils.h"
+#include "vector.h"
+
+namespace dl {
+
+// SSE2 kernels for char strings. Past simd_libc_threshold bytes memchr and
+// memcmp win: libc picks AVX2 or wider at runtime. Up to 32 bytes are read
+// as two whole blocks and masked if that stays within the page, as libc
+// does; the read may pass the end of the allocation, so the kernels are not
+// instrumented by AddressSanitizer.
+constexpr size_t simd_libc_threshold = 64;
+
+#if defined(__SSE2__)
+inline bool simd_in_page(const char* p, size_t bytes) noexcept {
+    return (reinterpret_cast<uintptr_t>(p) & 4095) <= 4096 - bytes;
+}
+
+// Bit i set where byte i of the 32 at p equals the needle (or q[i]).
+__attribute__((no_sanitize_address))
+inline uint64_t simd_eq_mask32(const char* p, __m128i needle) noexcept {
+    auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+    return static_cast<uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(lo, needle))))
+         | static_cast<uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(hi, needle)))) << 16;
+}
+
+__attribute__((no_sanitize_address))
+inline uint64_t simd_eq_mask32(const char* p, const char* q) noexcept {
+    auto lo = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(q)));
+    auto hi = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16)),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + 16)));
+    return static_cast<uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(lo)))
+         | static_cast<uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(hi))) << 16;
+}
+#endif
+
+__attribute__((no_sanitize_address))
+inline const char* simd_find(const char* s, size_t n, char c) noexcept {
+#if defined(__SSE2__)
+    if (n >= simd_libc_threshold) {
+        return static_cast<const char*>(std::memchr(s, c, n));
+    }
+    auto needle = _mm_set1_epi8(c);
+    if (n <= 32 && simd_in_page(s, 32)) {
+        auto m = simd_eq_mask32(s, needle) & ((uint64_t(1) << n) - 1);
+        return m != 0 ? s + __builtin_ctzll(m) : nullptr;
+    }
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        if (auto m = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle))) {
+            return s + i + __builtin_ctz(static_cast<unsigned>(m));
+        }
+    }
+    for (; i < n; ++i) {
+        if (s[i] == c) {
+            return s + i;
+        }
+    }
+    return nullptr;
+#else
+    return static_cast<const char*>(std::memchr(s, c, n));
+#endif
+}
+
+// Compares the first and the last character of the needle at 16 positions
+// at once and verifies the candidates with memcmp.
+inline const char* simd_find(const char* s, size_t n, const char* needle, size_t k) noexcept {
+    if (k == 0) {
+        return s;
+    }
+    if (k > n) {
+        return nullptr;
+    }
+    if (k == 1) {
+        return simd_find(s, n, needle[0]);
+    }
+    size_t i = 0;
+#if defined(__SSE2__)
+    auto first = _mm_set1_epi8(needle[0]);
+    auto last = _mm_set1_epi8(needle[k - 1]);
+    for (; i + k + 15 <= n; i += 16) {
+        auto block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+        auto block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + k - 1));
+        auto eq = _mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last));
+        for (auto m = static_cast<unsigned>(_mm_movemask_epi8(eq)); m != 0; m &= m - 1) {
+            auto pos = i + __builtin_ctz(m);
+            if (std::memcmp(s + pos + 1, needle + 1, k - 2) == 0) {
+                return s + pos;
+            }
+        }
+    }
+#endif
+    for (; i + k <= n; ++i) {
+        if (s[i] == needle[0] && std::memcmp(s + i + 1, needle + 1, k - 1) == 0) {
+            return s + i;
+        }
+    }
+    return nullptr;
+}
+
+// Sign of the first differing byte, compared as unsigned char.
+__attribute__((no_sanitize_address))
+inline int simd_compare(const char* a, const char* b, size_t n) noexcept {
+    size_t i = 0;
+#if defined(__SSE2__)
+    if (n >= simd_libc_threshold) {
+        return std::memcmp(a, b, n);
+    }
+    auto differ = [&](size_t at) {
+        return static_cast<unsigned char>(a[at]) < static_cast<unsigned char>(b[at]) ? -1 : 1;
+    };
+    if (n <= 32 && simd_in_page(a, 32) && simd_in_page(b, 32)) {
+        auto m = ~simd_eq_mask32(a, b) & ((uint64_t(1) << n) - 1);
+        return m != 0 ? differ(__builtin_ctzll(m)) : 0;
+    }
+    for (; i + 16 <= n; i += 16) {
+        auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        auto y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        auto m = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)));
+        if (m != 0xFFFF) {
+            return differ(i + __builtin_ctz(~m));
+        }
+    }
+#endif
+    return n == i ? 0 : std::memcmp(a + i, b + i, n - i);
+}
+
+// String with up to 23 chars (24 / sizeof(CharT) - 1 in general) stored
+// inline. Both layouts take 24 bytes: a long string is {data, size,
+// capacity} with the top bit of the capacity set; a short one keeps
+// 23 - size in its last character, which is 0 and thus the terminator at
+// full length. Heap buffers grow like dl::vector and can be moved to and
+// from a vector<CharT, Allocator> without copying.
+template<typename CharT, typename Traits = std::char_traits<CharT>, typename Allocator = std::allocator<CharT>>
+class basic_string
+{
+public: // aliases
+    using traits_type = Traits;
+    using value_type = CharT;
+    using allocator_type = Allocator;
+    using allocator_traits = std::allocator_traits<allocator_type>;
+    using pointer = typename allocator_traits::pointer;
+    using const_pointer = typename allocator_traits::const_pointer;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    using view_type = std::basic_string_view<CharT, Traits>;
+    using vector_type = vector<CharT, Allocator>;
+
+    static constexpr size_type npos = size_type(-1);
+
+private:
+    struct long_rep
+    {
+        CharT* data;
+        size_type size;
+        size_type cap;
+    };
+
+public:
+    static constexpr size_type sso_capacity = sizeof(long_rep) / sizeof(CharT) - 1;
+
+    static_assert(std::is_same_v<CharT, typename Traits::char_type>);
+    static_assert(std::is_trivial_v<CharT> && std::is_standard_layout_v<CharT>);
+    static_assert(std::is_same_v<pointer, CharT*>, "fancy pointers are not supported");
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the long flag is the last byte's top bit");
+
+public: // constructors
+    basic_string() noexcept(noexcept(allocator_type()))
+        : basic_string(allocator_type()) {}
+
+    explicit basic_string(const allocator_type& a) noexcept
+        : rep_allocator_(rep(), a) {
+        set_short_size(0);
+    }
+
+    basic_string(const CharT* s, size_type n, const allocator_type& a = allocator_type())
+        : basic_string(a) {
+        init(s, n);
+    }
+
+    basic_string(const CharT* s, const allocator_type& a = allocator_type())
+        : basic_string(s, traits_type::length(s), a) {}
+
+    basic_string(size_type n, CharT c, const allocator_type& a = allocator_type())
+        : basic_string(a) {
+        append(n, c);
+    }
+
+    explicit basic_string(view_type v, const allocator_type& a = allocator_type())
+        : basic_string(v.data(), v.size(), a) {}
+
+    template<typename I, typename = std::enable_if_t<is_input_iter<I>::value>>
+    basic_string(I first, I last, const allocator_type& a = allocator_type())
+        : basic_string(a) {
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+    basic_string(std::initializer_list<CharT> list, const allocator_type& a = allocator_type())
+        : basic_string(list.begin(), list.size(), a) {}
+
+    basic_string(const basic_string& other)
+        : basic_string(other.data(), other.size(),
+                       allocator_traits::select_on_container_copy_construction(other.alloc())) {}
+
+    basic_string(const basic_string& other, const allocator_type& a)
+        : basic_string(other.data(), other.size(), a) {}
+
+    basic_string(basic_string&& other) noexcept
+        : rep_allocator_(other.rep_ref(), other.alloc()) {
+        other.set_short_size(0);
+    }
+
+    basic_string(basic_string&& other, const allocator_type& a)
+        : basic_string(a) {
+        if (other.alloc() == a) {
+            rep_ref() = other.rep_ref();
+            other.set_short_size(0);
+        } else {
+            init(other.data(), other.size());
+        }
+    }
+
+    // Takes over the vector's buffer; one more slot is needed for the
+    // terminator, so a vector without spare capacity grows once first.
+    explicit basic_string(vector_type&& vec)
+        : basic_string(vec.get_allocator()) {
+        if (vec.capacity() == 0) {
+            return;
+        }
+        if (vec.size() == vec.capacity()) {
+            vec.reserve(std::max(vec.size() + 1, vec.capacity() * 2));
+        }
+        auto buff = vec.release();
+        auto& l = rep_ref().l;
+        l.data = buff.data;
+        l.size = buff.size;
+        l.cap = (buff.capacity - 1) | long_flag;
+        l.data[l.size] = CharT();
+    }
+
+    basic_string& operator=(const basic_string& other) {
+        if (this != &other) {
+            if constexpr (allocator_traits::propagate_on_container_copy_assignment::value) {
+                if (alloc() != other.alloc()) {
+                    release_buffer();
+                }
+                alloc() = other.alloc();
+            }
+            assign(other.data(), other.size());
+        }
+        return *this;
+    }
+
+    basic_string& operator=(basic_string&& other) noexcept(allocator_traits::propagate_on_container_move_assignment::value
+                                                           || allocator_traits::is_always_equal::value) {
+        if (this == &other) {
+            return *this;
+        }
+        if constexpr (allocator_traits::propagate_on_container_move_assignment::value) {
+            release_buffer();
+            alloc() = std::move(other.alloc());
+            steal(other);
+        } else if (allocator_traits::is_always_equal::value || alloc() == other.alloc()) {
+            release_buffer();
+            steal(other);
+        } else {
+            assign(other.data(), other.size());
+        }
+        return *this;
+    }
+
+    basic_string& operator=(const CharT* s) { return assign(s, traits_type::length(s)); }
+    basic_string& operator=(view_type v)    { return assign(v.data(), v.size()); }
+    basic_string& operator=(CharT c)        { return assign(&c, 1); }
+
+    ~basic_string() {
+        release_buffer();
+    }
+
+public: // access members
+    const CharT* data() const noexcept  { return is_long() ? rep_ref().l.data : rep_ref().s; }
+    CharT* data() noexcept              { return is_long() ? rep_ref().l.data : rep_ref().s; }
+    const CharT* c_str() const noexcept { return data(); }
+
+    iterator begin() noexcept { return data(); }
+    iterator end() noexcept   { return data() + size(); }
+
+    const_iterator begin() const noexcept  { return data(); }
+    const_iterator end() const noexcept    { return data() + size(); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept   { return end(); }
+
+    reverse_iterator rbegin() noexcept             { return reverse_iterator(end()); }
+    reverse_iterator rend() noexcept               { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const noexcept   { return const_reverse_iterator(begin()); }
+
+    const_reference operator[](size_type i) const noexcept { return data()[i]; }
+    reference operator[](size_type i) noexcept             { return data()[i]; }
+
+    const_reference at(size_type i) const {
+        if (i >= size())
+            throw std::out_of_range("basic_string: index out of bounds");
+        return data()[i];
+    }
+
+    reference at(size_type i) {
+        if (i >= size())
+            throw std::out_of_range("basic_string: index out of bounds");
+        return data()[i];
+    }
+
+    reference front() noexcept             { return data()[0]; }
+    const_reference front() const noexcept { return data()[0]; }
+    reference back() noexcept              { return data()[size() - 1]; }
+    const_reference back() const noexcept  { return data()[size() - 1]; }
+
+    size_type size() const noexcept {
+        return is_long() ? rep_ref().l.size : sso_capacity - static_cast<size_type>(rep_ref().s[sso_capacity]);
+    }
+
+    size_type length() const noexcept { return size(); }
+
+    size_type capacity() const noexcept {
+        return is_long() ? rep_ref().l.cap & ~long_flag : sso_capacity;
+    }
+
+    size_type max_size() const noexcept { return (long_flag - 1) / 2; }
+
+    bool empty() const noexcept { return size() == 0; }
+
+    // Whether the characters are stored inline.
+    bool is_small() const noexcept { return !is_long(); }
+
+    allocator_type get_allocator() const noexcept { return alloc(); }
+
+    operator view_type() const noexcept { return view_type(data(), size()); }
+
+    // Hands the buffer to a vector (the terminator slot becomes spare
+    // capacity); short strings are copied. Leaves the string empty.
+    vector_type to_vector() && {
+        vector_type vec(alloc());
+        if (is_long()) {
+            auto& l = rep_ref().l;
+            vec.adopt(l.data, l.size, (l.cap & ~long_flag) + 1);
+            set_short_size(0);
+        } else {
+            vec.assign(begin(), end());
+        }
+        return vec;
+    }
+
+public: // search and compare
+    size_type find(CharT c, size_type pos = 0) const noexcept {
+        auto n = size();
+        if (pos >= n) {
+            return npos;
+        }
+        auto p = data();
+        const CharT* r;
+        if constexpr (is_char()) {
+            r = simd_find(p + pos, n - pos, c);
+        } else {
+            r = traits_type::find(p + pos, n - pos, c);
+        }
+        return r == nullptr ? npos : static_cast<size_type>(r - p);
+    }
+
+    size_type find(view_type v, size_type pos = 0) const noexcept {
+        auto n = size();
+        if (pos > n) {
+            return npos;
+        }
+        auto p = data();
+        const CharT* r = nullptr;
+        if constexpr (is_char()) {
+            r = simd_find(p + pos, n - pos, v.data(), v.size());
+        } else {
+            auto i = view_type(*this).find(v, pos);
+            r = i == npos ? nullptr : p + i;
+        }
+        return r == nullptr ? npos : static_cast<size_type>(r - p);
+    }
+
+    size_type find(const CharT* s, size_type pos = 0) const noexcept { return find(view_type(s), pos); }
+
+    size_type rfind(CharT c, size_type pos = npos) const noexcept { return view_type(*this).rfind(c, pos); }
+    size_type rfind(view_type v, size_type pos = npos) const noexcept { return view_type(*this).rfind(v, pos); }
+
+    bool contains(CharT c) const noexcept     { return find(c) != npos; }
+    bool contains(view_type v) const noexcept { return find(v) != npos; }
+
+    bool starts_with(view_type v) const noexcept {
+        return size() >= v.size() && compare_chars(data(), v.data(), v.size()) == 0;
+    }
+
+    bool ends_with(view_type v) const noexcept {
+        return size() >= v.size() && compare_chars(data() + size() - v.size(), v.data(), v.size()) == 0;
+    }
+
+    int compare(view_type v) const noexcept {
+        auto n = size();
+        if (int r = compare_chars(data(), v.data(), std::min(n, v.size()))) {
+            return r;
+        }
+        return n < v.size() ? -1 : (n > v.size() ? 1 : 0);
+    }
+
+    int compare(const basic_string& other) const noexcept { return compare(view_type(other)); }
+    int compare(const CharT* s) const noexcept            { return compare(view_type(s)); }
+
+    basic_string substr(size_type pos = 0, size_type n = npos) const {
+        check_pos(pos);
+        return basic_string(data() + pos, std::min(n, size() - pos), alloc());
+    }
+
+public: // modification members
+    basic_string& assign(const CharT* s, size_type n) {
+        if (n <= capacity()) {
+            traits_type::move(data(), s, n);
+            set_size(n);
+        } else {
+            auto cap = calc_size(n);
+            auto p = allocate(cap);
+            traits_type::copy(p, s, n);
+            release_buffer();
+            set_long(p, n, cap);
+        }
+        return *this;
+    }
+
+    basic_string& assign(const basic_string& other) { return *this = other; }
+    basic_string& assign(view_type v)               { return assign(v.data(), v.size()); }
+    basic_string& assign(const CharT* s)            { return assign(s, traits_type::length(s)); }
+
+    basic_string& assign(size_type n, CharT c) {
+        clear();
+        return append(n, c);
+    }
+
+    void clear() noexcept {
+        set_size(0);
+    }
+
+    void reserve(size_type n) {
+        if (n > capacity()) {
+            reallocate(n);
+        }
+    }
+
+    void shrink_to_fit() {
+        if (!is_long() || capacity() == size()) {
+            return;
+        }
+        auto& l = rep_ref().l;
+        if (l.size <= sso_capacity) {
+            auto p = l.data;
+            auto n = l.size;
+            auto cap = capacity();
+            traits_type::copy(rep_ref().s, p, n);
+            set_short_size(n);
+            deallocate(p, cap);
+        } else {
+            reallocate(l.size);
+        }
+    }
+
+    void resize(size_type n, CharT c = CharT()) {
+        auto sz = size();
+        if (n > sz) {
+            append(n - sz, c);
+        } else {
+            set_size(n);
+        }
+    }
+
+    // New characters are left uninitialized for the caller to overwrite.
+    void resize_for_overwrite(size_type n) {
+        if (n > capacity()) {
+            reallocate(calc_size(n));
+        }
+        set_size(n);
+    }
+
+    // Lets op write up to n characters in place and keeps the first op(data, n).
+    template<typename Operation>
+    void resize_and_overwrite(size_type n, Operation op) {
+        resize_for_overwrite(n);
+        auto r = static_cast<size_type>(std::move(op)(data(), n));
+        assert(r <= n);
+        set_size(r);
+    }
+
+    void push_back(CharT c) {
+        auto n = size();
+        if (n == capacity()) {
+            reallocate(calc_size(n + 1));
+        }
+        data()[n] = c;
+        set_size(n + 1);
+    }
+
+    void pop_back() noexcept {
+        assert(!empty());
+        set_size(size() - 1);
+    }
+
+    basic_string& append(const CharT* s, size_type n) {
+        auto sz = size();
+        if (n > capacity() - sz) {
+            check_length(sz, n);
+            // s may point into the old buffer, so copy before releasing it
+            auto cap = calc_size(sz + n);
+            auto p = allocate(cap);
+            traits_type::copy(p, data(), sz);
+            traits_type::copy(p + sz, s, n);
+            release_buffer();
+            set_long(p, sz + n, cap);
+        } else {
+            traits_type::copy(data() + sz, s, n);
+            set_size(sz + n);
+        }
+        return *this;
+    }
+
+    basic_string& append(size_type n, CharT c) {
+        auto sz = size();
+        if (n > capacity() - sz) {
+            check_length(sz, n);
+            reallocate(calc_size(sz + n));
+        }
+        traits_type::assign(data() + sz, n, c);
+        set_size(sz + n);
+        return *this;
+    }
+
+    basic_string& append(const basic_string& s) { return append(s.data(), s.size()); }
+    basic_string& append(view_type v)           { return append(v.data(), v.size()); }
+    basic_string& append(const CharT* s)        { return append(s, traits_type::length(s)); }
+
+    basic_string& operator+=(const basic_string& s) { return append(s); }
+    basic_string& operator+=(view_type v)           { return append(v); }
+    basic_string& operator+=(const CharT* s)        { return append(s); }
+    basic_string& operator+=(CharT c)               { push_back(c); return *this; }
+
+    basic_string& insert(size_type pos, view_type v) {
+        check_pos(pos);
+        auto p = data();
+        if (v.data() >= p && v.data() <= p + size()) {
+            return insert(pos, view_type(basic_string(v, alloc())));
+        }
+        auto sz = size();
+        auto n = v.size();
+        if (n > capacity() - sz) {
+            check_length(sz, n);
+            auto cap = calc_size(sz + n);
+            auto np = allocate(cap);
+            traits_type::copy(np, p, pos);
+            traits_type::copy(np + pos, v.data(), n);
+            traits_type::copy(np + pos + n, p + pos, sz - pos);
+            release_buffer();
+            set_long(np, sz + n, cap);
+        } else {
+            traits_type::move(p + pos + n, p + pos, sz - pos);
+            traits_type::copy(p + pos, v.data(), n);
+            set_size(sz + n);
+        }
+        return *this;
+    }
+
+    basic_string& insert(size_type pos, const CharT* s) { return insert(pos, view_type(s)); }
+
+    basic_string& erase(size_type pos = 0, size_type n = npos) {
+        check_pos(pos);
+        auto sz = size();
+        n = std::min(n, sz - pos);
+        auto p = data();
+        traits_type::move(p + pos, p + pos + n, sz - pos - n);
+        set_size(sz - n);
+        return *this;
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        auto pos = static_cast<size_type>(first - data());
+        erase(pos, static_cast<size_type>(last - first));
+        return data() + pos;
+    }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    // Allocators are exchanged only if they propagate on swap; otherwise they
+    // must compare equal. Inline characters are swapped with the rest.
+    void swap(basic_string& other) noexcept {
+        assert((allocator_traits::propagate_on_container_swap::value || alloc() == other.alloc())
+               && "swap of strings with unequal allocators");
+        std::swap(rep_ref(), other.rep_ref());
+        if constexpr (allocator_traits::propagate_on_container_swap::value) {
+            using std::swap;
+            swap(alloc(), other.alloc());
+        }
+    }
+
+private:
+    static constexpr size_type long_flag = size_type(1) << (sizeof(size_type) * 8 - 1);
+
+    union rep
+    {
+        long_rep l;
+        CharT s[sso_capacity + 1];
+    };
+
+    static_assert(sizeof(rep) == sizeof(long_rep));
+
+    static constexpr bool is_char() noexcept {
+        return std::is_same_v<CharT, char> && std::is_same_v<Traits, std::char_traits<char>>;
+    }
+
+    static int compare_chars(const CharT* a, const CharT* b, size_type n) noexcept {
+        if constexpr (is_char()) {
+            return simd_compare(a, b, n);
+        } else {
+            return traits_type::compare(a, b, n);
+        }
+    }
+
+    rep& rep_ref() noexcept                         { return rep_allocator_.first(); }
+    const rep& rep_ref() const noexcept             { return rep_allocator_.first(); }
+    allocator_type& alloc() noexcept                { return rep_allocator_.second(); }
+    const allocator_type& alloc() const noexcept    { return rep_allocator_.second(); }
+
+    bool is_long() const noexcept {
+        return (reinterpret_cast<const unsigned char*>(&rep_ref())[sizeof(rep) - 1] & 0x80) != 0;
+    }
+
+    size_t calc_size(size_t new_size) const noexcept {
+        return std::max(new_size, capacity() * 2);
+    }
+
+    void check_pos(size_type pos) const {
+        if (pos > size())
+            throw std::out_of_range("basic_string: position out of bounds");
+    }
+
+    void check_length(size_type sz, size_type n) const {
+        if (n > max_size() - sz)
+            throw std::length_error("basic_string: too long");
+    }
+
+    // Buffers hold one more character for the terminator.
+    CharT* allocate(size_type cap) {
+        return allocator_traits::allocate(alloc(), cap + 1);
+    }
+
+    void deallocate(CharT* p, size_type cap) noexcept {
+        allocator_traits::deallocate(alloc(), p, cap + 1);
+    }
+
+    void set_short_size(size_type n) noexcept {
+        rep_ref().s[sso_capacity] = static_cast<CharT>(sso_capacity - n);
+        rep_ref().s[n] = CharT();
+    }
+
+    void set_long(CharT* p, size_type n, size_type cap) noexcept {
+        auto& l = rep_ref().l;
+        l.data = p;
+        l.size = n;
+        l.cap = cap | long_flag;
+        p[n] = CharT();
+    }
+
+    void set_size(size_type n) noexcept {
+        if (is_long()) {
+            rep_ref().l.size = n;
+            rep_ref().l.data[n] = CharT();
+        } else {
+            set_short_size(n);
+        }
+    }
+
+    void init(const CharT* s, size_type n) {
+        if (n <= sso_capacity) {
+            traits_type::copy(rep_ref().s, s, n);
+            set_short_size(n);
+        } else {
+            check_length(0, n);
+            auto p = allocate(n);
+            traits_type::copy(p, s, n);
+            set_long(p, n, n);
+        }
+    }
+
+    void reallocate(size_type cap) {
+        auto n = size();
+        auto p = allocate(cap);
+        traits_type::copy(p, data(), n);
+        release_buffer();
+        set_long(p, n, cap);
+    }
+
+    void release_buffer() noexcept {
+        if (is_long()) {
+            deallocate(rep_ref().l.data, capacity());
+            set_short_size(0);
+        }
+    }
+
+    void steal(basic_string& other) noexcept {
+        rep_ref() = other.rep_ref();
+        other.set_short_size(0);
+    }
+
+private:
+    compressed_pair<rep, allocator_type> rep_allocator_;
+};
+
+template<typename C, typename T, typename A>
+bool operator==(const basic_string<C, T, A>& lhs, const basic_string<C, T, A>& rhs) noexcept {
+    return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+
+template<typename C, typename T, typename A>
+bool operator==(const basic_string<C, T, A>& lhs, const C* rhs) noexcept {
+    return lhs.compare(rhs) == 0;
+}
+
+template<typename C, typename T, typename A>
+bool operator==(const C* lhs, const basic_string<C, T, A>& rhs) noexcept {
+    return rhs.compare(lhs) == 0;
+}
+
+template<typename C, typename T, typename A>
+bool operator!=(const basic_string<C, T, A>& lhs, const basic_string<C, T, A>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template<typename C, typename T, typename A>
+bool operator!=(const basic_string<C, T, A>& lhs, const C* rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template<typename C, typename T, typename A>
+bool operator!=(const C* lhs, const basic_string<C, T, A>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template<typename C, typename T, typename A>
+bool operator<(const basic_string<C, T, A>& lhs, const basic_string<C, T, A>& rhs) noexcept {
+    return lhs.compare(rhs) < 0;
+}
+
+template<typename C, typename T, typename A>
+bool operator<=(const basic_string<C, T, A>& lhs, const basic_string<C, T, A>& rhs) noexcept {
+    return !(rhs < lhs);
+}
+
+template<typename C, typename T, typename A>
+bool operator>(const basic_string<C, T, A>& lhs, const basic_string<C, T, A>& rhs) noexcept {
+    return rhs < lhs;
+}
+
+template<typename C, typename T, typename A>
+bool operator>=(const basic_string<C, T, A>& lhs, const basic_string<C, T, A>& rhs) noexcept {
+    return !(lhs < rhs);
+}
+
+template<typename C, typename T, typename A>
+basic_string<C, T, A> operator+(const basic_string<C, T, A>& lhs, std::basic_string_view<C, T> rhs) {
+    basic_string<C, T, A> r(lhs.get_allocator());
+    r.reserve(lhs.size() + rhs.size());
+    r.append(lhs).append(rhs);
+    return r;
+}
+
+template<typename C, typename T, typename A>
+basic_string<C, T, A> operator+(basic_string<C, T, A>&& lhs, std::basic_string_view<C, T> rhs) {
+    lhs.append(rhs);
+    return std::move(lhs);
+}
+
+template<typename C, typename T, typename A>
+basic_string<C, T, A> operator+(const basic_string<C, T, A>& lhs, const basic_string<C, T, A>& rhs) {
+    return lhs + std::basic_string_view<C, T>(rhs);
+}
+
+template<typename C, typename T, typename A>
+basic_string<C, T, A> operator+(basic_string<C, T, A>&& lhs, const basic_string<C, T, A>& rhs) {
+    return std::move(lhs) + std::basic_string_view<C, T>(rhs);
+}
+
+template<typename C, typename T, typename A>
+basic_string<C, T, A> operator+(const basic_string<C, T, A>& lhs, const C* rhs) {
+    return lhs + std::basic_string_view<C, T>(rhs);
+}
+
+template<typename C, typename T, typename A>
+basic_string<C, T, A> operator+(basic_string<C, T, A>&& lhs, const C* rhs) {
+    return std::move(lhs) + std::basic_string_view<C, T>(rhs);
+}
+
+template<typename C, typename T, typename A>
+basic_string<C, T, A> operator+(const basic_string<C, T, A>& lhs, C rhs) {
+    return lhs + std::basic_string_view<C, T>(&rhs, 1);
+}
+
+template<typename C, typename T, typename A>
+basic_string<C, T, A> operator+(basic_string<C, T, A>&& lhs, C rhs) {
+    lhs.push_back(rhs);
+    return std::move(lhs);
+}
+
+template<typename C, typename T, typename A>
+basic_string<C, T, A> operator+(const C* lhs, const basic_string<C, T, A>& rhs) {
+    basic_string<C, T, A> r(rhs.get_allocator());
+    auto n = T::length(lhs);
+    r.reserve(n + rhs.size());
+    r.append(lhs, n).append(rhs);
+    return r;
+}
+
+template<typename C, typename T, typename A>
+std::basic_ostream<C, T>& operator<<(std::basic_ostream<C, T>& stream, const basic_string<C, T, A>& s) {
+    return stream << std::basic_string_view<C, T>(s);
+}
+
+using string = basic_string<char>;
+
+} // namespace dl
+
+namespace std {
+
+template<typename C, typename T, typename A>
+struct hash<dl::basic_string<C, T, A>>
+{
+    size_t operator()(const dl::basic_string<C, T, A>& s) const noexcept {
+        return hash<basic_string_view<C, T>>()(s);
+    }
+};
+
+} // namespace std
@@ -1,12 +1,19 @@
 #pragma once
 
+#include <cstddef>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace dl {
 
+// Members of these types are stored as base classes and take no space.
+template<typename T>
+inline constexpr bool is_compressible_v = std::is_empty_v<T> && !std::is_final_v<T>;
+
 template<typename T,
          unsigned num,
-         bool isEmpty = (std::is_empty_v<T> && !std::is_final_v<T>)>
+         bool isEmpty = is_compressible_v<T>>
 class compressed_pair_elem
 {
 public:
@@ -62,4 +69,91 @@ public:
     T2& second() { return Base2::get(); }
 };
 
+// compressed_pair for any number of members, addressed by index, so types
+// may repeat. Empty members take no space, except that two empty members of
+// the same type still need distinct addresses.
+template<typename T,
+         size_t I,
+         bool isEmpty = is_compressible_v<T>>
+class compressed_tuple_elem
+{
+public:
+    constexpr compressed_tuple_elem() : elem_() {}
+
+    template<typename U>
+    constexpr explicit compressed_tuple_elem(U&& u) : elem_(std::forward<U>(u)) {}
+
+    constexpr const T& get() const noexcept { return elem_; }
+    constexpr T& get() noexcept { return elem_; }
+
+private:
+    T elem_;
+};
+
+template<typename T, size_t I>
+class compressed_tuple_elem<T, I, true> : private T
+{
+public:
+    constexpr compressed_tuple_elem() : T() {}
+
+    template<typename U>
+    constexpr explicit compressed_tuple_elem(U&& u) : T(std::forward<U>(u)) {}
+
+    constexpr const T& get() const noexcept { return *this; }
+    constexpr T& get() noexcept { return *this; }
+};
+
+template<typename Indices, typename... Ts>
+struct compressed_tuple_storage;
+
+template<size_t... Is, typename... Ts>
+struct compressed_tuple_storage<std::index_sequence<Is...>, Ts...> : compressed_tuple_elem<Ts, Is>...
+{
+    constexpr compressed_tuple_storage() : compressed_tuple_elem<Ts, Is>()... {}
+
+    template<typename... Us>
+    constexpr explicit compressed_tuple_storage(std::in_place_t, Us&&... us)
+        : compressed_tuple_elem<Ts, Is>(std::forward<Us>(us))... {}
+};
+
+template<typename Self, typename... Us>
+struct is_not_self : std::true_type {};
+
+template<typename Self, typename U>
+struct is_not_self<Self, U> : std::negation<std::is_same<std::decay_t<U>, Self>> {};
+
+template<typename... Ts>
+class compressed_tuple : private compressed_tuple_storage<std::index_sequence_for<Ts...>, Ts...>
+{
+    using storage = compressed_tuple_storage<std::index_sequence_for<Ts...>, Ts...>;
+
+    template<size_t I>
+    using elem = compressed_tuple_elem<std::tuple_element_t<I, std::tuple<Ts...>>, I>;
+
+public:
+    constexpr compressed_tuple() = default;
+
+    template<typename... Us,
+             std::enable_if_t<sizeof...(Us) == sizeof...(Ts) && is_not_self<compressed_tuple, Us...>::value, int> = 0>
+    constexpr compressed_tuple(Us&&... us) : storage(std::in_place, std::forward<Us>(us)...) {}
+
+    template<size_t I>
+    constexpr decltype(auto) get() noexcept { return static_cast<elem<I>&>(static_cast<storage&>(*this)).get(); }
+
+    template<size_t I>
+    constexpr decltype(auto) get() const noexcept {
+        return static_cast<const elem<I>&>(static_cast<const storage&>(*this)).get();
+    }
+};
+
+template<size_t I, typename... Ts>
+constexpr decltype(auto) get(compressed_tuple<Ts...>& t) noexcept {
+    return t.template get<I>();
+}
+
+template<size_t I, typename... Ts>
+constexpr decltype(auto) get(const compressed_tuple<Ts...>& t) noexcept {
+    return t.template get<I>();
+}
+
 } // namespace dl
@@ -0,0 +1,297 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "vector.h"
+
+namespace dl {
+
+template<typename T, typename Allocator>
+class atomic_cow_vector;
+
+// Vector with a shared, reference counted buffer: copies are O(1) and share
+// the elements until one of them is modified, which then copies them first.
+// Distinct cow_vector objects may be used from different threads even when
+// they share a buffer; one object is not safe to modify concurrently.
+template<typename T, typename Allocator = std::allocator<T>>
+class cow_vector
+{
+public: // aliases
+    using vector_type = vector<T, Allocator>;
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using const_pointer = typename vector_type::const_pointer;
+    using const_iterator = typename vector_type::const_iterator;
+    using const_reverse_iterator = typename vector_type::const_reverse_iterator;
+
+public: // constructors
+    cow_vector() noexcept = default;
+
+    explicit cow_vector(vector_type vec)
+        : rep_(make_rep(std::move(vec))) {}
+
+    cow_vector(std::initializer_list<value_type> list, const allocator_type& a = allocator_type())
+        : rep_(make_rep(vector_type(list, a))) {}
+
+    cow_vector(const cow_vector& other) noexcept
+        : rep_(other.rep_) {
+        retain(rep_);
+    }
+
+    cow_vector(cow_vector&& other) noexcept
+        : rep_(std::exchange(other.rep_, nullptr)) {}
+
+    cow_vector& operator=(const cow_vector& other) noexcept {
+        cow_vector(other).swap(*this);
+        return *this;
+    }
+
+    cow_vector& operator=(cow_vector&& other) noexcept {
+        cow_vector(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~cow_vector() {
+        release(rep_);
+    }
+
+public: // access members
+    const vector_type& get() const noexcept { return rep_ ? rep_->vec : empty_vector(); }
+
+    const value_type* data() const noexcept { return get().data(); }
+
+    const_iterator begin() const noexcept  { return get().begin(); }
+    const_iterator end() const noexcept    { return get().end(); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept   { return end(); }
+
+    const_reverse_iterator rbegin() const noexcept { return get().rbegin(); }
+    const_reverse_iterator rend() const noexcept   { return get().rend(); }
+
+    const_reference operator[](size_type i) const noexcept { return get()[i]; }
+    const_reference at(size_type i) const { return get().at(i); }
+
+    const_reference front() const noexcept { return get().front(); }
+    const_reference back() const noexcept  { return get().back(); }
+
+    size_type size() const noexcept     { return get().size(); }
+    size_type capacity() const noexcept { return get().capacity(); }
+    bool empty() const noexcept         { return get().empty(); }
+
+    // Number of cow_vectors (and published slots) sharing the buffer.
+    size_t use_count() const noexcept { return rep_ ? rep_->refs.load(std::memory_order_relaxed) : 0; }
+
+    bool shares_with(const cow_vector& other) const noexcept { return rep_ != nullptr && rep_ == other.rep_; }
+
+public: // modification members
+    // Mutable access to a private copy of the elements.
+    vector_type& edit() {
+        detach();
+        return rep_->vec;
+    }
+
+    void set(size_type i, const value_type& value) { edit()[i] = value; }
+    void set(size_type i, value_type&& value)      { edit()[i] = std::move(value); }
+
+    void push_back(const value_type& value) { edit().push_back(value); }
+    void push_back(value_type&& value)      { edit().push_back(std::move(value)); }
+
+    template<typename... Args>
+    reference emplace_back(Args&&... args) {
+        return edit().emplace_back(std::forward<Args>(args)...);
+    }
+
+    void pop_back() { edit().pop_back(); }
+
+    void resize(size_type n)                         { edit().resize(n); }
+    void resize(size_type n, const value_type& value) { edit().resize(n, value); }
+    void reserve(size_type n)                        { edit().reserve(n); }
+
+    // Drops the reference instead of clearing a shared buffer.
+    void clear() noexcept {
+        release(std::exchange(rep_, nullptr));
+    }
+
+    void swap(cow_vector& other) noexcept {
+        std::swap(rep_, other.rep_);
+    }
+
+private:
+    friend class atomic_cow_vector<T, Allocator>;
+
+    struct rep
+    {
+        explicit rep(vector_type&& v) : vec(std::move(v)) {}
+
+        std::atomic<size_t> refs{1};
+        vector_type vec;
+    };
+
+    using rep_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<rep>;
+    using rep_traits = std::allocator_traits<rep_allocator>;
+
+    explicit cow_vector(rep* r) noexcept : rep_(r) {}
+
+    static const vector_type& empty_vector() noexcept {
+        static const vector_type empty;
+        return empty;
+    }
+
+    static rep* make_rep(vector_type&& vec) {
+        rep_allocator a(vec.get_allocator());
+        auto r = rep_traits::allocate(a, 1);
+        try {
+            rep_traits::construct(a, r, std::move(vec));
+        } catch (...) {
+            rep_traits::deallocate(a, r, 1);
+            throw;
+        }
+        return r;
+    }
+
+    static void retain(rep* r) noexcept {
+        if (r != nullptr) {
+            r->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static void release(rep* r) noexcept {
+        if (r != nullptr && r->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            rep_allocator a(r->vec.get_allocator());
+            rep_traits::destroy(a, r);
+            rep_traits::deallocate(a, r, 1);
+        }
+    }
+
+    void detach() {
+        if (rep_ == nullptr) {
+            rep_ = make_rep(vector_type());
+        } else if (rep_->refs.load(std::memory_order_acquire) != 1) {
+            auto r = make_rep(vector_type(rep_->vec, rep_->vec.get_allocator()));
+            release(std::exchange(rep_, r));
+        }
+    }
+
+private:
+    rep* rep_ = nullptr;
+};
+
+template<typename T, typename A>
+bool operator==(const cow_vector<T, A>& lhs, const cow_vector<T, A>& rhs) {
+    return lhs.shares_with(rhs) || lhs.get() == rhs.get();
+}
+
+template<typename T, typename A>
+bool operator!=(const cow_vector<T, A>& lhs, const cow_vector<T, A>& rhs) {
+    return !(lhs == rhs);
+}
+
+// Slot holding the current version of a cow_vector. acquire() takes no lock:
+// a reader registers in the reader count of the current epoch, loads the
+// buffer and takes a reference. publish() swaps the buffer under a writer
+// mutex, advances the epoch and waits until the readers of the old epoch are
+// gone before dropping its reference to the old buffer.
+template<typename T, typename Allocator = std::allocator<T>>
+class atomic_cow_vector
+{
+public:
+    using value_type = cow_vector<T, Allocator>;
+
+public:
+    atomic_cow_vector() noexcept = default;
+
+    explicit atomic_cow_vector(value_type initial) noexcept
+        : current_(std::exchange(initial.rep_, nullptr)) {}
+
+    atomic_cow_vector(const atomic_cow_vector&) = delete;
+    atomic_cow_vector& operator=(const atomic_cow_vector&) = delete;
+
+    ~atomic_cow_vector() {
+        value_type::release(current_.load(std::memory_order_relaxed));
+    }
+
+    value_type acquire() const noexcept {
+        for (;;) {
+            auto e = epoch_.load(std::memory_order_seq_cst);
+            auto& readers = readers_[e & 1].count;
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            if (epoch_.load(std::memory_order_seq_cst) == e) {
+                auto r = current_.load(std::memory_order_seq_cst);
+                value_type::retain(r);
+                readers.fetch_sub(1, std::memory_order_release);
+                return value_type(r);
+            }
+            readers.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    void publish(value_type next) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        auto old = current_.exchange(std::exchange(next.rep_, nullptr), std::memory_order_seq_cst);
+        auto e = epoch_.fetch_add(1, std::memory_order_seq_cst);
+        version_.fetch_add(1, std::memory_order_release);
+        auto& readers = readers_[e & 1].count;
+        // seq_cst pairs with the reader's increment and epoch re-check: either
+        // the reader sees the new epoch or this load sees its registration.
+        while (readers.load(std::memory_order_seq_cst) != 0) {
+            std::this_thread::yield();
+        }
+        value_type::release(old);
+    }
+
+    // Changes on every publish(); lets readers keep a snapshot until it moves.
+    uint64_t version() const noexcept {
+        return version_.load(std::memory_order_acquire);
+    }
+
+private:
+    using rep = typename value_type::rep;
+
+    struct alignas(64) reader_count
+    {
+        std::atomic<size_t> count{0};
+    };
+
+    std::atomic<rep*> current_{nullptr};
+    alignas(64) std::atomic<uint64_t> epoch_{0};
+    std::atomic<uint64_t> version_{0};
+    mutable reader_count readers_[2];
+    std::mutex write_mutex_;
+};
+
+// Per-thread view of an atomic_cow_vector that only re-acquires after a
+// publish, so steady-state reads touch no shared cache line for writing.
+template<typename T, typename Allocator = std::allocator<T>>
+class cow_reader
+{
+public:
+    explicit cow_reader(const atomic_cow_vector<T, Allocator>& slot)
+        : slot_(slot) {}
+
+    const cow_vector<T, Allocator>& get() {
+        auto v = slot_.version();
+        if (v != version_ || !acquired_) {
+            snapshot_ = slot_.acquire();
+            version_ = v;
+            acquired_ = true;
+        }
+        return snapshot_;
+    }
+
+private:
+    const atomic_cow_vector<T, Allocator>& slot_;
+    cow_vector<T, Allocator> snapshot_;
+    uint64_t version_ = 0;
+    bool acquired_ = false;
+};
+
+} // namespace dl
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include "thread_pool.h"
+
+namespace dl {
+
+class parallel_policy
+{
+public:
+    constexpr parallel_policy() noexcept = default;
+
+    constexpr explicit parallel_policy(thread_pool& pool, size_t serial_bytes = default_serial_bytes) noexcept
+        : pool_(&pool)
+        , serial_bytes_(serial_bytes) {}
+
+    parallel_policy on(thread_pool& pool) const noexcept {
+        return parallel_policy(pool, serial_bytes_);
+    }
+
+    parallel_policy with_threshold(size_t serial_bytes) const noexcept {
+        auto p = *this;
+        p.serial_bytes_ = serial_bytes;
+        return p;
+    }
+
+    thread_pool& pool() const { return pool_ ? *pool_ : thread_pool::global(); }
+
+    // Work smaller than this many bytes stays on the calling thread.
+    size_t serial_bytes() const noexcept { return serial_bytes_; }
+
+    static constexpr size_t default_serial_bytes = size_t(1) << 22;
+
+private:
+    thread_pool* pool_ = nullptr;
+    size_t serial_bytes_ = default_serial_bytes;
+};
+
+inline constexpr parallel_policy par{};
+
+template<typename F>
+void parallel_for(const parallel_policy& policy, size_t n, size_t item_bytes, F&& fn) {
+    auto& pool = policy.pool();
+    if (n * item_bytes < policy.serial_bytes() || pool.size() == 1) {
+        fn(size_t(0), n);
+    } else {
+        pool.for_range(n, fn);
+    }
+}
+
+// Calls construct_one(p, i) for the i-th element of uninitialized [first, first + n),
+// spreading chunks over the pool so pages are first touched by the thread that fills them.
+// Strong guarantee: if any element throws, everything constructed so far is destroyed.
+template<typename Allocator, typename Pointer, typename Construct>
+Pointer parallel_construct(const parallel_policy& policy, Allocator& alloc,
+                           Pointer first, size_t n, Construct construct_one) {
+    using traits = std::allocator_traits<Allocator>;
+    using value_type = typename traits::value_type;
+
+    auto fill = [&](size_t lo, size_t hi) {
+        auto i = lo;
+        try {
+            for (; i != hi; ++i) {
+                construct_one(first + i, i);
+            }
+        } catch (...) {
+            while (i-- != lo) {
+                traits::destroy(alloc, first + i);
+            }
+            throw;
+        }
+    };
+
+    auto& pool = policy.pool();
+    if (n * sizeof(value_type) < policy.serial_bytes() || pool.size() == 1) {
+        fill(0, n);
+        return first + n;
+    }
+
+    const size_t chunks = pool.size() * 4;
+    std::unique_ptr<bool[]> done(new bool[chunks]());
+    try {
+        pool.run(chunks, [&](size_t c) {
+            fill(n * c / chunks, n * (c + 1) / chunks);
+            done[c] = true;
+        });
+    } catch (...) {
+        for (size_t c = 0; c < chunks; ++c) {
+            if (done[c]) {
+                for (auto i = n * c / chunks; i != n * (c + 1) / chunks; ++i) {
+                    traits::destroy(alloc, first + i);
+                }
+            }
+        }
+        throw;
+    }
+    return first + n;
+}
+
+} // namespace dl
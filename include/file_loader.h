@@ -0,0 +1,196 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "execution.h"
+#include "serialize.h"
+#include "vector.h"
+
+namespace dl {
+
+enum class file_advice
+{
+    none,
+    sequential, // POSIX_FADV_SEQUENTIAL over the whole file
+    willneed    // start readahead of the whole file up front
+};
+
+struct load_options
+{
+    size_t chunk_bytes = size_t(8) << 20;
+    file_advice advice = file_advice::sequential;
+};
+
+class file_descriptor
+{
+public:
+    explicit file_descriptor(const std::string& path, int flags = O_RDONLY | O_CLOEXEC)
+        : fd_(::open(path.c_str(), flags)) {
+        if (fd_ < 0)
+            throw std::system_error(errno, std::generic_category(), "dl: open " + path);
+    }
+
+    file_descriptor(const file_descriptor&) = delete;
+    file_descriptor& operator=(const file_descriptor&) = delete;
+
+    ~file_descriptor() {
+        ::close(fd_);
+    }
+
+    int get() const noexcept { return fd_; }
+
+private:
+    int fd_;
+};
+
+inline void advise(int fd, off_t offset, off_t len, file_advice advice) noexcept {
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (advice == file_advice::sequential) {
+        ::posix_fadvise(fd, offset, len, POSIX_FADV_SEQUENTIAL);
+    } else if (advice == file_advice::willneed) {
+        ::posix_fadvise(fd, offset, len, POSIX_FADV_WILLNEED);
+    }
+#else
+    (void)fd; (void)offset; (void)len; (void)advice;
+#endif
+}
+
+// Replaces out with the contents of path. Regular files are sized up front,
+// the buffer is reserved exactly once and filled by parallel pread chunks.
+template<typename T, typename A>
+void load_file(const std::string& path, vector<T, A>& out,
+               const parallel_policy& policy = par, const load_options& opts = load_options()) {
+    static_assert(std::is_trivially_copyable_v<T>, "load_file loads raw bytes");
+    file_descriptor file(path);
+    auto fd = file.get();
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+        throw std::system_error(errno, std::generic_category(), "dl: fstat " + path);
+
+    out.clear();
+    if (!S_ISREG(st.st_mode)) {
+        // pipes and character devices: size unknown, read sequentially. The
+        // buffer grows only once it is full, and a read that ends inside an
+        // element leaves the rest of it to the next one.
+        size_t filled = 0;
+        try {
+            for (;;) {
+                if (filled == out.size() * sizeof(T)) {
+                    out.reserve(std::max<size_t>({out.capacity() * 2, opts.chunk_bytes / sizeof(T), 1}));
+                    out.resize_for_overwrite(out.capacity());
+                }
+                auto n = ::read(fd, reinterpret_cast<char*>(out.data()) + filled, out.size() * sizeof(T) - filled);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n < 0)
+                    throw std::system_error(errno, std::generic_category(), "dl: read " + path);
+                if (n == 0) {
+                    break;
+                }
+                filled += static_cast<size_t>(n);
+            }
+        } catch (...) {
+            out.resize(filled / sizeof(T));
+            throw;
+        }
+        out.resize(filled / sizeof(T));
+        if (filled % sizeof(T) != 0)
+            throw std::runtime_error("dl::load_file: partial element at the end of " + path);
+        return;
+    }
+
+    auto bytes = static_cast<size_t>(st.st_size);
+    if (bytes % sizeof(T) != 0)
+        throw std::runtime_error("dl::load_file: size of " + path + " is not a multiple of the element size");
+    advise(fd, 0, 0, opts.advice);
+
+    out.reserve(bytes / sizeof(T));
+    out.resize_for_overwrite(bytes / sizeof(T));
+    auto dst = reinterpret_cast<char*>(out.data());
+    auto chunk = std::max<size_t>(opts.chunk_bytes, 1);
+    auto chunks = (bytes + chunk - 1) / chunk;
+    auto read_chunk = [&](size_t c) {
+        auto first = c * chunk;
+        read_all(fd, dst + first, std::min(chunk, bytes - first), static_cast<off_t>(first));
+    };
+    try {
+        auto& pool = policy.pool();
+        if (bytes < policy.serial_bytes() || pool.size() == 1) {
+            for (size_t c = 0; c < chunks; ++c) {
+                read_chunk(c);
+            }
+        } else {
+            pool.run(chunks, read_chunk);
+        }
+    } catch (...) {
+        out.clear();
+        throw;
+    }
+}
+
+template<typename T = char, typename A = std::allocator<T>>
+vector<T, A> load_file(const std::string& path, const parallel_policy& policy = par,
+                       const load_options& opts = load_options(), const A& alloc = A()) {
+    vector<T, A> out(alloc);
+    load_file(path, out, policy, opts);
+    return out;
+}
+
+// Hands out a file in fixed-size chunks, hinting the kernel to read the
+// following chunk while the caller parses the current one.
+class chunked_file_reader
+{
+public:
+    explicit chunked_file_reader(const std::string& path, size_t chunk_bytes = size_t(4) << 20)
+        : file_(path)
+        , chunk_(std::max<size_t>(chunk_bytes, 1)) {
+        advise(file_.get(), 0, 0, file_advice::sequential);
+        advise(file_.get(), 0, static_cast<off_t>(chunk_), file_advice::willneed);
+    }
+
+    // Fills chunk with the next piece of the file, false at end of file.
+    template<typename A>
+    bool next(vector<char, A>& chunk) {
+        if (chunk.capacity() < chunk_) {
+            chunk.clear();
+            chunk.reserve(chunk_);
+        }
+        chunk.resize_for_overwrite(chunk_);
+        advise(file_.get(), offset_ + static_cast<off_t>(chunk_), static_cast<off_t>(chunk_), file_advice::willneed);
+        size_t got = 0;
+        while (got < chunk_) {
+            auto n = ::pread(file_.get(), chunk.data() + got, chunk_ - got, offset_ + static_cast<off_t>(got));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0)
+                throw std::system_error(errno, std::generic_category(), "dl: pread");
+            if (n == 0) {
+                break;
+            }
+            got += static_cast<size_t>(n);
+        }
+        chunk.resize(got);
+        offset_ += static_cast<off_t>(got);
+        return got != 0;
+    }
+
+    off_t offset() const noexcept { return offset_; }
+
+private:
+    file_descriptor file_;
+    size_t chunk_;
+    off_t offset_ = 0;
+};
+
+} // namespace dl
@@ -0,0 +1,556 @@
+#pragma once
+#include <cstddef>
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include "algorithm.h"
+#include "compressed_pair.h"
+#include "split_buffer.h"
+#include "type_utils.h"
+
+namespace dl {
+
+// Random-access iterator over a buffer with a hole: it never points into
+// [gap_begin, gap_end) and steps over it.
+template<typename Pointer>
+class gap_iterator
+{
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::remove_cv_t<typename std::pointer_traits<Pointer>::element_type>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Pointer;
+    using reference = decltype(*std::declval<Pointer>());
+
+public:
+    gap_iterator() noexcept = default;
+
+    gap_iterator(Pointer p, Pointer gap_begin, Pointer gap_end) noexcept
+        : p_(p)
+        , gap_begin_(gap_begin)
+        , gap_end_(gap_end) {}
+
+    template<typename P, std::enable_if_t<std::is_convertible_v<P, Pointer>, int> = 0>
+    gap_iterator(const gap_iterator<P>& other) noexcept
+        : p_(other.base())
+        , gap_begin_(other.gap_begin())
+        , gap_end_(other.gap_end()) {}
+
+    reference operator*() const noexcept { return *p_; }
+    pointer operator->() const noexcept { return p_; }
+    reference operator[](difference_type n) const noexcept { return *(*this + n); }
+
+    gap_iterator& operator++() noexcept {
+        if (++p_ == gap_begin_) {
+            p_ = gap_end_;
+        }
+        return *this;
+    }
+
+    gap_iterator& operator--() noexcept {
+        if (p_ == gap_end_) {
+            p_ = gap_begin_;
+        }
+        --p_;
+        return *this;
+    }
+
+    gap_iterator operator++(int) noexcept { auto it = *this; ++*this; return it; }
+    gap_iterator operator--(int) noexcept { auto it = *this; --*this; return it; }
+
+    gap_iterator& operator+=(difference_type n) noexcept {
+        auto gap = gap_end_ - gap_begin_;
+        if (n >= 0) {
+            p_ += (p_ < gap_begin_ && n >= gap_begin_ - p_) ? n + gap : n;
+        } else {
+            p_ += (p_ >= gap_end_ && -n > p_ - gap_end_) ? n - gap : n;
+        }
+        return *this;
+    }
+
+    gap_iterator& operator-=(difference_type n) noexcept { return *this += -n; }
+
+    friend gap_iterator operator+(gap_iterator it, difference_type n) noexcept { return it += n; }
+    friend gap_iterator operator+(difference_type n, gap_iterator it) noexcept { return it += n; }
+    friend gap_iterator operator-(gap_iterator it, difference_type n) noexcept { return it -= n; }
+
+    friend difference_type operator-(const gap_iterator& a, const gap_iterator& b) noexcept {
+        auto d = a.p_ - b.p_;
+        if (a.p_ >= a.gap_end_ && b.p_ < a.gap_begin_) {
+            d -= a.gap_end_ - a.gap_begin_;
+        } else if (b.p_ >= a.gap_end_ && a.p_ < a.gap_begin_) {
+            d += a.gap_end_ - a.gap_begin_;
+        }
+        return d;
+    }
+
+    friend bool operator==(const gap_iterator& a, const gap_iterator& b) noexcept { return a.p_ == b.p_; }
+    friend bool operator!=(const gap_iterator& a, const gap_iterator& b) noexcept { return a.p_ != b.p_; }
+    friend bool operator<(const gap_iterator& a, const gap_iterator& b) noexcept  { return a.p_ < b.p_; }
+    friend bool operator>(const gap_iterator& a, const gap_iterator& b) noexcept  { return a.p_ > b.p_; }
+    friend bool operator<=(const gap_iterator& a, const gap_iterator& b) noexcept { return a.p_ <= b.p_; }
+    friend bool operator>=(const gap_iterator& a, const gap_iterator& b) noexcept { return a.p_ >= b.p_; }
+
+    Pointer base() const noexcept { return p_; }
+    Pointer gap_begin() const noexcept { return gap_begin_; }
+    Pointer gap_end() const noexcept { return gap_end_; }
+
+private:
+    Pointer p_ = nullptr;
+    Pointer gap_begin_ = nullptr;
+    Pointer gap_end_ = nullptr;
+};
+
+// Sequence with a movable gap of free capacity inside the buffer: elements
+// live in [begin, gap_begin) and [gap_end, end_cap). Inserting or erasing at
+// the gap is O(1); moving the gap costs the distance it travels, so edits
+// around a slowly moving cursor are O(1) amortized.
+template<typename T, typename Allocator = std::allocator<T>>
+class gap_vector
+{
+public: // aliases
+    using value_type = T;
+    using allocator_type = Allocator;
+    using allocator_traits = std::allocator_traits<allocator_type>;
+    using pointer = typename allocator_traits::pointer;
+    using const_pointer = typename allocator_traits::const_pointer;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using iterator = gap_iterator<pointer>;
+    using const_iterator = gap_iterator<const_pointer>;
+
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+public: // constructors
+    gap_vector() noexcept = default;
+
+    explicit gap_vector(const allocator_type& alloc) noexcept
+        : end_cap_allocator_(nullptr, alloc) {}
+
+    explicit gap_vector(size_type count, const allocator_type& a = allocator_type())
+        : gap_vector(a) {
+        allocate_n(count);
+        gap_begin_ = construct(alloc(), begin_, begin_ + count);
+    }
+
+    gap_vector(size_type count, const value_type& value, const allocator_type& a = allocator_type())
+        : gap_vector(a) {
+        allocate_n(count);
+        gap_begin_ = construct(alloc(), begin_, begin_ + count, value);
+    }
+
+    template<typename I,
+             std::enable_if_t<is_input_iter<I>::value, int> = 0>
+    gap_vector(I first, I last, const allocator_type& a = allocator_type())
+        : gap_vector(a) {
+        insert(end(), first, last);
+    }
+
+    gap_vector(std::initializer_list<value_type> list, const allocator_type& a = allocator_type())
+        : gap_vector(list.begin(), list.end(), a) {}
+
+    gap_vector(const gap_vector& other)
+        : gap_vector(other, allocator_traits::select_on_container_copy_construction(other.alloc())) {}
+
+    gap_vector(const gap_vector& other, const allocator_type& a)
+        : gap_vector(a) {
+        allocate_n(other.size());
+        gap_begin_ = uninit_copy(alloc(), other.begin(), other.end(), begin_);
+    }
+
+    gap_vector(gap_vector&& other) noexcept
+        : gap_vector(other.alloc()) {
+        steal(other);
+    }
+
+    gap_vector& operator=(const gap_vector& other) {
+        if (this != &other) {
+            if constexpr (allocator_traits::propagate_on_container_copy_assignment::value) {
+                if (alloc() != other.alloc()) {
+                    release_buffer();
+                }
+                alloc() = other.alloc();
+            }
+            clear();
+            insert(end(), other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    gap_vector& operator=(gap_vector&& other) noexcept(allocator_traits::propagate_on_container_move_assignment::value
+                                                       || allocator_traits::is_always_equal::value) {
+        if (this == &other) {
+            return *this;
+        }
+        if constexpr (allocator_traits::propagate_on_container_move_assignment::value) {
+            release_buffer();
+            alloc() = std::move(other.alloc());
+            steal(other);
+        } else if (allocator_traits::is_always_equal::value || alloc() == other.alloc()) {
+            release_buffer();
+            steal(other);
+        } else {
+            clear();
+            insert(end(), std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+        }
+        return *this;
+    }
+
+    ~gap_vector() {
+        release_buffer();
+    }
+
+public: // access members
+    iterator begin() noexcept             { return make_iter(begin_); }
+    iterator end() noexcept               { return make_iter(end_cap()); }
+    const_iterator begin() const noexcept { return make_iter(begin_); }
+    const_iterator end() const noexcept   { return make_iter(end_cap()); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept   { return end(); }
+
+    reverse_iterator rbegin() noexcept { return std::make_reverse_iterator(end());   }
+    reverse_iterator rend() noexcept   { return std::make_reverse_iterator(begin()); }
+
+    const_reverse_iterator rbegin() const noexcept { return std::make_reverse_iterator(end());   }
+    const_reverse_iterator rend() const noexcept   { return std::make_reverse_iterator(begin()); }
+
+    const_reference operator[](size_type i) const noexcept { return *at_index(i); }
+    reference operator[](size_type i) noexcept             { return *at_index(i); }
+
+    const_reference at(size_type i) const {
+        if (i >= size())
+            throw std::out_of_range("gap_vector index out of bounds");
+        return *at_index(i);
+    }
+
+    reference at(size_type i) {
+        if (i >= size())
+            throw std::out_of_range("gap_vector index out of bounds");
+        return *at_index(i);
+    }
+
+    reference front() noexcept             { return *begin(); }
+    const_reference front() const noexcept { return *begin(); }
+
+    reference back() noexcept             { return *at_index(size() - 1); }
+    const_reference back() const noexcept { return *at_index(size() - 1); }
+
+    size_type size() const noexcept     { return capacity() - gap_size(); }
+    size_type capacity() const noexcept { return static_cast<size_type>(end_cap() - begin_); }
+    bool empty() const noexcept         { return size() == 0; }
+
+    // Index of the first element after the gap.
+    size_type gap_position() const noexcept { return static_cast<size_type>(gap_begin_ - begin_); }
+
+    allocator_type get_allocator() const noexcept {
+        return alloc();
+    }
+
+    // Moves the gap behind the last element and returns the now contiguous elements.
+    pointer contiguous() {
+        move_gap(size());
+        return begin_;
+    }
+
+public: // modification members
+    // Moves the gap in front of the element at pos.
+    void move_gap(size_type pos) {
+        auto target = begin_ + pos;
+        if (gap_begin_ == gap_end_) {
+            gap_begin_ = gap_end_ = target;
+        } else if (target < gap_begin_) {
+            if constexpr (is_trivial_relocation) {
+                auto n = gap_begin_ - target;
+                std::memmove(gap_end_ - n, target, n * sizeof(value_type));
+                gap_begin_ = target;
+                gap_end_ -= n;
+            } else {
+                while (gap_begin_ != target) {
+                    allocator_traits::construct(alloc(), gap_end_ - 1, std::move_if_noexcept(gap_begin_[-1]));
+                    --gap_end_;
+                    allocator_traits::destroy(alloc(), --gap_begin_);
+                }
+            }
+        } else if (target > gap_begin_) {
+            auto n = target - gap_begin_;
+            if constexpr (is_trivial_relocation) {
+                std::memmove(gap_begin_, gap_end_, n * sizeof(value_type));
+                gap_begin_ = target;
+                gap_end_ += n;
+            } else {
+                for (; n != 0; --n) {
+                    allocator_traits::construct(alloc(), gap_begin_, std::move_if_noexcept(*gap_end_));
+                    ++gap_begin_;
+                    allocator_traits::destroy(alloc(), gap_end_++);
+                }
+            }
+        }
+    }
+
+    void reserve(size_type n) {
+        if (n > capacity()) {
+            reallocate(n, gap_position());
+        }
+    }
+
+    void shrink_to_fit() {
+        if (capacity() != size()) {
+            reallocate(size(), gap_position());
+        }
+    }
+
+    void clear() noexcept {
+        destroy(alloc(), begin_, gap_begin_);
+        destroy(alloc(), gap_end_, end_cap());
+        gap_begin_ = begin_;
+        gap_end_ = end_cap();
+    }
+
+    void resize(size_type n) {
+        resize_impl(n, [this](pointer p) { allocator_traits::construct(alloc(), p); });
+    }
+
+    void resize(size_type n, const value_type& value) {
+        resize_impl(n, [&](pointer p) { allocator_traits::construct(alloc(), p, value); });
+    }
+
+    void push_back(const value_type& value) { emplace_back(value); }
+    void push_back(value_type&& value)      { emplace_back(std::move(value)); }
+
+    template<typename... Args>
+    reference emplace_back(Args&&... args) {
+        return *emplace(end(), std::forward<Args>(args)...);
+    }
+
+    void pop_back() {
+        erase(end() - 1);
+    }
+
+    iterator insert(const_iterator pos, const value_type& value) {
+        return emplace(pos, value);
+    }
+
+    iterator insert(const_iterator pos, value_type&& value) {
+        return emplace(pos, std::move(value));
+    }
+
+    // Constructs in place when the gap is already at pos; otherwise the new
+    // element is built first, since args may refer to elements about to move.
+    template<typename... Args>
+    iterator emplace(const_iterator cpos, Args&&... args) {
+        auto idx = index_of(cpos);
+        if (gap_begin_ == begin_ + idx && gap_begin_ != gap_end_) {
+            allocator_traits::construct(alloc(), gap_begin_, std::forward<Args>(args)...);
+        } else {
+            value_type tmp(std::forward<Args>(args)...);
+            open_gap(idx, 1);
+            allocator_traits::construct(alloc(), gap_begin_, std::move(tmp));
+        }
+        ++gap_begin_;
+        return make_iter(gap_begin_ - 1);
+    }
+
+    iterator insert(const_iterator cpos, size_type n, const value_type& value) {
+        auto idx = index_of(cpos);
+        if (n != 0) {
+            const value_type v(value); // value may live in this container
+            open_gap(idx, n);
+            gap_begin_ = construct(alloc(), gap_begin_, gap_begin_ + n, v);
+        }
+        return make_iter(at_index(idx));
+    }
+
+    template<typename I>
+    std::enable_if_t<is_forward_iter<I>::value, iterator>
+    insert(const_iterator cpos, I first, I last) {
+        auto idx = index_of(cpos);
+        auto n = static_cast<size_type>(std::distance(first, last));
+        if (n != 0) {
+            open_gap(idx, n);
+            for (; first != last; ++first) {
+                allocator_traits::construct(alloc(), gap_begin_, *first);
+                ++gap_begin_;
+            }
+        }
+        return make_iter(at_index(idx));
+    }
+
+    template<typename I>
+    std::enable_if_t<is_input_iter<I>::value && !is_forward_iter<I>::value, iterator>
+    insert(const_iterator cpos, I first, I last) {
+        auto idx = index_of(cpos);
+        move_gap(idx);
+        for (; first != last; ++first) {
+            emplace(make_iter(gap_begin_), *first);
+        }
+        return make_iter(at_index(idx));
+    }
+
+    iterator insert(const_iterator pos, std::initializer_list<value_type> list) {
+        return insert(pos, list.begin(), list.end());
+    }
+
+    iterator erase(const_iterator pos) {
+        return erase(pos, pos + 1);
+    }
+
+    // Erased elements join the gap, so deleting just before or after the
+    // cursor moves nothing.
+    iterator erase(const_iterator cfirst, const_iterator clast) {
+        auto idx = index_of(cfirst);
+        auto n = static_cast<size_type>(clast - cfirst);
+        if (n != 0) {
+            if (idx + n == gap_position()) {
+                gap_begin_ = destroy(alloc(), gap_begin_ - n, gap_begin_);
+            } else {
+                move_gap(idx);
+                gap_end_ = destroy(alloc(), gap_end_, gap_end_ + n) + n;
+            }
+        }
+        return make_iter(at_index(idx));
+    }
+
+    void swap(gap_vector& other) noexcept {
+        std::swap(begin_, other.begin_);
+        std::swap(gap_begin_, other.gap_begin_);
+        std::swap(gap_end_, other.gap_end_);
+        std::swap(end_cap(), other.end_cap());
+        if constexpr (allocator_traits::propagate_on_container_swap::value) {
+            using std::swap;
+            swap(alloc(), other.alloc());
+        }
+    }
+
+private:
+    static constexpr bool is_trivial_relocation =
+        std::is_trivially_copyable_v<value_type> && std::is_pointer_v<pointer>;
+
+    size_t calc_size(size_t new_size) const noexcept {
+        return std::max(new_size, capacity() * 2);
+    }
+
+    allocator_type& alloc()             { return end_cap_allocator_.second(); }
+    const allocator_type& alloc() const { return end_cap_allocator_.second(); }
+
+    pointer& end_cap()             { return end_cap_allocator_.first(); }
+    const pointer& end_cap() const { return end_cap_allocator_.first(); }
+
+    size_type gap_size() const noexcept { return static_cast<size_type>(gap_end_ - gap_begin_); }
+
+    iterator make_iter(pointer p) noexcept {
+        return iterator(p == gap_begin_ ? gap_end_ : p, gap_begin_, gap_end_);
+    }
+
+    const_iterator make_iter(pointer p) const noexcept {
+        return const_iterator(p == gap_begin_ ? gap_end_ : p, gap_begin_, gap_end_);
+    }
+
+    pointer at_index(size_type i) const noexcept {
+        auto p = begin_ + i;
+        return p < gap_begin_ ? p : p + (gap_end_ - gap_begin_);
+    }
+
+    size_type index_of(const_iterator it) const noexcept {
+        return static_cast<size_type>(it - cbegin());
+    }
+
+    // Gap of at least n at idx.
+    void open_gap(size_type idx, size_type n) {
+        if (gap_size() < n) {
+            reallocate(calc_size(size() + n), idx);
+        } else {
+            move_gap(idx);
+        }
+    }
+
+    // Moves the elements into a buffer of cap elements with the gap at pos.
+    void reallocate(size_type cap, size_type pos) {
+        auto sz = size();
+        split_buffer<value_type, allocator_type&> buff(0, cap, alloc());
+        auto new_end_cap = buff.begin + cap;
+        auto new_gap_end = new_end_cap - (sz - pos);
+        auto it = begin();
+        for (size_type i = 0; i < pos; ++i, ++it) {
+            buff.emplace_back(std::move_if_noexcept(*it));
+        }
+        auto p = new_gap_end;
+        try {
+            for (; p != new_end_cap; ++p, ++it) {
+                allocator_traits::construct(alloc(), p, std::move_if_noexcept(*it));
+            }
+        } catch (...) {
+            destroy(alloc(), new_gap_end, p);
+            throw;
+        }
+        release_buffer();
+        begin_ = buff.begin;
+        gap_begin_ = buff.end;
+        gap_end_ = new_gap_end;
+        end_cap() = new_end_cap;
+        buff.begin = buff.end = buff.end_cap() = nullptr;
+    }
+
+    template<typename Constructor>
+    void resize_impl(size_type n, const Constructor& constructor) {
+        auto sz = size();
+        if (n < sz) {
+            erase(begin() + n, end());
+        } else if (n > sz) {
+            open_gap(sz, n - sz);
+            for (; sz != n; ++sz) {
+                constructor(gap_begin_);
+                ++gap_begin_;
+            }
+        }
+    }
+
+    void allocate_n(size_type n) {
+        begin_ = gap_begin_ = gap_end_ = allocator_traits::allocate(alloc(), n);
+        gap_end_ = end_cap() = begin_ + n;
+    }
+
+    void steal(gap_vector& other) noexcept {
+        begin_ = other.begin_;
+        gap_begin_ = other.gap_begin_;
+        gap_end_ = other.gap_end_;
+        end_cap() = other.end_cap();
+        other.begin_ = other.gap_begin_ = other.gap_end_ = other.end_cap() = nullptr;
+    }
+
+    void release_buffer() noexcept {
+        clear();
+        allocator_traits::deallocate(alloc(), begin_, capacity());
+        begin_ = gap_begin_ = gap_end_ = end_cap() = nullptr;
+    }
+
+private:
+    pointer begin_ = nullptr;
+    pointer gap_begin_ = nullptr;
+    pointer gap_end_ = nullptr;
+    compressed_pair<pointer, allocator_type> end_cap_allocator_;
+};
+
+template<typename T, typename Alloc>
+bool operator==(const gap_vector<T, Alloc>& lhs, const gap_vector<T, Alloc>& rhs) {
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template<typename T, typename Alloc>
+bool operator!=(const gap_vector<T, Alloc>& lhs, const gap_vector<T, Alloc>& rhs) {
+    return !(lhs == rhs);
+}
+
+template<typename T, typename Alloc>
+bool operator<(const gap_vector<T, Alloc>& lhs, const gap_vector<T, Alloc>& rhs) {
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+} // namespace dl
@@ -0,0 +1,250 @@
+#pragma once
+
+// Call-site growth profiling for dl::vector, off unless DL_GROWTH_PROFILE is
+// defined for the whole program. When enabled, the growth APIs (push_back,
+// insert, resize, append_range, ...) take a hidden trailing argument with
+// their caller's file and line, and every reallocation made to grow a vector
+// is counted against that site: how often, how many bytes were moved, and the
+// capacity it grew to last. The table is written to stderr at exit, largest
+// bytes moved first; sites near the top want a reserve().
+//
+// emplace_back and emplace cannot take a defaulted argument after their
+// parameter pack; their sites are return addresses, printed as object and
+// offset for addr2line. Link with -ldl where glibc is older than 2.34.
+//
+// Without DL_GROWTH_PROFILE the macros below expand to nothing, so
+// signatures and code generation are unchanged.
+
+#ifdef DL_GROWTH_PROFILE
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <vector>
+
+namespace dl {
+
+struct source_site
+{
+    const char* file = nullptr;
+    unsigned line = 0;
+    const void* caller = nullptr;
+
+    static constexpr source_site current(const char* file = __builtin_FILE(),
+                                         unsigned line = __builtin_LINE()) noexcept {
+        return {file, line, nullptr};
+    }
+
+    static source_site from_caller(const void* return_address) noexcept {
+        return {nullptr, 0, return_address};
+    }
+
+    bool known() const noexcept { return file != nullptr || caller != nullptr; }
+
+    // Distinct for distinct sites: user-space addresses stay below 2^48.
+    // Never 0, which marks a free slot; 1 is the unknown site.
+    uintptr_t key() const noexcept {
+        if (file) {
+            return reinterpret_cast<uintptr_t>(file) ^ (uintptr_t(line) << 48);
+        }
+        return caller ? reinterpret_cast<uintptr_t>(caller) : 1;
+    }
+};
+
+// The return address of a call from an emplace function. Never inlined, and
+// the emplace functions always are, so it lies in the function that called
+// them rather than in theirs or in that function's caller.
+[[gnu::noinline]] inline source_site emplace_caller_site() noexcept {
+    return source_site::from_caller(__builtin_return_address(0));
+}
+
+// The site of the outermost growth API on this thread's stack; nested
+// calls (push_back into emplace_back, insert into reserve) keep it.
+inline thread_local source_site current_growth_site;
+
+class growth_site_scope
+{
+public:
+    explicit growth_site_scope(const source_site& site) noexcept : owner_(!current_growth_site.known()) {
+        if (owner_) {
+            current_growth_site = site;
+        }
+    }
+
+    ~growth_site_scope() {
+        if (owner_) {
+            current_growth_site = source_site();
+        }
+    }
+
+    growth_site_scope(const growth_site_scope&) = delete;
+    growth_site_scope& operator=(const growth_site_scope&) = delete;
+
+private:
+    bool owner_;
+};
+
+// Open addressing over a fixed table: a site claims its slot with one CAS
+// and is only ever counted with relaxed atomics afterwards, so recording
+// takes no lock and allocates nothing. Sites beyond the table are counted
+// as dropped.
+class growth_profile
+{
+public:
+    static constexpr size_t table_size = 4096;
+
+    struct entry
+    {
+        source_site site;
+        uint64_t reallocations;
+        uint64_t bytes_moved;
+        uint64_t capacity_bytes;
+    };
+
+    static growth_profile& instance() {
+        // never destroyed: vectors in static storage may still grow while
+        // other statics are torn down
+        static growth_profile* profile = [] {
+            auto p = new growth_profile;
+            std::atexit([] { instance().dump(stderr); });
+            return p;
+        }();
+        return *profile;
+    }
+
+    void record(uint64_t bytes_moved, uint64_t capacity_bytes) noexcept {
+        auto site = current_growth_site;
+        auto key = site.key();
+        auto h = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 52) & (table_size - 1);
+        for (size_t probe = 0; probe < table_size; ++probe, h = (h + 1) & (table_size - 1)) {
+            auto& slot = slots_[h];
+            auto k = slot.key.load(std::memory_order_acquire);
+            if (k == 0) {
+                uintptr_t expected = 0;
+                if (slot.key.compare_exchange_strong(expected, key, std::memory_order_acq_rel)) {
+                    slot.file.store(site.file, std::memory_order_relaxed);
+                    slot.line.store(site.line, std::memory_order_relaxed);
+                    slot.caller.store(site.caller, std::memory_order_relaxed);
+                    k = key;
+                } else {
+                    k = expected;
+                }
+            }
+            if (k == key) {
+                slot.reallocations.fetch_add(1, std::memory_order_relaxed);
+                slot.bytes_moved.fetch_add(bytes_moved, std::memory_order_relaxed);
+                slot.capacity_bytes.store(capacity_bytes, std::memory_order_relaxed);
+                return;
+            }
+        }
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Sites with the same file name and line (one inline function seen by
+    // several translation units) are merged.
+    std::vector<entry> entries() const {
+        std::vector<entry> out;
+        for (auto& slot : slots_) {
+            if (slot.key.load(std::memory_order_acquire) == 0) {
+                continue;
+            }
+            entry e{{slot.file.load(std::memory_order_relaxed), slot.line.load(std::memory_order_relaxed),
+                     slot.caller.load(std::memory_order_relaxed)},
+                    slot.reallocations.load(std::memory_order_relaxed),
+                    slot.bytes_moved.load(std::memory_order_relaxed),
+                    slot.capacity_bytes.load(std::memory_order_relaxed)};
+            auto same = std::find_if(out.begin(), out.end(), [&](const entry& o) {
+                return e.site.file && o.site.file && o.site.line == e.site.line
+                       && std::strcmp(o.site.file, e.site.file) == 0;
+            });
+            if (same != out.end()) {
+                same->reallocations += e.reallocations;
+                same->bytes_moved += e.bytes_moved;
+                same->capacity_bytes = std::max(same->capacity_bytes, e.capacity_bytes);
+            } else {
+                out.push_back(e);
+            }
+        }
+        std::sort(out.begin(), out.end(), [](const entry& a, const entry& b) {
+            return a.bytes_moved > b.bytes_moved;
+        });
+        return out;
+    }
+
+    void dump(FILE* out) const {
+        auto sites = entries();
+        std::fprintf(out, "dl growth profile: %zu sites, %llu reallocations dropped\n", sites.size(),
+                     static_cast<unsigned long long>(dropped_.load(std::memory_order_relaxed)));
+        std::fprintf(out, "%10s %16s %16s  %s\n", "reallocs", "bytes_moved", "capacity_bytes", "site");
+        for (auto& e : sites) {
+            std::fprintf(out, "%10llu %16llu %16llu  ", static_cast<unsigned long long>(e.reallocations),
+                         static_cast<unsigned long long>(e.bytes_moved),
+                         static_cast<unsigned long long>(e.capacity_bytes));
+            if (e.site.file) {
+                std::fprintf(out, "%s:%u\n", e.site.file, e.site.line);
+            } else if (e.site.caller) {
+                Dl_info info{};
+                if (::dladdr(e.site.caller, &info) != 0 && info.dli_fname) {
+                    std::fprintf(out, "%s+0x%zx (emplace)\n", info.dli_fname,
+                                 static_cast<size_t>(static_cast<const char*>(e.site.caller)
+                                                     - static_cast<const char*>(info.dli_fbase)));
+                } else {
+                    std::fprintf(out, "%p (emplace)\n", e.site.caller);
+                }
+            } else {
+                std::fprintf(out, "<unknown>\n");
+            }
+        }
+    }
+
+    // Only while no vector is growing.
+    void reset() noexcept {
+        for (auto& slot : slots_) {
+            slot.key.store(0, std::memory_order_relaxed);
+            slot.reallocations.store(0, std::memory_order_relaxed);
+            slot.bytes_moved.store(0, std::memory_order_relaxed);
+            slot.capacity_bytes.store(0, std::memory_order_relaxed);
+        }
+        dropped_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    growth_profile() = default;
+
+    struct slot
+    {
+        std::atomic<uintptr_t> key{0};
+        std::atomic<const char*> file{nullptr};
+        std::atomic<unsigned> line{0};
+        std::atomic<const void*> caller{nullptr};
+        std::atomic<uint64_t> reallocations{0};
+        std::atomic<uint64_t> bytes_moved{0};
+        std::atomic<uint64_t> capacity_bytes{0};
+    };
+
+    slot slots_[table_size];
+    std::atomic<uint64_t> dropped_{0};
+};
+
+} // namespace dl
+
+#define DL_GROWTH_SITE , ::dl::source_site growth_site_ = ::dl::source_site::current()
+#define DL_GROWTH_SCOPE ::dl::growth_site_scope growth_scope_(growth_site_)
+#define DL_GROWTH_CALLER_INLINE [[gnu::always_inline]]
+#define DL_GROWTH_CALLER_SCOPE ::dl::growth_site_scope growth_scope_(::dl::emplace_caller_site())
+#define DL_GROWTH_RECORD(bytes_moved, capacity_bytes) \
+    ::dl::growth_profile::instance().record(bytes_moved, capacity_bytes)
+
+#else
+
+#define DL_GROWTH_SITE
+#define DL_GROWTH_SCOPE
+#define DL_GROWTH_CALLER_INLINE
+#define DL_GROWTH_CALLER_SCOPE
+#define DL_GROWTH_RECORD(bytes_moved, capacity_bytes)
+
+#endif
@@ -0,0 +1,324 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dl {
+
+enum class mapped_mode
+{
+    open,           // file must exist and match
+    create,         // truncate or create an empty vector
+    open_or_create
+};
+
+// Vector of trivially copyable elements stored in a shared file mapping.
+// The file starts with a header holding size, capacity, element size and
+// format version, the elements follow it.
+template<typename T>
+class mapped_vector
+{
+    static_assert(std::is_trivially_copyable_v<T>, "mapped_vector stores raw bytes");
+    static_assert(alignof(T) <= 64, "Element alignment exceeds header size");
+
+public: // aliases
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+    using iterator = pointer;
+    using const_iterator = const_pointer;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    static constexpr uint32_t version = 1;
+
+    struct header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t element_size;
+        uint64_t size;
+        uint64_t capacity;
+        char reserved[32];
+    };
+    static_assert(sizeof(header) == 64);
+
+public: // constructors
+    mapped_vector() noexcept = default;
+
+    explicit mapped_vector(const std::string& path, mapped_mode mode = mapped_mode::open_or_create) {
+        open(path, mode);
+    }
+
+    mapped_vector(const mapped_vector&) = delete;
+    mapped_vector& operator=(const mapped_vector&) = delete;
+
+    mapped_vector(mapped_vector&& other) noexcept {
+        swap(other);
+    }
+
+    mapped_vector& operator=(mapped_vector&& other) noexcept {
+        mapped_vector(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~mapped_vector() {
+        close();
+    }
+
+public: // file members
+    void open(const std::string& path, mapped_mode mode = mapped_mode::open_or_create) {
+        close();
+        int flags = O_RDWR | O_CLOEXEC;
+        if (mode == mapped_mode::create) {
+            flags |= O_CREAT | O_TRUNC;
+        } else if (mode == mapped_mode::open_or_create) {
+            flags |= O_CREAT;
+        }
+        fd_ = ::open(path.c_str(), flags, 0644);
+        if (fd_ < 0)
+            throw std::system_error(errno, std::generic_category(), "mapped_vector: open " + path);
+
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) {
+            fail("fstat");
+        }
+        auto file_size = static_cast<size_t>(st.st_size);
+        if (file_size == 0 && mode != mapped_mode::open) {
+            truncate(sizeof(header));
+            map(sizeof(header));
+            std::memcpy(hdr_->magic, magic, sizeof(magic));
+            hdr_->version = version;
+            hdr_->element_size = sizeof(value_type);
+            return;
+        }
+        if (file_size < sizeof(header)) {
+            close();
+            throw std::runtime_error("mapped_vector: " + path + " is too small");
+        }
+        map(file_size);
+        const char* error = nullptr;
+        if (std::memcmp(hdr_->magic, magic, sizeof(magic)) != 0) {
+            error = "bad magic";
+        } else if (hdr_->version != version) {
+            error = "version mismatch";
+        } else if (hdr_->element_size != sizeof(value_type)) {
+            error = "element size mismatch";
+        } else if (hdr_->size > hdr_->capacity
+                   || hdr_->capacity > (file_size - sizeof(header)) / sizeof(value_type)) {
+            error = "corrupted header";
+        }
+        if (error) {
+            close();
+            throw std::runtime_error("mapped_vector: " + path + ": " + error);
+        }
+    }
+
+    void close() noexcept {
+        if (hdr_ != nullptr) {
+            ::munmap(hdr_, mapped_);
+            hdr_ = nullptr;
+            mapped_ = 0;
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    bool is_open() const noexcept { return hdr_ != nullptr; }
+
+    void sync(bool async = false) {
+        if (hdr_ != nullptr && ::msync(hdr_, mapped_, async ? MS_ASYNC : MS_SYNC) != 0)
+            throw std::system_error(errno, std::generic_category(), "mapped_vector: msync");
+    }
+
+public: // access members
+    const value_type* data() const noexcept { return elems(); }
+    value_type* data() noexcept             { return elems(); }
+
+    iterator begin() noexcept { return elems(); }
+    iterator end() noexcept   { return elems() + size(); }
+
+    const_iterator begin() const noexcept { return elems(); }
+    const_iterator end() const noexcept   { return elems() + size(); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept   { return end(); }
+
+    reverse_iterator rbegin() noexcept { return std::make_reverse_iterator(end());   }
+    reverse_iterator rend() noexcept   { return std::make_reverse_iterator(begin()); }
+
+    const_reverse_iterator rbegin() const noexcept { return std::make_reverse_iterator(end());   }
+    const_reverse_iterator rend() const noexcept   { return std::make_reverse_iterator(begin()); }
+
+    const_reference operator[](size_type i) const noexcept { return elems()[i]; }
+    reference operator[](size_type i) noexcept             { return elems()[i]; }
+
+    const_reference at(size_type i) const {
+        if (i >= size())
+            throw std::out_of_range("mapped_vector index out of bounds");
+        return elems()[i];
+    }
+
+    reference at(size_type i) {
+        if (i >= size())
+            throw std::out_of_range("mapped_vector index out of bounds");
+        return elems()[i];
+    }
+
+    reference front() noexcept             { return elems()[0]; }
+    const_reference front() const noexcept { return elems()[0]; }
+
+    reference back() noexcept             { return elems()[size() - 1]; }
+    const_reference back() const noexcept { return elems()[size() - 1]; }
+
+    size_type size() const noexcept     { return hdr_ ? static_cast<size_type>(hdr_->size) : 0; }
+    size_type capacity() const noexcept { return hdr_ ? static_cast<size_type>(hdr_->capacity) : 0; }
+    bool empty() const noexcept { return size() == 0; }
+
+public: // modification members
+    void reserve(size_type n) {
+        if (n > capacity()) {
+            grow(n);
+        }
+    }
+
+    void resize(size_type n, const value_type& value = value_type()) {
+        if (n > capacity()) {
+            auto v = value; // value may live in the mapping we are about to move
+            grow(calc_size(n));
+            std::fill(end(), elems() + n, v);
+        } else if (n > size()) {
+            std::fill(end(), elems() + n, value);
+        }
+        if (hdr_ != nullptr) {
+            hdr_->size = n;
+        }
+    }
+
+    void push_back(const value_type& value) {
+        emplace_back(value);
+    }
+
+    template<typename... Args>
+    reference emplace_back(Args&&... args) {
+        value_type v(std::forward<Args>(args)...);
+        if (size() == capacity()) {
+            grow(calc_size(size() + 1));
+        }
+        elems()[hdr_->size++] = v;
+        return back();
+    }
+
+    void pop_back() noexcept {
+        --hdr_->size;
+    }
+
+    void clear() noexcept {
+        if (hdr_ != nullptr) {
+            hdr_->size = 0;
+        }
+    }
+
+    void shrink_to_fit() {
+        if (capacity() != size()) {
+            remap(size());
+        }
+    }
+
+    void swap(mapped_vector& other) noexcept {
+        std::swap(fd_, other.fd_);
+        std::swap(hdr_, other.hdr_);
+        std::swap(mapped_, other.mapped_);
+        std::swap(file_bytes_, other.file_bytes_);
+    }
+
+private:
+    static constexpr char magic[8] = {'d', 'l', 'm', 'v', 'e', 'c', 0, 0};
+
+    value_type* elems() const noexcept {
+        return hdr_ ? reinterpret_cast<value_type*>(hdr_ + 1) : nullptr;
+    }
+
+    static size_t bytes_for(size_type n) {
+        if (n > (~size_t(0) - sizeof(header)) / sizeof(value_type))
+            throw std::length_error("mapped_vector capacity exceeds the address space");
+        return sizeof(header) + n * sizeof(value_type);
+    }
+
+    size_type calc_size(size_type new_size) const noexcept {
+        return std::max(new_size, capacity() * 2);
+    }
+
+    void grow(size_type n) {
+        if (hdr_ == nullptr)
+            throw std::logic_error("mapped_vector is not open");
+        remap(n);
+    }
+
+    void remap(size_type n) {
+        auto bytes = bytes_for(n);
+        if (bytes > mapped_) {
+            truncate(bytes);
+        }
+        void* p = ::mremap(hdr_, mapped_, bytes, MREMAP_MAYMOVE);
+        if (p == MAP_FAILED) {
+            fail("mremap");
+        }
+        hdr_ = static_cast<header*>(p);
+        mapped_ = bytes;
+        if (bytes < file_bytes_) {
+            truncate(bytes);
+        }
+        hdr_->capacity = n;
+    }
+
+    void map(size_t bytes) {
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            fail("mmap");
+        }
+        hdr_ = static_cast<header*>(p);
+        mapped_ = bytes;
+        file_bytes_ = bytes;
+    }
+
+    void truncate(size_t bytes) {
+        if (::ftruncate(fd_, static_cast<off_t>(bytes)) != 0) {
+            fail("ftruncate");
+        }
+        file_bytes_ = bytes;
+    }
+
+    [[noreturn]] void fail(const char* what) {
+        int err = errno;
+        if (hdr_ == nullptr) {
+            close();
+        }
+        throw std::system_error(err, std::generic_category(), std::string("mapped_vector: ") + what);
+    }
+
+private:
+    int fd_ = -1;
+    header* hdr_ = nullptr;
+    size_t mapped_ = 0;
+    size_t file_bytes_ = 0;
+};
+
+} // namespace dl
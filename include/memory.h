@@ -1,6 +1,11 @@
 #pragma once
 
 #include "compressed_pair.h"
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <new>
 #include <type_traits>
 
 namespace dl {
@@ -27,23 +32,23 @@ public:
     unique_ptr(pointer p) : pointer_deleter_(p, Deleter()) {}
 
     std::add_lvalue_reference_t<element_type> operator*() const noexcept {
-        return *pointer_deleter_.first();
+        return *dl::get<0>(pointer_deleter_);
     }
 
     pointer get() noexcept {
-        return pointer_deleter_.first();
+        return dl::get<0>(pointer_deleter_);
     }
 
     pointer get() const noexcept {
-        return pointer_deleter_.first();
+        return dl::get<0>(pointer_deleter_);
     }
 
     deleter_type& get_deleter() noexcept {
-        return pointer_deleter_.second();
+        return dl::get<1>(pointer_deleter_);
     }
 
     const deleter_type& get_deleter() const noexcept {
-        return pointer_deleter_.second();
+        return dl::get<1>(pointer_deleter_);
     }
 
     operator bool() const {
@@ -52,15 +57,109 @@ public:
 
     void reset(pointer ptr = pointer()) {
         get_deleter()(get());
-        pointer_deleter_.first() = ptr;
+        dl::get<0>(pointer_deleter_) = ptr;
     }
 
     ~unique_ptr() {
+        static_assert(!is_compressible_v<deleter_type> || sizeof(unique_ptr) == sizeof(pointer),
+                      "An empty deleter must not grow unique_ptr");
         reset();
     }
 
 private:
-    compressed_pair<pointer, deleter_type> pointer_deleter_;
+    compressed_tuple<pointer, deleter_type> pointer_deleter_;
+};
+
+// Allocator over malloc/free, so buffers that come from or go to C code can
+// be adopted and released by containers without a copy.
+template<typename T>
+class malloc_allocator
+{
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+public:
+    malloc_allocator() noexcept = default;
+
+    template<typename U>
+    malloc_allocator(const malloc_allocator<U>&) noexcept {}
+
+    T* allocate(size_type n) {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "malloc does not align over-aligned types");
+        if (n > std::numeric_limits<size_type>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        auto p = std::malloc(n * sizeof(T));
+        if (p == nullptr && n != 0)
+            throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_type) noexcept {
+        std::free(p);
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const malloc_allocator<T>&, const malloc_allocator<U>&) noexcept { return true; }
+
+template<typename T, typename U>
+bool operator!=(const malloc_allocator<T>&, const malloc_allocator<U>&) noexcept { return false; }
+
+// Allocators may hand out memory that is already zero, typically fresh pages
+// from the OS, by providing pointer allocate_zeroed(size_type n); blocks are
+// returned through deallocate as usual.
+template<typename A, typename = void>
+struct has_allocate_zeroed : std::false_type {};
+
+template<typename A>
+struct has_allocate_zeroed<A, std::void_t<decltype(std::declval<A&>().allocate_zeroed(size_t()))>>
+    : std::true_type {};
+
+// Types whose value-initialized state is all zero bytes, so zeroed memory
+// already holds value-initialized objects. Specialize for such aggregates.
+template<typename T>
+struct is_zero_initializable
+    : std::bool_constant<std::is_arithmetic_v<T> || std::is_enum_v<T> || std::is_pointer_v<T>> {};
+
+// Whether containers may take zeroed memory from A for value-initialized
+// elements instead of running the construct loop.
+template<typename A>
+inline constexpr bool zeroed_value_init_v =
+    has_allocate_zeroed<A>::value && is_zero_initializable<typename std::allocator_traits<A>::value_type>::value;
+
+struct zeroed_t { explicit zeroed_t() = default; };
+inline constexpr zeroed_t zeroed{};
+
+// malloc_allocator with allocate_zeroed through calloc. Large blocks are
+// fresh mappings that calloc does not write, so their pages stay unbacked
+// until first touched.
+template<typename T>
+class zeroing_allocator : public malloc_allocator<T>
+{
+public:
+    using size_type = size_t;
+
+    template<typename U>
+    struct rebind
+    {
+        using other = zeroing_allocator<U>;
+    };
+
+public:
+    zeroing_allocator() noexcept = default;
+
+    template<typename U>
+    zeroing_allocator(const zeroing_allocator<U>&) noexcept {}
+
+    T* allocate_zeroed(size_type n) {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "calloc does not align over-aligned types");
+        auto p = std::calloc(n, sizeof(T));
+        if (p == nullptr && n != 0)
+            throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
 };
 
 } // namespace dl
@@ -0,0 +1,548 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "shrink_policy.h"
+#include "vector.h"
+
+// Runtime-selected allocation: containers hold a polymorphic_allocator that
+// forwards to a memory_resource, so the backing memory (arena, pool, counting
+// wrapper) can change without changing the container type.
+
+namespace dl {
+namespace pmr {
+
+class memory_resource
+{
+public:
+    static constexpr size_t max_align = alignof(std::max_align_t);
+
+    virtual ~memory_resource() = default;
+
+    void* allocate(size_t bytes, size_t align = max_align) {
+        return do_allocate(bytes, align);
+    }
+
+    void deallocate(void* p, size_t bytes, size_t align = max_align) {
+        do_deallocate(p, bytes, align);
+    }
+
+    bool is_equal(const memory_resource& other) const noexcept {
+        return do_is_equal(other);
+    }
+
+protected:
+    virtual void* do_allocate(size_t bytes, size_t align) = 0;
+    virtual void do_deallocate(void* p, size_t bytes, size_t align) = 0;
+    virtual bool do_is_equal(const memory_resource& other) const noexcept {
+        return this == &other;
+    }
+};
+
+inline bool operator==(const memory_resource& lhs, const memory_resource& rhs) noexcept {
+    return &lhs == &rhs || lhs.is_equal(rhs);
+}
+
+inline bool operator!=(const memory_resource& lhs, const memory_resource& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+class new_delete_memory_resource final : public memory_resource
+{
+protected:
+    void* do_allocate(size_t bytes, size_t align) override {
+        if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return ::operator new(bytes, std::align_val_t(align));
+        }
+        return ::operator new(bytes);
+    }
+
+    void do_deallocate(void* p, size_t, size_t align) override {
+        if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            ::operator delete(p, std::align_val_t(align));
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return dynamic_cast<const new_delete_memory_resource*>(&other) != nullptr;
+    }
+};
+
+// Fails every allocation; as an upstream it turns "must not allocate" into an exception.
+class null_memory_resource_impl final : public memory_resource
+{
+protected:
+    void* do_allocate(size_t, size_t) override {
+        throw std::bad_alloc();
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+};
+
+inline memory_resource* new_delete_resource() noexcept {
+    static new_delete_memory_resource resource;
+    return &resource;
+}
+
+inline memory_resource* null_memory_resource() noexcept {
+    static null_memory_resource_impl resource;
+    return &resource;
+}
+
+inline std::atomic<memory_resource*>& default_resource() noexcept {
+    static std::atomic<memory_resource*> resource{new_delete_resource()};
+    return resource;
+}
+
+inline memory_resource* get_default_resource() noexcept {
+    return default_resource().load(std::memory_order_acquire);
+}
+
+// Returns the previous default; nullptr restores new_delete_resource().
+inline memory_resource* set_default_resource(memory_resource* r) noexcept {
+    return default_resource().exchange(r ? r : new_delete_resource(), std::memory_order_acq_rel);
+}
+
+// Forwards to an upstream resource and keeps allocation statistics.
+class counting_resource final : public memory_resource
+{
+public:
+    explicit counting_resource(memory_resource* upstream = get_default_resource()) noexcept
+        : upstream_(upstream) {}
+
+    counting_resource(const counting_resource&) = delete;
+    counting_resource& operator=(const counting_resource&) = delete;
+
+    memory_resource* upstream_resource() const noexcept { return upstream_; }
+
+    size_t allocations() const noexcept   { return allocations_.load(std::memory_order_relaxed); }
+    size_t deallocations() const noexcept { return deallocations_.load(std::memory_order_relaxed); }
+    size_t bytes_in_use() const noexcept  { return in_use_.load(std::memory_order_relaxed); }
+    size_t peak_bytes() const noexcept    { return peak_.load(std::memory_order_relaxed); }
+
+protected:
+    void* do_allocate(size_t bytes, size_t align) override {
+        auto p = upstream_->allocate(bytes, align);
+        allocations_.fetch_add(1, std::memory_order_relaxed);
+        auto in_use = in_use_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        auto peak = peak_.load(std::memory_order_relaxed);
+        while (in_use > peak && !peak_.compare_exchange_weak(peak, in_use, std::memory_order_relaxed)) {
+        }
+        return p;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t align) override {
+        upstream_->deallocate(p, bytes, align);
+        deallocations_.fetch_add(1, std::memory_order_relaxed);
+        in_use_.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+private:
+    memory_resource* upstream_;
+    std::atomic<size_t> allocations_{0};
+    std::atomic<size_t> deallocations_{0};
+    std::atomic<size_t> in_use_{0};
+    std::atomic<size_t> peak_{0};
+};
+
+// Bump allocator: deallocate is a no-op, everything is returned by release()
+// or the destructor. Buffers obtained from upstream double in size.
+class monotonic_buffer_resource final : public memory_resource
+{
+public:
+    explicit monotonic_buffer_resource(memory_resource* upstream = get_default_resource()) noexcept
+        : upstream_(upstream) {}
+
+    explicit monotonic_buffer_resource(size_t initial_size,
+                                       memory_resource* upstream = get_default_resource()) noexcept
+        : upstream_(upstream)
+        , next_size_(std::max<size_t>(initial_size, sizeof(chunk) * 2)) {}
+
+    monotonic_buffer_resource(void* buffer, size_t size,
+                              memory_resource* upstream = get_default_resource()) noexcept
+        : upstream_(upstream)
+        , buffer_(buffer)
+        , buffer_size_(size)
+        , current_(buffer)
+        , remaining_(size)
+        , next_size_(std::max<size_t>(size * 2, min_chunk)) {}
+
+    monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+    monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+    ~monotonic_buffer_resource() override {
+        release();
+    }
+
+    void release() noexcept {
+        while (chunks_ != nullptr) {
+            auto next = chunks_->next;
+            upstream_->deallocate(chunks_, chunks_->bytes, alignof(std::max_align_t));
+            chunks_ = next;
+        }
+        current_ = buffer_;
+        remaining_ = buffer_size_;
+    }
+
+    memory_resource* upstream_resource() const noexcept { return upstream_; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t align) override {
+        if (void* p = std::align(align, bytes, current_, remaining_)) {
+            current_ = static_cast<char*>(current_) + bytes;
+            remaining_ -= bytes;
+            return p;
+        }
+        auto need = sizeof(chunk) + bytes + align;
+        auto size = std::max(next_size_, need);
+        auto c = static_cast<chunk*>(upstream_->allocate(size, alignof(std::max_align_t)));
+        c->next = chunks_;
+        c->bytes = size;
+        chunks_ = c;
+        next_size_ = size < std::numeric_limits<size_t>::max() / 2 ? size * 2 : size;
+        current_ = c + 1;
+        remaining_ = size - sizeof(chunk);
+        void* p = std::align(align, bytes, current_, remaining_);
+        current_ = static_cast<char*>(current_) + bytes;
+        remaining_ -= bytes;
+        return p;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+private:
+    struct alignas(std::max_align_t) chunk
+    {
+        chunk* next;
+        size_t bytes;
+    };
+
+    static constexpr size_t min_chunk = 1024;
+
+    memory_resource* upstream_;
+    void* buffer_ = nullptr;
+    size_t buffer_size_ = 0;
+    void* current_ = nullptr;
+    size_t remaining_ = 0;
+    size_t next_size_ = min_chunk;
+    chunk* chunks_ = nullptr;
+};
+
+struct pool_options
+{
+    size_t max_blocks_per_chunk = 0;        // 0: implementation default
+    size_t largest_required_pool_block = 0; // 0: implementation default
+};
+
+// Power-of-two size classes with intrusive free lists. Larger requests go to
+// upstream directly but are still tracked so release() returns everything.
+class unsynchronized_pool_resource final : public memory_resource
+{
+public:
+    explicit unsynchronized_pool_resource(memory_resource* upstream = get_default_resource()) noexcept
+        : unsynchronized_pool_resource(pool_options(), upstream) {}
+
+    explicit unsynchronized_pool_resource(const pool_options& opts,
+                                          memory_resource* upstream = get_default_resource()) noexcept
+        : upstream_(upstream) {
+        auto largest = opts.largest_required_pool_block != 0
+            ? std::min(opts.largest_required_pool_block, max_pool_block)
+            : default_largest_block;
+        size_t idx = 0;
+        while (idx + 1 < num_pools && block_size(idx) < largest) {
+            ++idx;
+        }
+        pool_count_ = idx + 1;
+        max_blocks_ = opts.max_blocks_per_chunk != 0 ? opts.max_blocks_per_chunk : default_max_blocks;
+    }
+
+    unsynchronized_pool_resource(const unsynchronized_pool_resource&) = delete;
+    unsynchronized_pool_resource& operator=(const unsynchronized_pool_resource&) = delete;
+
+    ~unsynchronized_pool_resource() override {
+        release();
+    }
+
+    void release() noexcept {
+        for (size_t i = 0; i < pool_count_; ++i) {
+            auto& pool = pools_[i];
+            while (pool.chunks != nullptr) {
+                auto footer = pool.chunks;
+                pool.chunks = footer->next;
+                upstream_->deallocate(footer->base, footer->bytes, footer->align);
+            }
+            pool = pool_state();
+        }
+        while (large_ != nullptr) {
+            auto h = large_;
+            large_ = h->next;
+            upstream_->deallocate(h->base, h->bytes, h->align);
+        }
+    }
+
+    memory_resource* upstream_resource() const noexcept { return upstream_; }
+
+    pool_options options() const noexcept {
+        return pool_options{max_blocks_, block_size(pool_count_ - 1)};
+    }
+
+protected:
+    void* do_allocate(size_t bytes, size_t align) override {
+        auto idx = pool_index(bytes, align);
+        if (idx >= pool_count_) {
+            return allocate_large(bytes, align);
+        }
+        auto& pool = pools_[idx];
+        if (pool.free == nullptr) {
+            refill(pool, block_size(idx));
+        }
+        auto block = pool.free;
+        pool.free = block->next;
+        return block;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t align) override {
+        if (p == nullptr) {
+            return;
+        }
+        auto idx = pool_index(bytes, align);
+        if (idx >= pool_count_) {
+            deallocate_large(p);
+            return;
+        }
+        auto block = static_cast<free_block*>(p);
+        block->next = pools_[idx].free;
+        pools_[idx].free = block;
+    }
+
+private:
+    struct free_block
+    {
+        free_block* next;
+    };
+
+    struct chunk_footer
+    {
+        chunk_footer* next;
+        void* base;
+        size_t bytes;
+        size_t align;
+    };
+
+    struct large_header
+    {
+        large_header* prev;
+        large_header* next;
+        void* base;
+        size_t bytes;
+        size_t align;
+    };
+
+    struct pool_state
+    {
+        free_block* free = nullptr;
+        chunk_footer* chunks = nullptr;
+        size_t next_blocks = 0;
+    };
+
+    static constexpr size_t min_block_shift = 3;
+    static constexpr size_t num_pools = 28;
+    static constexpr size_t max_pool_block = size_t(1) << (min_block_shift + num_pools - 1);
+    static constexpr size_t default_largest_block = size_t(1) << 16;
+    static constexpr size_t default_max_blocks = 1024;
+    static constexpr size_t max_chunk_align = 4096;
+    static constexpr size_t target_chunk_bytes = size_t(4) << 20;
+
+    static constexpr size_t block_size(size_t idx) noexcept {
+        return size_t(1) << (idx + min_block_shift);
+    }
+
+    size_t pool_index(size_t bytes, size_t align) const noexcept {
+        auto size = std::max({bytes, align, size_t(1) << min_block_shift});
+        if (align > max_chunk_align || size > block_size(pool_count_ - 1)) {
+            return num_pools;
+        }
+        size_t idx = 0;
+        while (block_size(idx) < size) {
+            ++idx;
+        }
+        return idx;
+    }
+
+    void refill(pool_state& pool, size_t block) {
+        if (pool.next_blocks == 0) {
+            pool.next_blocks = std::max<size_t>(1, 4096 / block);
+        }
+        auto blocks = pool.next_blocks;
+        auto bytes = blocks * block + sizeof(chunk_footer);
+        auto align = std::clamp(block, alignof(std::max_align_t), max_chunk_align);
+        auto base = static_cast<char*>(upstream_->allocate(bytes, align));
+        auto footer = reinterpret_cast<chunk_footer*>(base + blocks * block);
+        *footer = chunk_footer{pool.chunks, base, bytes, align};
+        pool.chunks = footer;
+        for (size_t i = blocks; i-- != 0;) {
+            auto b = reinterpret_cast<free_block*>(base + i * block);
+            b->next = pool.free;
+            pool.free = b;
+        }
+        auto cap = std::max<size_t>(1, std::min(max_blocks_, target_chunk_bytes / block));
+        pool.next_blocks = std::min(blocks * 2, cap);
+    }
+
+    void* allocate_large(size_t bytes, size_t align) {
+        align = std::max(align, alignof(large_header));
+        auto offset = (sizeof(large_header) + align - 1) / align * align;
+        auto total = offset + bytes;
+        auto base = static_cast<char*>(upstream_->allocate(total, align));
+        auto p = base + offset;
+        auto h = reinterpret_cast<large_header*>(p) - 1;
+        *h = large_header{nullptr, large_, base, total, align};
+        if (large_ != nullptr) {
+            large_->prev = h;
+        }
+        large_ = h;
+        return p;
+    }
+
+    void deallocate_large(void* p) {
+        auto h = static_cast<large_header*>(p) - 1;
+        if (h->prev != nullptr) {
+            h->prev->next = h->next;
+        } else {
+            large_ = h->next;
+        }
+        if (h->next != nullptr) {
+            h->next->prev = h->prev;
+        }
+        upstream_->deallocate(h->base, h->bytes, h->align);
+    }
+
+private:
+    memory_resource* upstream_;
+    pool_state pools_[num_pools];
+    size_t pool_count_ = 0;
+    size_t max_blocks_ = default_max_blocks;
+    large_header* large_ = nullptr;
+};
+
+// unsynchronized_pool_resource behind a mutex.
+class synchronized_pool_resource final : public memory_resource
+{
+public:
+    explicit synchronized_pool_resource(memory_resource* upstream = get_default_resource()) noexcept
+        : pool_(upstream) {}
+
+    explicit synchronized_pool_resource(const pool_options& opts,
+                                        memory_resource* upstream = get_default_resource()) noexcept
+        : pool_(opts, upstream) {}
+
+    void release() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pool_.release();
+    }
+
+    memory_resource* upstream_resource() const noexcept { return pool_.upstream_resource(); }
+    pool_options options() const noexcept { return pool_.options(); }
+
+protected:
+    void* do_allocate(size_t bytes, size_t align) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pool_.allocate(bytes, align);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t align) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pool_.deallocate(p, bytes, align);
+    }
+
+private:
+    std::mutex mutex_;
+    unsynchronized_pool_resource pool_;
+};
+
+// Like std::pmr::polymorphic_allocator: never propagates on copy, move or
+// swap, copies of a container use the default resource, and elements that
+// take an allocator are built with this one (uses-allocator construction).
+template<typename T>
+class polymorphic_allocator
+{
+public:
+    using value_type = T;
+
+public:
+    polymorphic_allocator() noexcept
+        : resource_(get_default_resource()) {}
+
+    polymorphic_allocator(memory_resource* r) noexcept
+        : resource_(r) {}
+
+    polymorphic_allocator(const polymorphic_allocator&) = default;
+
+    template<typename U>
+    polymorphic_allocator(const polymorphic_allocator<U>& other) noexcept
+        : resource_(other.resource()) {}
+
+    polymorphic_allocator& operator=(const polymorphic_allocator&) = delete;
+
+    T* allocate(size_t n) {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    // Containers release their null buffer too; it never reaches the resource.
+    void deallocate(T* p, size_t n) noexcept {
+        if (p != nullptr) {
+            resource_->deallocate(p, n * sizeof(T), alignof(T));
+        }
+    }
+
+    template<typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        if constexpr (std::uses_allocator_v<U, polymorphic_allocator>
+                      && std::is_constructible_v<U, Args..., const polymorphic_allocator&>) {
+            ::new (static_cast<void*>(p)) U(std::forward<Args>(args)..., *this);
+        } else {
+            ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+        }
+    }
+
+    template<typename U>
+    void destroy(U* p) {
+        p->~U();
+    }
+
+    polymorphic_allocator select_on_container_copy_construction() const noexcept {
+        return polymorphic_allocator();
+    }
+
+    memory_resource* resource() const noexcept { return resource_; }
+
+private:
+    memory_resource* resource_;
+};
+
+template<typename T, typename U>
+bool operator==(const polymorphic_allocator<T>& lhs, const polymorphic_allocator<U>& rhs) noexcept {
+    return *lhs.resource() == *rhs.resource();
+}
+
+template<typename T, typename U>
+bool operator!=(const polymorphic_allocator<T>& lhs, const polymorphic_allocator<U>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template<typename T, typename ShrinkPolicy = no_shrink>
+using vector = dl::vector<T, polymorphic_allocator<T>, ShrinkPolicy>;
+
+} // namespace pmr
+} // namespace dl
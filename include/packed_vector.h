@@ -0,0 +1,374 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "type_utils.h"
+#include "vector.h"
+
+namespace dl {
+
+inline constexpr uint64_t low_mask(unsigned width) noexcept {
+    return width >= 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+}
+
+inline constexpr unsigned required_bits(uint64_t value) noexcept {
+    unsigned n = 0;
+    for (; value != 0; value >>= 1) {
+        ++n;
+    }
+    return n;
+}
+
+// words[bit / 64 + 1] must be readable, the containers below keep a spare word for it.
+inline uint64_t read_bits(const uint64_t* words, uint64_t bit, unsigned width) noexcept {
+    auto idx = bit >> 6;
+    auto off = static_cast<unsigned>(bit & 63);
+    auto v = (words[idx] >> off) | ((words[idx + 1] << 1) << (63 - off));
+    return v & low_mask(width);
+}
+
+inline void write_bits(uint64_t* words, uint64_t bit, unsigned width, uint64_t value) noexcept {
+    auto idx = bit >> 6;
+    auto off = static_cast<unsigned>(bit & 63);
+    auto mask = low_mask(width);
+    value &= mask;
+    words[idx] = (words[idx] & ~(mask << off)) | (value << off);
+    if (off + width > 64) {
+        auto shift = 64 - off;
+        words[idx + 1] = (words[idx + 1] & ~(mask >> shift)) | (value >> shift);
+    }
+}
+
+template<unsigned Width, typename T>
+void unpack_bits(const uint64_t* words, size_t first, size_t n, T* out) noexcept {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<T>(read_bits(words, (first + i) * Width, Width));
+    }
+}
+
+template<typename T, size_t... Ws>
+auto make_unpack_table(std::index_sequence<Ws...>) {
+    using fn = void (*)(const uint64_t*, size_t, size_t, T*);
+    return std::array<fn, sizeof...(Ws)>{&unpack_bits<Ws + 1, T>...};
+}
+
+template<typename T, typename Allocator = std::allocator<T>>
+class packed_vector
+{
+    static_assert(std::is_integral_v<T> && std::is_unsigned_v<T>, "packed_vector stores unsigned integers");
+
+public: // aliases
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using word_type = uint64_t;
+    using word_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<word_type>;
+
+    static constexpr unsigned max_width = sizeof(value_type) * 8;
+
+public: // constructors
+    explicit packed_vector(unsigned width, const allocator_type& a = allocator_type())
+        : words_(size_type(1), word_type(0), word_allocator(a))
+        , width_(width) {
+        if (width == 0 || width > max_width)
+            throw std::invalid_argument("packed_vector bit width out of range");
+    }
+
+    packed_vector(unsigned width, size_type count, value_type value,
+                  const allocator_type& a = allocator_type())
+        : packed_vector(width, a) {
+        resize(count, value);
+    }
+
+    template<typename I,
+             std::enable_if_t<is_input_iter<I>::value, int> = 0>
+    packed_vector(unsigned width, I first, I last, const allocator_type& a = allocator_type())
+        : packed_vector(width, a) {
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+public: // access members
+    value_type operator[](size_type i) const noexcept {
+        return static_cast<value_type>(read_bits(words_.data(), i * width_, width_));
+    }
+
+    value_type at(size_type i) const {
+        if (i >= size())
+            throw std::out_of_range("packed_vector index out of bounds");
+        return (*this)[i];
+    }
+
+    value_type front() const noexcept { return (*this)[0]; }
+    value_type back() const noexcept  { return (*this)[size_ - 1]; }
+
+    unsigned bit_width() const noexcept { return width_; }
+    size_type size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    size_type capacity() const noexcept {
+        return (words_.capacity() - 1) * 64 / width_;
+    }
+
+    size_type memory_bytes() const noexcept {
+        return words_.capacity() * sizeof(word_type);
+    }
+
+    const word_type* words() const noexcept { return words_.data(); }
+
+    allocator_type get_allocator() const noexcept {
+        return allocator_type(words_.get_allocator());
+    }
+
+    void unpack(size_type first, size_type n, value_type* out) const noexcept {
+        static const auto table = make_unpack_table<value_type>(std::make_index_sequence<max_width>());
+        if (width_ == max_width) {
+            std::memcpy(out, reinterpret_cast<const char*>(words_.data()) + first * sizeof(value_type),
+                        n * sizeof(value_type));
+        } else {
+            table[width_ - 1](words_.data(), first, n, out);
+        }
+    }
+
+    template<typename A>
+    void unpack(vector<value_type, A>& out) const {
+        out.resize(size_);
+        unpack(0, size_, out.data());
+    }
+
+public: // modification members
+    void set(size_type i, value_type value) noexcept {
+        write_bits(words_.data(), i * width_, width_, value);
+    }
+
+    void push_back(value_type value) {
+        auto need = words_for(size_ + 1);
+        while (words_.size() < need) {
+            words_.emplace_back(0);
+        }
+        set(size_++, value);
+    }
+
+    void pop_back() noexcept {
+        --size_;
+    }
+
+    void reserve(size_type n) {
+        words_.reserve(words_for(n));
+    }
+
+    void resize(size_type n, value_type value = value_type()) {
+        words_.resize(words_for(n), 0);
+        for (; size_ < n; ++size_) {
+            set(size_, value);
+        }
+        size_ = n;
+    }
+
+    void clear() noexcept {
+        words_.resize(1);
+        words_[0] = 0;
+        size_ = 0;
+    }
+
+    void shrink_to_fit() {
+        words_.shrink_to_fit();
+    }
+
+    void swap(packed_vector& other) noexcept {
+        words_.swap(other.words_);
+        std::swap(size_, other.size_);
+        std::swap(width_, other.width_);
+    }
+
+private:
+    size_type words_for(size_type n) const noexcept {
+        return (n * width_ + 63) / 64 + 1;
+    }
+
+private:
+    vector<word_type, word_allocator> words_;
+    size_type size_ = 0;
+    unsigned width_;
+};
+
+template<typename T, size_t BlockSize = 128, typename Allocator = std::allocator<T>>
+class delta_packed_vector
+{
+    static_assert(std::is_integral_v<T> && std::is_unsigned_v<T>, "delta_packed_vector stores unsigned integers");
+    static_assert(BlockSize > 1, "Block must hold base and deltas");
+
+public: // aliases
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+    using word_type = uint64_t;
+
+    static constexpr size_type block_size = BlockSize;
+
+    // Skip pointer: first value of the block and bit offset of its deltas in the stream.
+    struct block
+    {
+        value_type base;
+        uint64_t offset;
+        unsigned width;
+    };
+
+private:
+    template<typename U>
+    using rebind = typename std::allocator_traits<allocator_type>::template rebind_alloc<U>;
+
+public: // constructors
+    explicit delta_packed_vector(const allocator_type& a = allocator_type())
+        : blocks_(rebind<block>(a))
+        , stream_(size_type(1), word_type(0), rebind<word_type>(a))
+        , tail_(a) {}
+
+    template<typename I,
+             std::enable_if_t<is_input_iter<I>::value, int> = 0>
+    delta_packed_vector(I first, I last, const allocator_type& a = allocator_type())
+        : delta_packed_vector(a) {
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+public: // access members
+    value_type operator[](size_type i) const noexcept {
+        auto b = i / block_size;
+        auto k = i % block_size;
+        if (b == blocks_.size()) {
+            return tail_[k];
+        }
+        const auto& blk = blocks_[b];
+        auto value = blk.base;
+        if (blk.width != 0) {
+            for (size_type j = 0; j < k; ++j) {
+                value += static_cast<value_type>(read_bits(stream_.data(), blk.offset + j * blk.width, blk.width));
+            }
+        }
+        return value;
+    }
+
+    value_type at(size_type i) const {
+        if (i >= size())
+            throw std::out_of_range("delta_packed_vector index out of bounds");
+        return (*this)[i];
+    }
+
+    value_type back() const noexcept { return last_; }
+
+    size_type size() const noexcept { return blocks_.size() * block_size + tail_.size(); }
+    bool empty() const noexcept { return size() == 0; }
+
+    const vector<block, rebind<block>>& blocks() const noexcept { return blocks_; }
+
+    size_type memory_bytes() const noexcept {
+        return blocks_.capacity() * sizeof(block)
+            + stream_.capacity() * sizeof(word_type)
+            + tail_.capacity() * sizeof(value_type);
+    }
+
+    // Index of the first element not less than value, size() if there is none.
+    size_type lower_bound(value_type value) const noexcept {
+        auto it = std::partition_point(blocks_.begin(), blocks_.end(),
+                                       [&](const block& blk) { return blk.base < value; });
+        auto b = static_cast<size_type>(it - blocks_.begin());
+        if (b != 0) {
+            const auto& blk = blocks_[b - 1];
+            auto cur = blk.base;
+            for (size_type j = 1; j < block_size; ++j) {
+                cur += static_cast<value_type>(read_bits(stream_.data(), blk.offset + (j - 1) * blk.width, blk.width));
+                if (cur >= value) {
+                    return (b - 1) * block_size + j;
+                }
+            }
+        }
+        if (b != blocks_.size()) {
+            return b * block_size;
+        }
+        return b * block_size + static_cast<size_type>(std::lower_bound(tail_.begin(), tail_.end(), value) - tail_.begin());
+    }
+
+    template<typename A>
+    void unpack(vector<value_type, A>& out) const {
+        out.resize(size());
+        auto dst = out.data();
+        for (const auto& blk : blocks_) {
+            decode_block(blk, dst);
+            dst += block_size;
+        }
+        std::copy(tail_.begin(), tail_.end(), dst);
+    }
+
+public: // modification members
+    void push_back(value_type value) {
+        if (!empty() && value < last_)
+            throw std::invalid_argument("delta_packed_vector requires sorted input");
+        if (tail_.capacity() == 0) {
+            tail_.reserve(block_size);
+        }
+        tail_.push_back(value);
+        last_ = value;
+        if (tail_.size() == block_size) {
+            flush_block();
+        }
+    }
+
+    void clear() noexcept {
+        blocks_.clear();
+        stream_.resize(1);
+        stream_[0] = 0;
+        tail_.clear();
+        stream_bits_ = 0;
+    }
+
+private:
+    void decode_block(const block& blk, value_type* out) const noexcept {
+        value_type deltas[block_size - 1];
+        if (blk.width == 0) {
+            std::fill(deltas, deltas + block_size - 1, value_type());
+        } else {
+            for (size_type j = 0; j < block_size - 1; ++j) {
+                deltas[j] = static_cast<value_type>(read_bits(stream_.data(), blk.offset + j * blk.width, blk.width));
+            }
+        }
+        out[0] = blk.base;
+        for (size_type j = 1; j < block_size; ++j) {
+            out[j] = out[j - 1] + deltas[j - 1];
+        }
+    }
+
+    void flush_block() {
+        value_type max_delta = 0;
+        for (size_type j = 1; j < block_size; ++j) {
+            max_delta = std::max<value_type>(max_delta, tail_[j] - tail_[j - 1]);
+        }
+        auto width = required_bits(max_delta);
+        auto bits = stream_bits_ + (block_size - 1) * width;
+        stream_.resize((bits + 63) / 64 + 1, 0);
+        for (size_type j = 1; j < block_size; ++j) {
+            write_bits(stream_.data(), stream_bits_ + (j - 1) * width, width, tail_[j] - tail_[j - 1]);
+        }
+        blocks_.push_back(block{tail_[0], stream_bits_, width});
+        stream_bits_ = bits;
+        tail_.clear();
+    }
+
+private:
+    vector<block, rebind<block>> blocks_;
+    vector<word_type, rebind<word_type>> stream_;
+    vector<value_type, allocator_type> tail_;
+    uint64_t stream_bits_ = 0;
+    value_type last_ = value_type();
+};
+
+} // namespace dl
@@ -0,0 +1,285 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "prefault.h"
+
+namespace dl {
+
+inline constexpr size_t huge_page_size = size_t(2) << 20;
+
+// Anonymous mapping of bytes (a multiple of align) aligned to align, nullptr on failure.
+inline void* map_aligned(size_t bytes, size_t align, int extra_flags = 0) noexcept {
+    auto len = bytes + align;
+    void* p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    if (p == MAP_FAILED) {
+        return nullptr;
+    }
+    auto addr = reinterpret_cast<uintptr_t>(p);
+    auto aligned = round_up(addr, align);
+    if (aligned != addr) {
+        ::munmap(p, aligned - addr);
+    }
+    if (auto tail = addr + len - (aligned + bytes); tail != 0) {
+        ::munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+    }
+    return reinterpret_cast<void*>(aligned);
+}
+
+// Gives back the pages of a mapped block past new_bytes. Only blocks that were
+// mapped (at least min_bytes) and stay mapped can shrink this way.
+inline bool unmap_tail(void* p, size_t old_bytes, size_t new_bytes, size_t min_bytes, size_t page) noexcept {
+    if (p == nullptr || old_bytes < min_bytes || new_bytes < min_bytes) {
+        return false;
+    }
+    auto keep = round_up(new_bytes, page);
+    auto mapped = round_up(old_bytes, page);
+    if (keep < mapped) {
+        ::munmap(static_cast<char*>(p) + keep, mapped - keep);
+    }
+    return true;
+}
+
+// Stateless allocator backing large blocks with 2 MB pages: explicit hugetlbfs
+// pages when the kernel has them reserved, transparent huge pages otherwise.
+// Blocks below min_bytes come from operator new.
+template<typename T>
+class hugepage_allocator
+{
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+
+    static constexpr size_t min_bytes = huge_page_size / 2;
+
+public:
+    hugepage_allocator() noexcept = default;
+
+    template<typename U>
+    hugepage_allocator(const hugepage_allocator<U>&) noexcept {}
+
+    T* allocate(size_type n) {
+        if (n > std::numeric_limits<size_type>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        auto bytes = n * sizeof(T);
+        if (bytes < min_bytes) {
+            return static_cast<T*>(::operator new(bytes));
+        }
+        bytes = round_up(bytes, huge_page_size);
+        void* p = nullptr;
+#ifdef MAP_HUGETLB
+        p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p == MAP_FAILED) {
+            p = nullptr;
+        }
+#endif
+        if (p == nullptr) {
+            p = map_aligned(bytes, huge_page_size);
+            if (p == nullptr)
+                throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+            ::madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_type n) noexcept {
+        if (p == nullptr) {
+            return;
+        }
+        auto bytes = n * sizeof(T);
+        if (bytes < min_bytes) {
+            ::operator delete(p);
+        } else {
+            ::munmap(p, round_up(bytes, huge_page_size));
+        }
+    }
+
+    // Unmaps the tail of a mapped block; blocks from operator new stay as they are.
+    bool shrink_in_place(T* p, size_type old_n, size_type new_n) noexcept {
+        return unmap_tail(p, old_n * sizeof(T), new_n * sizeof(T), min_bytes, huge_page_size);
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const hugepage_allocator<T>&, const hugepage_allocator<U>&) noexcept { return true; }
+
+template<typename T, typename U>
+bool operator!=(const hugepage_allocator<T>&, const hugepage_allocator<U>&) noexcept { return false; }
+
+// Maps every block with MAP_POPULATE and mlock()s it, for latency-critical
+// containers: the pages are resident before the first write and are not
+// swapped out. Blocks are whole pages, so this is meant for a few large
+// buffers. mlock() is best effort; past RLIMIT_MEMLOCK a block is only
+// populated. Compaction may still migrate locked pages unless
+// vm.compact_unevictable_allowed is 0.
+template<typename T>
+class locked_allocator
+{
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using is_always_equal = std::true_type;
+
+public:
+    locked_allocator() noexcept = default;
+
+    template<typename U>
+    locked_allocator(const locked_allocator<U>&) noexcept {}
+
+    T* allocate(size_type n) {
+        if (n > std::numeric_limits<size_type>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        auto bytes = block_bytes(n);
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+        ::mlock(p, bytes);
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_type n) noexcept {
+        if (p != nullptr) {
+            ::munmap(p, block_bytes(n));
+        }
+    }
+
+    bool shrink_in_place(T* p, size_type old_n, size_type new_n) noexcept {
+        return unmap_tail(p, old_n * sizeof(T), new_n * sizeof(T), 1, system_page_size());
+    }
+
+private:
+    static size_t block_bytes(size_type n) noexcept {
+        return round_up(n != 0 ? n * sizeof(T) : 1, system_page_size());
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const locked_allocator<T>&, const locked_allocator<U>&) noexcept { return true; }
+
+template<typename T, typename U>
+bool operator!=(const locked_allocator<T>&, const locked_allocator<U>&) noexcept { return false; }
+
+enum class numa_policy
+{
+    local,
+    interleave,
+    bind
+};
+
+// Thin wrappers over the raw syscalls so libnuma is not required.
+inline long sys_mbind(void* addr, size_t len, int mode, const unsigned long* mask, unsigned long maxnode) noexcept {
+#ifdef SYS_mbind
+    return ::syscall(SYS_mbind, addr, len, mode, mask, maxnode, 0);
+#else
+    (void)addr; (void)len; (void)mode; (void)mask; (void)maxnode;
+    return -1;
+#endif
+}
+
+inline unsigned long numa_allowed_nodes() noexcept {
+    unsigned long mask = 0;
+#ifdef SYS_get_mempolicy
+    constexpr unsigned long mpol_f_mems_allowed = 4;
+    int mode = 0;
+    if (::syscall(SYS_get_mempolicy, &mode, &mask, sizeof(mask) * 8, nullptr, mpol_f_mems_allowed) != 0) {
+        mask = 0;
+    }
+#endif
+    return mask != 0 ? mask : 1;
+}
+
+// Places pages of large blocks according to a NUMA policy with mbind().
+// If the kernel refuses (no NUMA, seccomp, EPERM) memory keeps the default policy.
+template<typename T>
+class numa_allocator
+{
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using is_always_equal = std::true_type; // any instance can unmap any block
+
+    static constexpr size_t min_bytes = size_t(64) << 10;
+
+public:
+    explicit numa_allocator(numa_policy policy = numa_policy::interleave,
+                            unsigned long nodes = numa_allowed_nodes()) noexcept
+        : policy_(policy)
+        , nodes_(nodes) {}
+
+    template<typename U>
+    numa_allocator(const numa_allocator<U>& other) noexcept
+        : policy_(other.policy())
+        , nodes_(other.nodes()) {}
+
+    T* allocate(size_type n) {
+        if (n > std::numeric_limits<size_type>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        auto bytes = n * sizeof(T);
+        if (bytes < min_bytes) {
+            return static_cast<T*>(::operator new(bytes));
+        }
+        bytes = round_up(bytes, system_page_size());
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+        constexpr int mpol_preferred = 1;
+        constexpr int mpol_bind = 2;
+        constexpr int mpol_interleave = 3;
+        constexpr int mpol_local = 4;
+        switch (policy_) {
+        case numa_policy::local:
+            if (sys_mbind(p, bytes, mpol_local, nullptr, 0) != 0) {
+                sys_mbind(p, bytes, mpol_preferred, nullptr, 0);
+            }
+            break;
+        case numa_policy::interleave:
+            sys_mbind(p, bytes, mpol_interleave, &nodes_, sizeof(nodes_) * 8);
+            break;
+        case numa_policy::bind:
+            sys_mbind(p, bytes, mpol_bind, &nodes_, sizeof(nodes_) * 8);
+            break;
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, size_type n) noexcept {
+        if (p == nullptr) {
+            return;
+        }
+        auto bytes = n * sizeof(T);
+        if (bytes < min_bytes) {
+            ::operator delete(p);
+        } else {
+            ::munmap(p, round_up(bytes, system_page_size()));
+        }
+    }
+
+    bool shrink_in_place(T* p, size_type old_n, size_type new_n) noexcept {
+        return unmap_tail(p, old_n * sizeof(T), new_n * sizeof(T), min_bytes, system_page_size());
+    }
+
+    numa_policy policy() const noexcept { return policy_; }
+    unsigned long nodes() const noexcept { return nodes_; }
+
+private:
+    numa_policy policy_;
+    unsigned long nodes_;
+};
+
+template<typename T, typename U>
+bool operator==(const numa_allocator<T>&, const numa_allocator<U>&) noexcept { return true; }
+
+template<typename T, typename U>
+bool operator!=(const numa_allocator<T>&, const numa_allocator<U>&) noexcept { return false; }
+
+} // namespace dl
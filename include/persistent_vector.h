@@ -0,0 +1,621 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include "compressed_pair.h"
+#include "pool_allocator.h"
+#include "type_utils.h"
+
+namespace dl {
+
+// Immutable vector as a 32-way trie of reference counted nodes plus a tail
+// leaf holding the last up to 32 elements (the Clojure layout). set,
+// push_back and pop_back on an lvalue return a new version that copies only
+// the path to the changed leaf and shares everything else. Nodes referenced
+// by a single version are changed in place, so calling them on an rvalue or
+// through transient() costs about as much as on dl::vector.
+template<typename T, typename Allocator = pool_allocator<T>>
+class persistent_vector
+{
+    static constexpr unsigned bits = 5;
+    static constexpr size_t width = size_t(1) << bits;
+    static constexpr size_t mask = width - 1;
+
+    struct node
+    {
+        std::atomic<uint32_t> refs{1};
+    };
+
+    struct inner : node
+    {
+        node* child[width] = {};
+    };
+
+    struct leaf : node
+    {
+        T* values() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+        const T* values() const noexcept { return std::launder(reinterpret_cast<const T*>(storage)); }
+
+        alignas(T) unsigned char storage[sizeof(T) * width];
+    };
+
+public: // aliases
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+
+    class const_iterator;
+    using iterator = const_iterator;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using reverse_iterator = const_reverse_iterator;
+
+    class transient_type;
+
+public: // constructors
+    persistent_vector() = default;
+
+    explicit persistent_vector(const allocator_type& a) noexcept
+        : size_allocator_(0, a) {}
+
+    template<typename Iter, typename = std::enable_if_t<is_input_iter<Iter>::value>>
+    persistent_vector(Iter first, Iter last, const allocator_type& a = allocator_type())
+        : size_allocator_(0, a) {
+        for (; first != last; ++first) {
+            emplace_back_in_place(*first);
+        }
+    }
+
+    persistent_vector(std::initializer_list<value_type> list, const allocator_type& a = allocator_type())
+        : persistent_vector(list.begin(), list.end(), a) {}
+
+    // Versions share nodes, so a copy always keeps the allocator.
+    persistent_vector(const persistent_vector& other) noexcept
+        : root_(other.root_)
+        , tail_(other.tail_)
+        , shift_(other.shift_)
+        , size_allocator_(other.size(), other.alloc()) {
+        retain(root_);
+        retain(tail_);
+    }
+
+    persistent_vector(persistent_vector&& other) noexcept
+        : root_(std::exchange(other.root_, nullptr))
+        , tail_(std::exchange(other.tail_, nullptr))
+        , shift_(std::exchange(other.shift_, bits))
+        , size_allocator_(std::exchange(other.size_ref(), 0), other.alloc()) {}
+
+    persistent_vector& operator=(const persistent_vector& other) noexcept {
+        persistent_vector(other).swap(*this);
+        return *this;
+    }
+
+    persistent_vector& operator=(persistent_vector&& other) noexcept {
+        persistent_vector(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~persistent_vector() {
+        release_tree(root_, shift_);
+        release_leaf(tail_, tail_size());
+    }
+
+public: // access members
+    const_reference operator[](size_type i) const noexcept {
+        assert(i < size());
+        return leaf_for(i)->values()[i & mask];
+    }
+
+    const_reference at(size_type i) const {
+        if (i >= size())
+            throw std::out_of_range("persistent_vector: index out of bounds");
+        return (*this)[i];
+    }
+
+    const_reference front() const noexcept { return (*this)[0]; }
+    const_reference back() const noexcept  { return tail_->values()[tail_size() - 1]; }
+
+    const_iterator begin() const noexcept  { return const_iterator(this, 0); }
+    const_iterator end() const noexcept    { return const_iterator(this, size()); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept   { return end(); }
+
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const noexcept   { return const_reverse_iterator(begin()); }
+
+    size_type size() const noexcept { return size_allocator_.first(); }
+    bool empty() const noexcept     { return size() == 0; }
+
+    allocator_type get_allocator() const noexcept { return alloc(); }
+
+    // Whether the elements at i live in the same leaf in both versions.
+    bool shares_leaf(const persistent_vector& other, size_type i) const noexcept {
+        return leaf_for(i) == other.leaf_for(i);
+    }
+
+public: // modification members
+    persistent_vector set(size_type i, const value_type& value) const& {
+        return persistent_vector(*this).set(i, value);
+    }
+
+    persistent_vector set(size_type i, const value_type& value) && {
+        set_in_place(i, value);
+        return std::move(*this);
+    }
+
+    persistent_vector push_back(const value_type& value) const& {
+        return persistent_vector(*this).push_back(value);
+    }
+
+    persistent_vector push_back(const value_type& value) && {
+        emplace_back_in_place(value);
+        return std::move(*this);
+    }
+
+    persistent_vector push_back(value_type&& value) const& {
+        return persistent_vector(*this).push_back(std::move(value));
+    }
+
+    persistent_vector push_back(value_type&& value) && {
+        emplace_back_in_place(std::move(value));
+        return std::move(*this);
+    }
+
+    persistent_vector pop_back() const& {
+        return persistent_vector(*this).pop_back();
+    }
+
+    persistent_vector pop_back() && {
+        pop_back_in_place();
+        return std::move(*this);
+    }
+
+    // Mutable view for batches of changes; see transient_type.
+    transient_type transient() const& { return transient_type(*this); }
+    transient_type transient() &&     { return transient_type(std::move(*this)); }
+
+    void swap(persistent_vector& other) noexcept {
+        std::swap(root_, other.root_);
+        std::swap(tail_, other.tail_);
+        std::swap(shift_, other.shift_);
+        std::swap(size_ref(), other.size_ref());
+        std::swap(alloc(), other.alloc());
+    }
+
+private:
+    using leaf_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<leaf>;
+    using inner_allocator = typename std::allocator_traits<allocator_type>::template rebind_alloc<inner>;
+    using leaf_traits = std::allocator_traits<leaf_allocator>;
+    using inner_traits = std::allocator_traits<inner_allocator>;
+
+    allocator_type& alloc() noexcept             { return size_allocator_.second(); }
+    const allocator_type& alloc() const noexcept { return size_allocator_.second(); }
+    size_type& size_ref() noexcept               { return size_allocator_.first(); }
+
+    // Elements in the trie; the rest are in the tail.
+    size_type tail_offset() const noexcept {
+        return size() < width ? 0 : ((size() - 1) >> bits) << bits;
+    }
+
+    size_type tail_size() const noexcept { return size() - tail_offset(); }
+
+    const leaf* leaf_for(size_type i) const noexcept {
+        if (i >= tail_offset()) {
+            return tail_;
+        }
+        const node* n = root_;
+        for (unsigned level = shift_; level > 0; level -= bits) {
+            n = static_cast<const inner*>(n)->child[(i >> level) & mask];
+        }
+        return static_cast<const leaf*>(n);
+    }
+
+    static void retain(node* n) noexcept {
+        if (n != nullptr) {
+            n->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static bool unique(const node* n) noexcept {
+        return n->refs.load(std::memory_order_acquire) == 1;
+    }
+
+    leaf* make_leaf() {
+        leaf_allocator a(alloc());
+        auto l = leaf_traits::allocate(a, 1);
+        ::new (static_cast<void*>(l)) leaf;
+        return l;
+    }
+
+    inner* make_inner() {
+        inner_allocator a(alloc());
+        auto n = inner_traits::allocate(a, 1);
+        ::new (static_cast<void*>(n)) inner;
+        return n;
+    }
+
+    void free_leaf(leaf* l) noexcept {
+        leaf_allocator a(alloc());
+        l->~leaf();
+        leaf_traits::deallocate(a, l, 1);
+    }
+
+    void free_inner(inner* n) noexcept {
+        inner_allocator a(alloc());
+        n->~inner();
+        inner_traits::deallocate(a, n, 1);
+    }
+
+    leaf* copy_leaf(const leaf* src, size_type count) {
+        auto l = make_leaf();
+        size_type i = 0;
+        try {
+            for (; i < count; ++i) {
+                ::new (static_cast<void*>(l->values() + i)) T(src->values()[i]);
+            }
+        } catch (...) {
+            destroy_values(l, i);
+            free_leaf(l);
+            throw;
+        }
+        return l;
+    }
+
+    inner* copy_inner(const inner* src) {
+        auto n = make_inner();
+        for (size_type i = 0; i < width; ++i) {
+            n->child[i] = src->child[i];
+            retain(n->child[i]);
+        }
+        return n;
+    }
+
+    static void destroy_values(leaf* l, size_type count) noexcept {
+        for (size_type i = 0; i < count; ++i) {
+            l->values()[i].~T();
+        }
+    }
+
+    void release_leaf(leaf* l, size_type count) noexcept {
+        if (l != nullptr && l->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            destroy_values(l, count);
+            free_leaf(l);
+        }
+    }
+
+    // Leaves below the root are always full.
+    void release_tree(node* n, unsigned level) noexcept {
+        if (n == nullptr) {
+            return;
+        }
+        if (level == 0) {
+            release_leaf(static_cast<leaf*>(n), width);
+        } else if (n->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            auto in = static_cast<inner*>(n);
+            for (auto c : in->child) {
+                release_tree(c, level - bits);
+            }
+            free_inner(in);
+        }
+    }
+
+    // Replaces a shared node in slot by a private copy.
+    node* own(node*& slot, unsigned level) {
+        if (!unique(slot)) {
+            node* copy = level == 0 ? static_cast<node*>(copy_leaf(static_cast<leaf*>(slot), width))
+                                    : static_cast<node*>(copy_inner(static_cast<inner*>(slot)));
+            release_tree(std::exchange(slot, copy), level);
+        }
+        return slot;
+    }
+
+    void own_tail() {
+        if (!unique(tail_)) {
+            auto count = tail_size();
+            release_leaf(std::exchange(tail_, copy_leaf(tail_, count)), count);
+        }
+    }
+
+    // Chain of inner nodes from level down to the leaf t.
+    node* new_path(unsigned level, leaf* t) {
+        node* n = t;
+        try {
+            for (; level > 0; level -= bits) {
+                auto p = make_inner();
+                p->child[0] = n;
+                n = p;
+            }
+        } catch (...) {
+            while (n != t) {
+                auto p = static_cast<inner*>(n);
+                n = p->child[0];
+                free_inner(p);
+            }
+            throw;
+        }
+        return n;
+    }
+
+    // Moves the full tail into the trie.
+    void push_tail() {
+        auto idx = size() - 1;
+        if (root_ == nullptr) {
+            auto r = make_inner();
+            r->child[0] = tail_;
+            root_ = r;
+            return;
+        }
+        if ((size() >> bits) > (size_type(1) << shift_)) {
+            auto r = make_inner();
+            try {
+                r->child[1] = new_path(shift_, tail_);
+            } catch (...) {
+                free_inner(r);
+                throw;
+            }
+            r->child[0] = root_;
+            root_ = r;
+            shift_ += bits;
+            return;
+        }
+        auto parent = static_cast<inner*>(own(root_, shift_));
+        for (unsigned level = shift_; level > bits; level -= bits) {
+            auto& slot = parent->child[(idx >> level) & mask];
+            if (slot == nullptr) {
+                slot = new_path(level - bits, tail_);
+                return;
+            }
+            parent = static_cast<inner*>(own(slot, level - bits));
+        }
+        parent->child[(idx >> bits) & mask] = tail_;
+    }
+
+    template<typename... Args>
+    void emplace_back_in_place(Args&&... args) {
+        if (tail_ != nullptr && tail_size() < width) {
+            own_tail();
+            ::new (static_cast<void*>(tail_->values() + tail_size())) T(std::forward<Args>(args)...);
+            ++size_ref();
+            return;
+        }
+        auto next = make_leaf();
+        try {
+            ::new (static_cast<void*>(next->values())) T(std::forward<Args>(args)...);
+        } catch (...) {
+            free_leaf(next);
+            throw;
+        }
+        if (tail_ != nullptr) {
+            try {
+                push_tail();
+            } catch (...) {
+                release_leaf(next, 1);
+                throw;
+            }
+        }
+        tail_ = next;
+        ++size_ref();
+    }
+
+    void set_in_place(size_type i, const value_type& value) {
+        assert(i < size());
+        if (i >= tail_offset()) {
+            own_tail();
+            tail_->values()[i & mask] = value;
+            return;
+        }
+        node** slot = &root_;
+        for (unsigned level = shift_;; level -= bits) {
+            auto n = own(*slot, level);
+            if (level == 0) {
+                static_cast<leaf*>(n)->values()[i & mask] = value;
+                return;
+            }
+            slot = &static_cast<inner*>(n)->child[(i >> level) & mask];
+        }
+    }
+
+    // Unlinks the leaf holding idx, the last one of the trie, and frees the
+    // inner nodes left empty. Returns whether slot itself was freed.
+    bool pop_leaf(node*& slot, unsigned level, size_type idx) {
+        auto n = static_cast<inner*>(own(slot, level));
+        auto sub = (idx >> level) & mask;
+        if (level == bits) {
+            release_tree(std::exchange(n->child[sub], nullptr), 0);
+        } else if (pop_leaf(n->child[sub], level - bits, idx)) {
+            n->child[sub] = nullptr;
+        }
+        if (sub == 0) {
+            free_inner(n);
+            slot = nullptr;
+            return true;
+        }
+        return false;
+    }
+
+    void pop_back_in_place() {
+        assert(!empty());
+        auto count = tail_size();
+        if (count > 1 || size() == 1) {
+            if (count == 1) {
+                release_leaf(std::exchange(tail_, nullptr), 1);
+            } else {
+                own_tail();
+                tail_->values()[count - 1].~T();
+            }
+            --size_ref();
+            return;
+        }
+        // the last leaf of the trie becomes the tail
+        auto idx = size() - 2;
+        auto next = const_cast<leaf*>(leaf_for(idx));
+        retain(next);
+        try {
+            pop_leaf(root_, shift_, idx);
+        } catch (...) {
+            release_leaf(next, width);
+            throw;
+        }
+        if (root_ == nullptr) {
+            shift_ = bits;
+        } else if (shift_ > bits && static_cast<inner*>(root_)->child[1] == nullptr) {
+            auto r = static_cast<inner*>(root_);
+            root_ = std::exchange(r->child[0], nullptr);
+            free_inner(r);
+            shift_ -= bits;
+        }
+        release_leaf(std::exchange(tail_, next), 1);
+        --size_ref();
+    }
+
+private:
+    node* root_ = nullptr;
+    leaf* tail_ = nullptr;
+    unsigned shift_ = bits;
+    compressed_pair<size_type, allocator_type> size_allocator_;
+};
+
+template<typename T, typename Allocator>
+class persistent_vector<T, Allocator>::const_iterator
+{
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+public:
+    const_iterator() noexcept = default;
+
+    reference operator*() const noexcept  { return leaf_[i_ & mask]; }
+    pointer operator->() const noexcept   { return leaf_ + (i_ & mask); }
+    reference operator[](difference_type n) const noexcept { return (*vec_)[i_ + n]; }
+
+    const_iterator& operator++() noexcept {
+        if ((++i_ & mask) == 0) {
+            load();
+        }
+        return *this;
+    }
+
+    const_iterator& operator--() noexcept {
+        if ((i_-- & mask) == 0) {
+            load();
+        }
+        return *this;
+    }
+
+    const_iterator operator++(int) noexcept { auto tmp = *this; ++*this; return tmp; }
+    const_iterator operator--(int) noexcept { auto tmp = *this; --*this; return tmp; }
+
+    const_iterator& operator+=(difference_type n) noexcept {
+        auto old = i_;
+        i_ += n;
+        if ((old >> bits) != (i_ >> bits)) {
+            load();
+        }
+        return *this;
+    }
+
+    const_iterator& operator-=(difference_type n) noexcept { return *this += -n; }
+
+    friend const_iterator operator+(const_iterator it, difference_type n) noexcept { return it += n; }
+    friend const_iterator operator+(difference_type n, const_iterator it) noexcept { return it += n; }
+    friend const_iterator operator-(const_iterator it, difference_type n) noexcept { return it -= n; }
+
+    friend difference_type operator-(const const_iterator& a, const const_iterator& b) noexcept {
+        return static_cast<difference_type>(a.i_) - static_cast<difference_type>(b.i_);
+    }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b) noexcept { return a.i_ == b.i_; }
+    friend bool operator!=(const const_iterator& a, const const_iterator& b) noexcept { return a.i_ != b.i_; }
+    friend bool operator<(const const_iterator& a, const const_iterator& b) noexcept  { return a.i_ < b.i_; }
+    friend bool operator>(const const_iterator& a, const const_iterator& b) noexcept  { return a.i_ > b.i_; }
+    friend bool operator<=(const const_iterator& a, const const_iterator& b) noexcept { return a.i_ <= b.i_; }
+    friend bool operator>=(const const_iterator& a, const const_iterator& b) noexcept { return a.i_ >= b.i_; }
+
+private:
+    friend class persistent_vector;
+
+    const_iterator(const persistent_vector* vec, size_type i) noexcept
+        : vec_(vec), i_(i) {
+        load();
+    }
+
+    // The end iterator keeps the last leaf if it is in the same block.
+    void load() noexcept {
+        auto n = vec_->size();
+        leaf_ = (n != 0 && (i_ >> bits) == ((n - 1) >> bits)) ? vec_->tail_->values()
+              : i_ < n ? vec_->leaf_for(i_)->values() : nullptr;
+    }
+
+    const persistent_vector* vec_ = nullptr;
+    size_type i_ = 0;
+    const T* leaf_ = nullptr;
+};
+
+// Mutable handle for building or editing a version in bulk. Changes go to
+// nodes the handle owns alone; nodes shared with other versions are copied
+// the first time they are touched, so the source version never changes.
+template<typename T, typename Allocator>
+class persistent_vector<T, Allocator>::transient_type
+{
+public:
+    explicit transient_type(persistent_vector vec) noexcept
+        : vec_(std::move(vec)) {}
+
+    const_reference operator[](size_type i) const noexcept { return vec_[i]; }
+    size_type size() const noexcept { return vec_.size(); }
+    bool empty() const noexcept     { return vec_.empty(); }
+
+    void set(size_type i, const value_type& value) { vec_.set_in_place(i, value); }
+
+    void push_back(const value_type& value) { vec_.emplace_back_in_place(value); }
+    void push_back(value_type&& value)      { vec_.emplace_back_in_place(std::move(value)); }
+
+    template<typename... Args>
+    void emplace_back(Args&&... args) {
+        vec_.emplace_back_in_place(std::forward<Args>(args)...);
+    }
+
+    void pop_back() { vec_.pop_back_in_place(); }
+
+    // Snapshot of the current state; later changes copy the shared nodes.
+    persistent_vector persistent() const& { return vec_; }
+    persistent_vector persistent() &&     { return std::move(vec_); }
+
+private:
+    persistent_vector vec_;
+};
+
+template<typename T, typename A>
+bool operator==(const persistent_vector<T, A>& lhs, const persistent_vector<T, A>& rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    auto r = rhs.begin();
+    for (auto l = lhs.begin(); l != lhs.end(); ++l, ++r) {
+        if (!(*l == *r)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename T, typename A>
+bool operator!=(const persistent_vector<T, A>& lhs, const persistent_vector<T, A>& rhs) {
+    return !(lhs == rhs);
+}
+
+} // namespace dl
@@ -0,0 +1,220 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+namespace dl {
+
+// Pool of fixed size blocks for node based structures. Each thread keeps a
+// free list and trades batches of blocks with a shared depot, which carves
+// new blocks out of large chunks. Chunks are kept for the life of the
+// process, so freed nodes are reused rather than returned to the heap.
+template<size_t Size, size_t Align>
+class object_pool
+{
+public:
+    static constexpr size_t alignment = std::max(Align, alignof(void*));
+    static constexpr size_t block_size = (std::max(Size, sizeof(void*)) + alignment - 1) / alignment * alignment;
+    static constexpr size_t chunk_blocks = std::max<size_t>((size_t(64) << 10) / block_size, 16);
+    static constexpr size_t batch = 32;
+
+    static void* allocate() {
+        if (auto cache = local()) {
+            if (cache->head == nullptr) {
+                refill(*cache);
+            }
+            return cache->pop();
+        }
+        thread_cache tmp;
+        refill(tmp);
+        auto b = tmp.pop();
+        give_back(tmp.head, tmp.count);
+        return b;
+    }
+
+    static void deallocate(void* p) noexcept {
+        auto b = static_cast<block*>(p);
+        auto cache = local();
+        if (cache == nullptr) {
+            b->next = nullptr;
+            give_back(b, 1);
+            return;
+        }
+        cache->push(b);
+        if (cache->count > 2 * batch) {
+            auto head = cache->head;
+            auto tail = head;
+            for (size_t i = 1; i < batch; ++i) {
+                tail = tail->next;
+            }
+            cache->head = tail->next;
+            cache->count -= batch;
+            tail->next = nullptr;
+            give_back(head, batch);
+        }
+    }
+
+    // Bytes taken from the heap by this pool so far.
+    static size_t reserved_bytes() noexcept {
+        auto& d = shared();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        return d.chunks * chunk_blocks * block_size;
+    }
+
+private:
+    struct block
+    {
+        block* next;
+    };
+
+    enum class cache_state : unsigned char { fresh, alive, dead };
+
+    struct thread_cache
+    {
+        block* pop() noexcept {
+            auto b = head;
+            head = b->next;
+            --count;
+            return b;
+        }
+
+        void push(block* b) noexcept {
+            b->next = head;
+            head = b;
+            ++count;
+        }
+
+        block* head = nullptr;
+        size_t count = 0;
+    };
+
+    struct owned_cache : thread_cache
+    {
+        owned_cache() noexcept {
+            state() = cache_state::alive;
+        }
+
+        ~owned_cache() {
+            give_back(this->head, this->count);
+            state() = cache_state::dead;
+        }
+    };
+
+    struct depot
+    {
+        std::mutex mutex;
+        block* head = nullptr;
+        size_t count = 0;
+        char* chunk = nullptr;
+        size_t chunk_left = 0;
+        size_t chunks = 0;
+    };
+
+    static cache_state& state() noexcept {
+        thread_local cache_state s = cache_state::fresh;
+        return s;
+    }
+
+    static thread_cache* local() noexcept {
+        if (state() == cache_state::dead) {
+            return nullptr;
+        }
+        thread_local owned_cache cache;
+        return &cache;
+    }
+
+    // Never destroyed: blocks may be freed during static destruction.
+    static depot& shared() noexcept {
+        static depot* d = new depot;
+        return *d;
+    }
+
+    // Moves a batch of blocks into cache, carving a new chunk if needed.
+    static void refill(thread_cache& cache) {
+        auto& d = shared();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        for (size_t i = 0; i < batch && d.head != nullptr; ++i) {
+            auto b = d.head;
+            d.head = b->next;
+            --d.count;
+            cache.push(b);
+        }
+        if (cache.head != nullptr) {
+            return;
+        }
+        if (d.chunk_left == 0) {
+            d.chunk = static_cast<char*>(::operator new(chunk_blocks * block_size, std::align_val_t(alignment)));
+            d.chunk_left = chunk_blocks;
+            ++d.chunks;
+        }
+        for (size_t i = 0; i < batch && d.chunk_left != 0; ++i) {
+            cache.push(reinterpret_cast<block*>(d.chunk));
+            d.chunk += block_size;
+            --d.chunk_left;
+        }
+    }
+
+    static void give_back(block* head, size_t count) noexcept {
+        if (head == nullptr) {
+            return;
+        }
+        auto tail = head;
+        while (tail->next != nullptr) {
+            tail = tail->next;
+        }
+        auto& d = shared();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        tail->next = d.head;
+        d.head = head;
+        d.count += count;
+    }
+};
+
+// Allocator serving single objects from object_pool, arrays from the heap.
+template<typename T>
+class pool_allocator
+{
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using is_always_equal = std::true_type;
+    using pool = object_pool<sizeof(T), alignof(T)>;
+
+public:
+    pool_allocator() noexcept = default;
+
+    template<typename U>
+    pool_allocator(const pool_allocator<U>&) noexcept {}
+
+    T* allocate(size_type n) {
+        if (n == 1) {
+            return static_cast<T*>(pool::allocate());
+        }
+        if (n > std::numeric_limits<size_type>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    void deallocate(T* p, size_type n) noexcept {
+        if (p == nullptr) {
+            return;
+        }
+        if (n == 1) {
+            pool::deallocate(p);
+        } else {
+            ::operator delete(p, std::align_val_t(alignof(T)));
+        }
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const pool_allocator<T>&, const pool_allocator<U>&) noexcept { return true; }
+
+template<typename T, typename U>
+bool operator!=(const pool_allocator<T>&, const pool_allocator<U>&) noexcept { return false; }
+
+} // namespace dl
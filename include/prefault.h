@@ -0,0 +1,55 @@
+#pragma once
+
+// Prefaulting of memory and of a contiguous container's spare capacity.
+// Kept apart from the containers so they stay free of platform headers,
+// and free of them in turn so allocators can include it.
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace dl {
+
+inline size_t round_up(size_t bytes, size_t align) noexcept {
+    return (bytes + align - 1) / align * align;
+}
+
+inline size_t system_page_size() noexcept {
+    static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+// Faults in the pages under [p, p + bytes) for writing, so the first stores
+// there do not stall. Uses MADV_POPULATE_WRITE (Linux 5.14) and otherwise
+// writes a zero into each page, so the range must not hold live data;
+// neighbouring bytes in the first and last page are not touched.
+inline void prefault(void* p, size_t bytes) noexcept {
+    if (bytes == 0) {
+        return;
+    }
+    auto page = system_page_size();
+    auto first = reinterpret_cast<uintptr_t>(p);
+    auto last = first + bytes;
+    auto start = first / page * page;
+    constexpr int madv_populate_write = 23;
+    if (::madvise(reinterpret_cast<void*>(start), round_up(last, page) - start, madv_populate_write) == 0) {
+        return;
+    }
+    for (auto addr = first; addr < last; addr = (addr / page + 1) * page) {
+        *reinterpret_cast<volatile char*>(addr) = 0;
+    }
+}
+
+// Like vec.reserve(n), and also faults in the pages of all spare capacity
+// so the first writes into it do not take page faults. Works with any
+// container that keeps [data(), data() + capacity()) in one block.
+template<typename Container>
+void reserve_prefault(Container& vec, size_t n) {
+    vec.reserve(n);
+    if (vec.size() != vec.capacity()) {
+        prefault(vec.data() + vec.size(), (vec.capacity() - vec.size()) * sizeof(typename Container::value_type));
+    }
+}
+
+} // namespace dl
@@ -0,0 +1,355 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "compressed_pair.h"
+#include "type_utils.h"
+#include "vector.h"
+
+namespace dl {
+
+// d-ary heaps: node i has children Arity * i + 1 ... Arity * i + Arity. With
+// four or eight children, all the children compared on the way down sit in
+// one or two cache lines, and the heap is half or a third as deep as a binary
+// one. Like std::make_heap, comp(a, b) means a has lower priority than b.
+
+// Called with every element stored into a heap slot and that slot's index;
+// a queue built with a real callback can find its elements for decrease_key.
+struct no_heap_position
+{
+    template<typename T>
+    void operator()(const T&, size_t) const noexcept {}
+};
+
+template<size_t Arity, typename I, typename Compare, typename Position>
+void dary_sift_up(I first, size_t hole, typename std::iterator_traits<I>::value_type value,
+                  Compare& comp, Position& pos) {
+    while (hole > 0) {
+        auto parent = (hole - 1) / Arity;
+        if (!comp(first[parent], value)) {
+            break;
+        }
+        first[hole] = std::move(first[parent]);
+        pos(first[hole], hole);
+        hole = parent;
+    }
+    first[hole] = std::move(value);
+    pos(first[hole], hole);
+}
+
+// The highest priority child of the node whose first child is child.
+template<size_t Arity, typename I, typename Compare>
+size_t dary_top_child(I first, size_t child, size_t size, Compare& comp) {
+    auto best = child;
+    if (child + Arity <= size) {
+        for (size_t c = child + 1; c < child + Arity; ++c) {
+            if (comp(first[best], first[c])) {
+                best = c;
+            }
+        }
+    } else {
+        for (size_t c = child + 1; c < size; ++c) {
+            if (comp(first[best], first[c])) {
+                best = c;
+            }
+        }
+    }
+    return best;
+}
+
+template<size_t Arity, typename I, typename Compare, typename Position>
+void dary_sift_down(I first, size_t size, size_t hole, typename std::iterator_traits<I>::value_type value,
+                    Compare& comp, Position& pos) {
+    for (auto child = hole * Arity + 1; child < size; child = hole * Arity + 1) {
+        auto best = dary_top_child<Arity>(first, child, size, comp);
+        if (!comp(value, first[best])) {
+            break;
+        }
+        first[hole] = std::move(first[best]);
+        pos(first[hole], hole);
+        hole = best;
+    }
+    first[hole] = std::move(value);
+    pos(first[hole], hole);
+}
+
+// Refills the root after a pop. The replacement comes from the bottom and
+// almost always belongs there, so the hole is moved down to a leaf without
+// comparing against it, and the value is sifted up from there.
+template<size_t Arity, typename I, typename Compare, typename Position>
+void dary_sift_down_leaf(I first, size_t size, typename std::iterator_traits<I>::value_type value,
+                         Compare& comp, Position& pos) {
+    size_t hole = 0;
+    for (auto child = size_t(1); child < size; child = hole * Arity + 1) {
+        auto best = dary_top_child<Arity>(first, child, size, comp);
+        first[hole] = std::move(first[best]);
+        pos(first[hole], hole);
+        hole = best;
+    }
+    dary_sift_up<Arity>(first, hole, std::move(value), comp, pos);
+}
+
+// Floyd's bottom-up construction, O(n).
+template<size_t Arity, typename I, typename Compare, typename Position>
+void dary_heapify(I first, size_t size, Compare& comp, Position& pos) {
+    if (size < 2) {
+        return;
+    }
+    for (auto i = (size - 2) / Arity + 1; i-- > 0;) {
+        auto value = std::move(first[i]);
+        dary_sift_down<Arity>(first, size, i, std::move(value), comp, pos);
+    }
+}
+
+template<size_t Arity, typename I, typename Compare = std::less<>>
+void make_dary_heap(I first, I last, Compare comp = Compare()) {
+    no_heap_position pos;
+    dary_heapify<Arity>(first, static_cast<size_t>(last - first), comp, pos);
+}
+
+// Adds last[-1] to the heap [first, last - 1).
+template<size_t Arity, typename I, typename Compare = std::less<>>
+void push_dary_heap(I first, I last, Compare comp = Compare()) {
+    no_heap_position pos;
+    auto n = static_cast<size_t>(last - first);
+    if (n > 1) {
+        auto value = std::move(first[n - 1]);
+        dary_sift_up<Arity>(first, n - 1, std::move(value), comp, pos);
+    }
+}
+
+// Moves the top to last[-1] and makes [first, last - 1) a heap.
+template<size_t Arity, typename I, typename Compare = std::less<>>
+void pop_dary_heap(I first, I last, Compare comp = Compare()) {
+    no_heap_position pos;
+    auto n = static_cast<size_t>(last - first);
+    if (n > 1) {
+        auto value = std::move(first[n - 1]);
+        first[n - 1] = std::move(first[0]);
+        dary_sift_down_leaf<Arity>(first, n - 1, std::move(value), comp, pos);
+    }
+}
+
+template<size_t Arity, typename I, typename Compare = std::less<>>
+bool is_dary_heap(I first, I last, Compare comp = Compare()) {
+    auto n = static_cast<size_t>(last - first);
+    for (size_t i = 1; i < n; ++i) {
+        if (comp(first[(i - 1) / Arity], first[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// std::priority_queue over a d-ary heap in a dl::vector. Position, when
+// given, is called as pos(element, index) whenever an element is stored into
+// a slot; a callback that records the index (in the element or a side table)
+// lets decrease_key, update and erase find it. The default tracks nothing
+// and costs nothing.
+template<typename T,
+         typename Compare = std::less<T>,
+         size_t Arity = 4,
+         typename Position = no_heap_position,
+         typename Allocator = std::allocator<T>>
+class priority_queue
+{
+    static_assert(Arity >= 2, "A heap node needs at least two children");
+
+public:
+    using container_type = vector<T, Allocator>;
+    using value_compare = Compare;
+    using position_type = Position;
+    using value_type = T;
+    using size_type = size_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using allocator_type = Allocator;
+
+    static constexpr size_t arity = Arity;
+
+    priority_queue() = default;
+
+    explicit priority_queue(const Compare& comp, const Position& pos = Position(),
+                            const allocator_type& a = allocator_type())
+        : data_(container_type(a), comp, pos) {}
+
+    template<typename I,
+             std::enable_if_t<is_input_iter<I>::value, int> = 0>
+    priority_queue(I first, I last, const Compare& comp = Compare(), const Position& pos = Position(),
+                   const allocator_type& a = allocator_type())
+        : data_(container_type(first, last, a), comp, pos) {
+        heapify();
+    }
+
+    priority_queue(std::initializer_list<value_type> list, const Compare& comp = Compare(),
+                   const Position& pos = Position())
+        : priority_queue(list.begin(), list.end(), comp, pos) {}
+
+    const_reference top() const {
+        assert(!empty() && "top() on an empty priority_queue");
+        return c().front();
+    }
+
+    bool empty() const noexcept { return c().empty(); }
+    size_type size() const noexcept { return c().size(); }
+    size_type capacity() const noexcept { return c().capacity(); }
+    void reserve(size_type n) { c().reserve(n); }
+    void clear() noexcept { c().clear(); }
+
+    // The heap in storage order; c[0] is the top.
+    const container_type& container() const noexcept { return c(); }
+    const value_compare& value_comp() const noexcept { return get<1>(data_); }
+    const position_type& position() const noexcept { return get<2>(data_); }
+
+    void push(const value_type& value) { emplace(value); }
+    void push(value_type&& value) { emplace(std::move(value)); }
+
+    template<typename... Args>
+    void emplace(Args&&... args) {
+        c().emplace_back(std::forward<Args>(args)...);
+        auto value = std::move(c().back());
+        dary_sift_up<Arity>(c().begin(), c().size() - 1, std::move(value), comp(), pos());
+    }
+
+    // Appends the range, then restores the heap with whichever is cheaper:
+    // sifting the new elements up one by one, O(k log n), or rebuilding the
+    // whole heap bottom-up, O(n + k).
+    template<typename I,
+             std::enable_if_t<is_input_iter<I>::value, int> = 0>
+    void push_range(I first, I last) {
+        auto old_size = c().size();
+        try {
+            if constexpr (is_forward_iter<I>::value) {
+                c().insert(c().end(), first, last);
+            } else {
+                for (; first != last; ++first) {
+                    c().emplace_back(*first);
+                }
+            }
+        } catch (...) {
+            truncate(old_size);
+            throw;
+        }
+        restore_after_append(old_size);
+    }
+
+    template<typename R>
+    void push_range(R&& range) {
+        auto old_size = c().size();
+        try {
+            c().append_range(std::forward<R>(range));
+        } catch (...) {
+            truncate(old_size);
+            throw;
+        }
+        restore_after_append(old_size);
+    }
+
+    void pop() {
+        assert(!empty() && "pop() on an empty priority_queue");
+        auto value = std::move(c().back());
+        c().pop_back();
+        if (!c().empty()) {
+            dary_sift_down_leaf<Arity>(c().begin(), c().size(), std::move(value), comp(), pos());
+        }
+    }
+
+    // pop() followed by push(value) with a single pass down the heap.
+    void pop_push(value_type value) {
+        assert(!empty() && "pop_push() on an empty priority_queue");
+        dary_sift_down<Arity>(c().begin(), c().size(), 0, std::move(value), comp(), pos());
+    }
+
+    // Raises the priority of the element at index i (as reported to the
+    // position callback) to value: with std::greater, a min-heap, this is
+    // the classic decrease-key.
+    void decrease_key(size_type i, value_type value) {
+        assert(i < size() && "decrease_key index out of bounds");
+        assert(!comp()(value, c()[i]) && "decrease_key would lower the priority");
+        dary_sift_up<Arity>(c().begin(), i, std::move(value), comp(), pos());
+    }
+
+    // Replaces the element at index i with value, in either direction.
+    void update(size_type i, value_type value) {
+        assert(i < size() && "update index out of bounds");
+        if (comp()(c()[i], value)) {
+            dary_sift_up<Arity>(c().begin(), i, std::move(value), comp(), pos());
+        } else {
+            dary_sift_down<Arity>(c().begin(), c().size(), i, std::move(value), comp(), pos());
+        }
+    }
+
+    void erase(size_type i) {
+        assert(i < size() && "erase index out of bounds");
+        auto value = std::move(c().back());
+        c().pop_back();
+        if (i < c().size()) {
+            update(i, std::move(value));
+        }
+    }
+
+    void swap(priority_queue& other) noexcept {
+        using std::swap;
+        c().swap(other.c());
+        swap(comp(), other.comp());
+        swap(pos(), other.pos());
+    }
+
+private:
+    container_type& c() noexcept { return get<0>(data_); }
+    const container_type& c() const noexcept { return get<0>(data_); }
+    Compare& comp() noexcept { return get<1>(data_); }
+    Position& pos() noexcept { return get<2>(data_); }
+
+    void heapify() {
+        no_heap_position none;
+        dary_heapify<Arity>(c().begin(), c().size(), comp(), none);
+        report_positions();
+    }
+
+    void report_positions() {
+        if constexpr (!std::is_same_v<Position, no_heap_position>) {
+            for (size_type i = 0; i < c().size(); ++i) {
+                pos()(c()[i], i);
+            }
+        }
+    }
+
+    // Drops a partly appended range: the heap below old_size is untouched.
+    void truncate(size_type old_size) {
+        c().erase(c().begin() + old_size, c().end());
+    }
+
+    void restore_after_append(size_type old_size) {
+        auto n = c().size();
+        auto k = n - old_size;
+        size_type depth = 1;
+        for (auto m = n; m >= Arity; m /= Arity) {
+            ++depth;
+        }
+        if (k * depth > n) {
+            heapify();
+        } else {
+            for (auto i = old_size; i < n; ++i) {
+                auto value = std::move(c()[i]);
+                dary_sift_up<Arity>(c().begin(), i, std::move(value), comp(), pos());
+            }
+        }
+    }
+
+    // Comparator and callback are usually empty and take no space.
+    compressed_tuple<container_type, Compare, Position> data_;
+};
+
+template<typename T, typename C, size_t N, typename P, typename A>
+void swap(priority_queue<T, C, N, P, A>& a, priority_queue<T, C, N, P, A>& b) noexcept {
+    a.swap(b);
+}
+
+} // namespace dl
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include "type_utils.h"
+
+namespace dl {
+
+struct from_range_t { explicit from_range_t() = default; };
+inline constexpr from_range_t from_range{};
+
+// Iterator pair with an expected element count, for single-pass sources
+// whose length is known from elsewhere (a file header, a protocol field).
+template<typename I>
+class hinted_range
+{
+public:
+    hinted_range(I first, I last, size_t hint)
+        : first_(std::move(first))
+        , last_(std::move(last))
+        , hint_(hint) {}
+
+    I begin() const { return first_; }
+    I end() const { return last_; }
+    size_t reserve_hint() const noexcept { return hint_; }
+
+private:
+    I first_;
+    I last_;
+    size_t hint_;
+};
+
+template<typename I>
+hinted_range<I> hinted(I first, I last, size_t hint) {
+    return hinted_range<I>(std::move(first), std::move(last), hint);
+}
+
+template<typename R>
+using range_iterator_t = decltype(std::begin(std::declval<R&>()));
+
+template<unsigned N>
+struct hint_priority : hint_priority<N - 1> {};
+
+template<>
+struct hint_priority<0> {};
+
+template<typename R>
+auto size_hint_impl(const R& r, hint_priority<4>) -> decltype(static_cast<size_t>(r.size())) {
+    return static_cast<size_t>(r.size());
+}
+
+template<typename R>
+auto size_hint_impl(const R& r, hint_priority<3>) -> decltype(static_cast<size_t>(r.reserve_hint())) {
+    return static_cast<size_t>(r.reserve_hint());
+}
+
+// Customization point: a reserve_hint(const R&) found by ADL.
+template<typename R>
+auto size_hint_impl(const R& r, hint_priority<2>) -> decltype(static_cast<size_t>(reserve_hint(r))) {
+    return static_cast<size_t>(reserve_hint(r));
+}
+
+template<typename R>
+auto size_hint_impl(const R& r, hint_priority<1>)
+    -> std::enable_if_t<is_forward_iter<range_iterator_t<const R>>::value, size_t> {
+    return static_cast<size_t>(std::distance(std::begin(r), std::end(r)));
+}
+
+template<typename R>
+size_t size_hint_impl(const R&, hint_priority<0>) {
+    return 0;
+}
+
+// Expected number of elements in r, 0 when unknown.
+template<typename R>
+size_t size_hint(const R& r) {
+    return size_hint_impl(r, hint_priority<4>());
+}
+
+} // namespace dl
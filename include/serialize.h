@@ -0,0 +1,239 @@
+#pragma once
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "vector.h"
+
+// Binary format: every vector is a frame of a uint64_t element count followed
+// by the raw elements. A vector of vectors is the outer count, all the inner
+// counts, then all the inner payloads back to back.
+
+namespace dl {
+
+[[noreturn]] inline void throw_io_error(const char* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+inline size_t max_iov() noexcept {
+#ifdef IOV_MAX
+    return IOV_MAX;
+#else
+    return 1024;
+#endif
+}
+
+// Writes all of iov, retrying on partial writes. iov is consumed.
+inline void write_all(int fd, iovec* iov, size_t count) {
+    while (count != 0) {
+        auto batch = static_cast<int>(std::min(count, max_iov()));
+        auto n = ::writev(fd, iov, batch);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_io_error("dl::write");
+        }
+        auto done = static_cast<size_t>(n);
+        while (count != 0 && done >= iov->iov_len) {
+            done -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count != 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + done;
+            iov->iov_len -= done;
+        }
+    }
+}
+
+// Reads exactly len bytes at offset, or from the current position if offset is negative.
+inline void read_all(int fd, void* buf, size_t len, off_t offset = -1) {
+    auto p = static_cast<char*>(buf);
+    while (len != 0) {
+        auto n = offset < 0 ? ::read(fd, p, len) : ::pread(fd, p, len, offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw_io_error("dl::read");
+        }
+        if (n == 0)
+            throw std::runtime_error("dl::read: unexpected end of file");
+        p += n;
+        len -= static_cast<size_t>(n);
+        if (offset >= 0) {
+            offset += n;
+        }
+    }
+}
+
+template<typename T, typename A>
+void write(int fd, const vector<T, A>& vec) {
+    static_assert(std::is_trivially_copyable_v<T>, "dl::write stores raw bytes");
+    uint64_t count = vec.size();
+    iovec iov[2] = {
+        {&count, sizeof(count)},
+        {const_cast<T*>(vec.data()), vec.size() * sizeof(T)}
+    };
+    write_all(fd, iov, vec.empty() ? 1 : 2);
+}
+
+template<typename T, typename A1, typename A2>
+void write(int fd, const vector<vector<T, A2>, A1>& vec) {
+    static_assert(std::is_trivially_copyable_v<T>, "dl::write stores raw bytes");
+    vector<uint64_t> counts;
+    counts.reserve(vec.size() + 1);
+    counts.push_back(vec.size());
+    for (const auto& v : vec) {
+        counts.push_back(v.size());
+    }
+    vector<iovec> iov;
+    iov.reserve(vec.size() + 1);
+    iov.push_back({counts.data(), counts.size() * sizeof(uint64_t)});
+    for (const auto& v : vec) {
+        if (!v.empty()) {
+            iov.push_back({const_cast<T*>(v.data()), v.size() * sizeof(T)});
+        }
+    }
+    write_all(fd, iov.data(), iov.size());
+}
+
+template<typename T, typename A>
+void read_payload(int fd, vector<T, A>& vec, uint64_t count, off_t offset) {
+    vec.clear();
+    vec.reserve(count);
+    vec.resize_for_overwrite(count);
+    try {
+        read_all(fd, vec.data(), count * sizeof(T), offset);
+    } catch (...) {
+        // never hand back the unread, uninitialized tail
+        vec.clear();
+        throw;
+    }
+}
+
+template<typename T, typename A>
+void read(int fd, vector<T, A>& vec) {
+    static_assert(std::is_trivially_copyable_v<T>, "dl::read loads raw bytes");
+    uint64_t count = 0;
+    read_all(fd, &count, sizeof(count));
+    read_payload(fd, vec, count, -1);
+}
+
+template<typename T, typename A1, typename A2>
+void read(int fd, vector<vector<T, A2>, A1>& vec) {
+    static_assert(std::is_trivially_copyable_v<T>, "dl::read loads raw bytes");
+    uint64_t count = 0;
+    read_all(fd, &count, sizeof(count));
+    vector<uint64_t> counts;
+    read_payload(fd, counts, count, -1);
+    vec.clear();
+    vec.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        read_payload(fd, vec[i], counts[i], -1);
+    }
+}
+
+// Positional variant: reads the frame at offset without moving the file position
+// and returns the offset of the next frame.
+template<typename T, typename A>
+off_t pread(int fd, off_t offset, vector<T, A>& vec) {
+    static_assert(std::is_trivially_copyable_v<T>, "dl::pread loads raw bytes");
+    uint64_t count = 0;
+    read_all(fd, &count, sizeof(count), offset);
+    offset += sizeof(count);
+    read_payload(fd, vec, count, offset);
+    return offset + static_cast<off_t>(count * sizeof(T));
+}
+
+// Streams a sequence of frames terminated by an empty frame.
+template<typename T>
+class vector_writer
+{
+    static_assert(std::is_trivially_copyable_v<T>, "vector_writer stores raw bytes");
+
+public:
+    explicit vector_writer(int fd) noexcept : fd_(fd) {}
+
+    vector_writer(const vector_writer&) = delete;
+    vector_writer& operator=(const vector_writer&) = delete;
+
+    void write(const T* data, size_t n) {
+        if (n == 0) {
+            return;
+        }
+        uint64_t count = n;
+        iovec iov[2] = {
+            {&count, sizeof(count)},
+            {const_cast<T*>(data), n * sizeof(T)}
+        };
+        write_all(fd_, iov, 2);
+        written_ += n;
+    }
+
+    template<typename A>
+    void write(const vector<T, A>& chunk) {
+        write(chunk.data(), chunk.size());
+    }
+
+    void finish() {
+        if (!finished_) {
+            uint64_t zero = 0;
+            iovec iov{&zero, sizeof(zero)};
+            write_all(fd_, &iov, 1);
+            finished_ = true;
+        }
+    }
+
+    uint64_t written() const noexcept { return written_; }
+
+private:
+    int fd_;
+    uint64_t written_ = 0;
+    bool finished_ = false;
+};
+
+template<typename T>
+class vector_reader
+{
+    static_assert(std::is_trivially_copyable_v<T>, "vector_reader loads raw bytes");
+
+public:
+    explicit vector_reader(int fd) noexcept : fd_(fd) {}
+
+    vector_reader(const vector_reader&) = delete;
+    vector_reader& operator=(const vector_reader&) = delete;
+
+    // Reads the next frame into chunk reusing its capacity, false after the last one.
+    template<typename A>
+    bool next(vector<T, A>& chunk) {
+        if (done_) {
+            return false;
+        }
+        uint64_t count = 0;
+        read_all(fd_, &count, sizeof(count));
+        if (count == 0) {
+            done_ = true;
+            chunk.clear();
+            return false;
+        }
+        chunk.clear();
+        chunk.resize_for_overwrite(count);
+        read_all(fd_, chunk.data(), count * sizeof(T));
+        return true;
+    }
+
+private:
+    int fd_;
+    bool done_ = false;
+};
+
+} // namespace dl
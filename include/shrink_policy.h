@@ -0,0 +1,71 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace dl {
+
+// Shrink policies decide after an element removal which capacity a container
+// should fall back to: shrink_target(size, capacity) returns the new capacity,
+// or capacity itself to keep the buffer.
+
+struct no_shrink
+{
+    constexpr size_t shrink_target(size_t, size_t capacity) const noexcept {
+        return capacity;
+    }
+};
+
+// Shrinks once size falls below capacity * Num / Den and only then, to twice
+// the size. Right after a shrink the vector is half full, so it has to double
+// before it grows again and halve again before the next shrink: no flapping
+// around a single threshold. Capacities up to MinCapacity are never released.
+template<size_t Num = 1, size_t Den = 4, size_t MinCapacity = 64>
+struct fraction_shrink
+{
+    static_assert(Num < Den && 2 * Num <= Den, "Shrink threshold must stay below half of the capacity");
+
+    constexpr size_t shrink_target(size_t size, size_t capacity) const noexcept {
+        if (capacity <= MinCapacity || size * Den >= capacity * Num) {
+            return capacity;
+        }
+        return std::max(size * 2, MinCapacity);
+    }
+};
+
+// Same rule with the threshold chosen per instance.
+class dynamic_shrink
+{
+public:
+    explicit constexpr dynamic_shrink(double fraction = 0.25, size_t min_capacity = 64) noexcept
+        : fraction_(fraction < 0.5 ? fraction : 0.5)
+        , min_capacity_(min_capacity) {}
+
+    constexpr size_t shrink_target(size_t size, size_t capacity) const noexcept {
+        if (capacity <= min_capacity_ || static_cast<double>(size) >= fraction_ * static_cast<double>(capacity)) {
+            return capacity;
+        }
+        return std::max(size * 2, min_capacity_);
+    }
+
+    double fraction() const noexcept { return fraction_; }
+    size_t min_capacity() const noexcept { return min_capacity_; }
+
+private:
+    double fraction_;
+    size_t min_capacity_;
+};
+
+// Allocators may give back the tail of a block without moving it by providing
+// bool shrink_in_place(pointer p, size_type old_n, size_type new_n).
+template<typename A, typename = void>
+struct has_shrink_in_place : std::false_type {};
+
+template<typename A>
+struct has_shrink_in_place<A, std::void_t<decltype(std::declval<A&>().shrink_in_place(
+    std::declval<typename std::allocator_traits<A>::pointer>(), size_t(), size_t()))>>
+    : std::true_type {};
+
+} // namespace dl
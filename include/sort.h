@@ -0,0 +1,217 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include "split_buffer.h"
+#include "thread_pool.h"
+#include "vector.h"
+
+namespace dl {
+
+struct identity_key
+{
+    template<typename T>
+    const T& operator()(const T& v) const noexcept { return v; }
+};
+
+// Maps a key to an unsigned integer with the same ordering.
+template<typename K>
+auto radix_bits(K key) noexcept {
+    static_assert(std::is_arithmetic_v<K>, "radix_sort needs an integer or floating point key");
+    if constexpr (std::is_floating_point_v<K>) {
+        using U = std::conditional_t<sizeof(K) == 4, uint32_t, uint64_t>;
+        static_assert(sizeof(K) == sizeof(U), "Unsupported floating point key");
+        U u;
+        std::memcpy(&u, &key, sizeof(u));
+        constexpr U sign = U(1) << (sizeof(U) * 8 - 1);
+        return (u & sign) ? U(~u) : U(u | sign);
+    } else {
+        using U = std::make_unsigned_t<K>;
+        constexpr U sign = std::is_signed_v<K> ? U(U(1) << (sizeof(U) * 8 - 1)) : U(0);
+        return U(static_cast<U>(key) ^ sign);
+    }
+}
+
+// Sorts contiguous storage, so I must be a pointer (the iterators of
+// dl::vector are); scratch space and counters come from alloc.
+template<typename I, typename KeyFn, typename Allocator>
+void radix_sort(I first, I last, KeyFn key, unsigned digit_bits, Allocator& alloc) {
+    using value_type = typename std::iterator_traits<I>::value_type;
+    using key_type = decltype(radix_bits(key(*first)));
+    using allocator_rr = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+    using size_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<size_t>;
+    static_assert(std::is_pointer_v<I>, "radix_sort needs contiguous storage; pass pointers");
+    static_assert(std::is_nothrow_move_constructible_v<value_type>, "radix_sort moves elements into scratch space");
+
+    if (digit_bits == 0 || digit_bits > 16)
+        throw std::invalid_argument("radix_sort digit must be 1..16 bits");
+
+    auto n = static_cast<size_t>(last - first);
+    if (n < 2) {
+        return;
+    }
+
+    const unsigned passes = (sizeof(key_type) * 8 + digit_bits - 1) / digit_bits;
+    const size_t buckets = size_t(1) << digit_bits;
+    const key_type mask = static_cast<key_type>(buckets - 1);
+
+    vector<size_t, size_allocator> hist(passes * buckets, 0, size_allocator(alloc));
+    for (auto it = first; it != last; ++it) {
+        auto k = radix_bits(key(*it));
+        for (unsigned p = 0; p < passes; ++p) {
+            ++hist[p * buckets + ((k >> (p * digit_bits)) & mask)];
+        }
+    }
+
+    allocator_rr a(alloc);
+    split_buffer<value_type, allocator_rr&> scratch(0, n, a);
+    auto src = first;
+    auto dst = scratch.begin;
+    bool constructed = false;
+    vector<size_t, size_allocator> bucket_first{size_allocator(alloc)};
+
+    for (unsigned p = 0; p < passes; ++p) {
+        auto h = hist.data() + p * buckets;
+        if (*std::max_element(h, h + buckets) == n) {
+            continue; // every key has the same digit
+        }
+        size_t sum = 0;
+        for (size_t b = 0; b < buckets; ++b) {
+            sum += std::exchange(h[b], sum);
+        }
+        auto shift = p * digit_bits;
+        if (constructed) {
+            for (size_t i = 0; i < n; ++i) {
+                dst[h[(radix_bits(key(src[i])) >> shift) & mask]++] = std::move(src[i]);
+            }
+        } else {
+            // The first pass constructs the scratch elements out of order;
+            // if key() throws, bucket b holds constructed elements from
+            // bucket_first[b] up to h[b].
+            bucket_first.assign(h, h + buckets);
+            try {
+                for (size_t i = 0; i < n; ++i) {
+                    auto& pos = h[(radix_bits(key(src[i])) >> shift) & mask];
+                    std::allocator_traits<allocator_rr>::construct(a, dst + pos, std::move(src[i]));
+                    ++pos;
+                }
+            } catch (...) {
+                for (size_t b = 0; b < buckets; ++b) {
+                    destroy(a, dst + bucket_first[b], dst + h[b]);
+                }
+                throw;
+            }
+            scratch.end = scratch.begin + n;
+            constructed = true;
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != first) {
+        std::move(src, src + n, first);
+    }
+}
+
+template<typename I, typename KeyFn = identity_key>
+void radix_sort(I first, I last, KeyFn key = KeyFn(), unsigned digit_bits = 8) {
+    std::allocator<typename std::iterator_traits<I>::value_type> alloc;
+    radix_sort(first, last, key, digit_bits, alloc);
+}
+
+template<typename T, typename A, typename KeyFn = identity_key>
+void radix_sort(vector<T, A>& vec, KeyFn key = KeyFn(), unsigned digit_bits = 8) {
+    auto alloc = vec.get_allocator();
+    radix_sort(vec.begin(), vec.end(), key, digit_bits, alloc);
+}
+
+// Sample sort: splitters from a sorted sample define one bucket per task,
+// elements are scattered into scratch space and buckets are sorted in parallel.
+template<typename I, typename Compare, typename Allocator>
+void parallel_sort(I first, I last, Compare comp, thread_pool& pool, Allocator& alloc) {
+    using value_type = typename std::iterator_traits<I>::value_type;
+    using allocator_rr = typename std::allocator_traits<Allocator>::template rebind_alloc<value_type>;
+    static_assert(std::is_nothrow_move_constructible_v<value_type>, "parallel_sort moves elements into scratch space");
+
+    constexpr size_t serial_threshold = 1 << 15;
+    constexpr size_t oversample = 32;
+
+    auto n = static_cast<size_t>(last - first);
+    if (n < serial_threshold || pool.size() == 1) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    const size_t k = std::min<size_t>(pool.size() * 4, 1 << 15);
+    using size_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<size_t>;
+    using bucket_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<uint16_t>;
+    vector<value_type, allocator_rr> sample{allocator_rr(alloc)};
+    sample.reserve(k * oversample);
+    for (size_t i = 0; i < k * oversample; ++i) {
+        sample.push_back(first[(i * 2654435761u + n / 2) % n]);
+    }
+    std::sort(sample.begin(), sample.end(), comp);
+    vector<value_type, allocator_rr> splitters{allocator_rr(alloc)};
+    splitters.reserve(k - 1);
+    for (size_t i = 1; i < k; ++i) {
+        splitters.push_back(sample[i * oversample]);
+    }
+
+    const size_t chunks = std::min(n, pool.size() * 4);
+    vector<uint16_t, bucket_allocator> bucket_of(n, bucket_allocator(alloc));
+    vector<size_t, size_allocator> offsets(chunks * k, 0, size_allocator(alloc));
+    pool.run(chunks, [&](size_t c) {
+        auto cnt = offsets.data() + c * k;
+        for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i) {
+            auto b = std::upper_bound(splitters.begin(), splitters.end(), first[i], comp) - splitters.begin();
+            bucket_of[i] = static_cast<uint16_t>(b);
+            ++cnt[b];
+        }
+    });
+
+    vector<size_t, size_allocator> bucket_begin(k + 1, 0, size_allocator(alloc));
+    size_t sum = 0;
+    for (size_t b = 0; b < k; ++b) {
+        bucket_begin[b] = sum;
+        for (size_t c = 0; c < chunks; ++c) {
+            sum += std::exchange(offsets[c * k + b], sum);
+        }
+    }
+    bucket_begin[k] = n;
+
+    allocator_rr a(alloc);
+    split_buffer<value_type, allocator_rr&> scratch(0, n, a);
+    pool.run(chunks, [&](size_t c) {
+        auto pos = offsets.data() + c * k;
+        for (size_t i = n * c / chunks; i < n * (c + 1) / chunks; ++i) {
+            std::allocator_traits<allocator_rr>::construct(a, scratch.begin + pos[bucket_of[i]]++, std::move(first[i]));
+        }
+    });
+    scratch.end = scratch.begin + n;
+
+    pool.run(k, [&](size_t b) {
+        auto lo = scratch.begin + bucket_begin[b];
+        auto hi = scratch.begin + bucket_begin[b + 1];
+        std::sort(lo, hi, comp);
+        std::move(lo, hi, first + bucket_begin[b]);
+    });
+}
+
+template<typename I, typename Compare = std::less<>>
+void parallel_sort(I first, I last, Compare comp = Compare(), thread_pool& pool = thread_pool::global()) {
+    std::allocator<typename std::iterator_traits<I>::value_type> alloc;
+    parallel_sort(first, last, comp, pool, alloc);
+}
+
+template<typename T, typename A, typename Compare = std::less<>>
+void parallel_sort(vector<T, A>& vec, Compare comp = Compare(), thread_pool& pool = thread_pool::global()) {
+    auto alloc = vec.get_allocator();
+    parallel_sort(vec.begin(), vec.end(), comp, pool, alloc);
+}
+
+} // namespace dl
@@ -0,0 +1,146 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+namespace dl {
+
+// Non-owning view of a contiguous range, for passing parts of a vector or
+// of a C buffer around without copying them. Slicing returns another view
+// of the same elements.
+template<typename T>
+class span
+{
+public: // aliases
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using reference = T&;
+    using const_reference = const T&;
+    using iterator = pointer;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+private:
+    template<typename C>
+    using container_data_t = std::remove_pointer_t<decltype(std::declval<C&>().data())>;
+
+    // Contiguous containers whose elements convert to T without a copy:
+    // same type, or adding const.
+    template<typename C>
+    using enable_container_t = std::enable_if_t<
+        std::is_convertible_v<container_data_t<C> (*)[], T (*)[]>
+        && std::is_convertible_v<decltype(std::declval<C&>().size()), size_type>
+        && !std::is_same_v<std::remove_cv_t<C>, span>>;
+
+public: // constructors
+    constexpr span() noexcept = default;
+
+    constexpr span(pointer data, size_type size) noexcept
+        : data_(data)
+        , size_(size) {}
+
+    template<typename P, typename = std::enable_if_t<std::is_convertible_v<P, pointer> && !std::is_integral_v<P>>>
+    constexpr span(P first, pointer last) noexcept
+        : data_(first)
+        , size_(static_cast<size_type>(last - first)) {}
+
+    template<size_t N>
+    constexpr span(T (&arr)[N]) noexcept
+        : data_(arr)
+        , size_(N) {}
+
+    template<typename C, typename = enable_container_t<C>>
+    constexpr span(C& c) noexcept(noexcept(c.data()))
+        : data_(c.data())
+        , size_(static_cast<size_type>(c.size())) {}
+
+    template<typename C, typename = enable_container_t<const C>>
+    constexpr span(const C& c) noexcept(noexcept(c.data()))
+        : data_(c.data())
+        , size_(static_cast<size_type>(c.size())) {}
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+    constexpr span(const span<U>& other) noexcept
+        : data_(other.data())
+        , size_(other.size()) {}
+
+public: // access members
+    constexpr pointer data() const noexcept { return data_; }
+
+    constexpr iterator begin() const noexcept { return data_; }
+    constexpr iterator end() const noexcept   { return data_ + size_; }
+
+    constexpr reverse_iterator rbegin() const noexcept { return reverse_iterator(end());   }
+    constexpr reverse_iterator rend() const noexcept   { return reverse_iterator(begin()); }
+
+    constexpr reference operator[](size_type i) const noexcept { return data_[i]; }
+
+    reference at(size_type i) const {
+        if (i >= size_)
+            throw std::out_of_range("span index out of bounds");
+        return data_[i];
+    }
+
+    constexpr reference front() const noexcept { return data_[0]; }
+    constexpr reference back() const noexcept  { return data_[size_ - 1]; }
+
+    constexpr size_type size() const noexcept       { return size_; }
+    constexpr size_type size_bytes() const noexcept { return size_ * sizeof(T); }
+    constexpr bool empty() const noexcept           { return size_ == 0; }
+
+public: // slicing
+    constexpr span first(size_type n) const noexcept {
+        return span(data_, n);
+    }
+
+    constexpr span last(size_type n) const noexcept {
+        return span(data_ + (size_ - n), n);
+    }
+
+    // Elements [offset, offset + count), clamped to the end like substr.
+    span subspan(size_type offset, size_type count = npos) const {
+        if (offset > size_)
+            throw std::out_of_range("span offset out of bounds");
+        return span(data_ + offset, std::min(count, size_ - offset));
+    }
+
+    constexpr span drop_front(size_type n) const noexcept {
+        return span(data_ + n, size_ - n);
+    }
+
+    constexpr span drop_back(size_type n) const noexcept {
+        return span(data_, size_ - n);
+    }
+
+private:
+    pointer data_ = nullptr;
+    size_type size_ = 0;
+};
+
+template<typename T, size_t N>
+span(T (&)[N]) -> span<T>;
+
+template<typename C>
+span(C&) -> span<std::remove_pointer_t<decltype(std::declval<C&>().data())>>;
+
+template<typename C>
+span(const C&) -> span<std::remove_pointer_t<decltype(std::declval<const C&>().data())>>;
+
+template<typename T>
+span<const std::byte> as_bytes(span<T> s) noexcept {
+    return span<const std::byte>(reinterpret_cast<const std::byte*>(s.data()), s.size_bytes());
+}
+
+template<typename T, typename = std::enable_if_t<!std::is_const_v<T>>>
+span<std::byte> as_writable_bytes(span<T> s) noexcept {
+    return span<std::byte>(reinterpret_cast<std::byte*>(s.data()), s.size_bytes());
+}
+
+} // namespace dl
@@ -4,6 +4,7 @@
 #include <type_traits>
 #include "algorithm.h"
 #include "compressed_pair.h"
+#include "memory.h"
 #include "type_utils.h"
 
 namespace dl {
@@ -33,6 +34,13 @@ public:
         end_cap() = begin + cap;
     }
 
+    // Takes the block from allocate_zeroed, so [begin, end_cap) reads as zero.
+    split_buffer(size_type size, size_type cap, allocator_rr& a, zeroed_t) : split_buffer(a) {
+        begin = cap != 0 ? alloc().allocate_zeroed(cap) : nullptr;
+        end = begin + size;
+        end_cap() = begin + cap;
+    }
+
     void clear() {
         while (begin != end) {
             allocator_traits::destroy(alloc(), end-- - 1);
@@ -80,6 +88,8 @@ public:
     }
 
     ~split_buffer() {
+        static_assert(!is_compressible_v<allocator_type> || sizeof(split_buffer) == 3 * sizeof(pointer),
+                      "An empty allocator must not grow split_buffer");
         clear();
         allocator_traits::deallocate(alloc(), begin, capacity());
     }
@@ -87,15 +97,15 @@ public:
     size_type capacity() const noexcept { return end_cap() - begin; }
     size_type size() const noexcept { return end - begin; }
 
-    allocator_rr& alloc() { return end_cap_allocator.second(); }
+    allocator_rr& alloc() { return get<1>(end_cap_allocator); }
 
-    pointer& end_cap()             { return end_cap_allocator.first(); }
-    const pointer& end_cap() const { return end_cap_allocator.first(); }
+    pointer& end_cap()             { return get<0>(end_cap_allocator); }
+    const pointer& end_cap() const { return get<0>(end_cap_allocator); }
 
 public:
     pointer begin = nullptr;
     pointer end = nullptr;
-    compressed_pair<pointer, allocator_type> end_cap_allocator;
+    compressed_tuple<pointer, allocator_type> end_cap_allocator;
 };
 
 } // namespace dl
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+#include "algorithm.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace dl {
+
+// Half the L3 size: copies this large, stored with regular stores, would
+// evict most of the last-level cache, which is shared with other processes.
+inline size_t default_stream_copy_threshold() noexcept {
+    long l3 = 0;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    l3 = ::sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+    return l3 > 0 ? static_cast<size_t>(l3) / 2 : size_t(16) << 20;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Source lines are prefetched this far ahead with the non-temporal hint, so
+// they are not kept in the outer caches either.
+constexpr size_t stream_prefetch_distance = 1024;
+
+// Stores 128 bytes per iteration to a 32-byte aligned destination with
+// non-temporal stores; head and tail are left to memcpy.
+__attribute__((target("avx2")))
+inline void stream_copy_avx2(char* dst, const char* src, size_t bytes) noexcept {
+    for (; bytes >= 128; bytes -= 128, src += 128, dst += 128) {
+        _mm_prefetch(src + stream_prefetch_distance, _MM_HINT_NTA);
+        _mm_prefetch(src + stream_prefetch_distance + 64, _MM_HINT_NTA);
+        auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+        auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 32));
+        auto c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 64));
+        auto d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 96));
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst), a);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + 32), b);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + 64), c);
+        _mm256_stream_si256(reinterpret_cast<__m256i*>(dst + 96), d);
+    }
+    _mm_sfence();
+    std::memcpy(dst, src, bytes);
+}
+
+__attribute__((target("sse2")))
+inline void stream_copy_sse2(char* dst, const char* src, size_t bytes) noexcept {
+    for (; bytes >= 64; bytes -= 64, src += 64, dst += 64) {
+        _mm_prefetch(src + stream_prefetch_distance, _MM_HINT_NTA);
+        auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+        auto c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+        auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst), a);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 16), b);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 32), c);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + 48), d);
+    }
+    _mm_sfence();
+    std::memcpy(dst, src, bytes);
+}
+#endif
+
+// memcpy of non-overlapping ranges that keeps the destination (and, as far
+// as prefetching allows, the source) out of the cache. Picks AVX2 or SSE2
+// at runtime; elsewhere it is plain memcpy.
+inline void stream_copy(void* dst, const void* src, size_t bytes) noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    auto d = static_cast<char*>(dst);
+    auto s = static_cast<const char*>(src);
+    if (bytes >= 256) {
+        auto head = (32 - (reinterpret_cast<uintptr_t>(d) & 31)) & 31;
+        std::memcpy(d, s, head);
+        d += head;
+        s += head;
+        bytes -= head;
+        if (avx2) {
+            stream_copy_avx2(d, s, bytes);
+        } else {
+            stream_copy_sse2(d, s, bytes);
+        }
+        return;
+    }
+#endif
+    std::memcpy(dst, src, bytes);
+}
+
+// Opts the bytewise copies and relocations of uninit_copy and uninit_move
+// (vector's copy constructor and growth) of at least bytes into
+// stream_copy; SIZE_MAX turns it off, which is the default. Call it at
+// startup, before other threads use vectors.
+inline void set_stream_copy_threshold(size_t bytes = default_stream_copy_threshold()) noexcept {
+    large_copy.copy = bytes != ~size_t(0) ? stream_copy : nullptr;
+    large_copy.min_bytes = bytes;
+}
+
+inline size_t stream_copy_threshold() noexcept {
+    return large_copy.min_bytes;
+}
+
+} // namespace dl
@@ -0,0 +1,285 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+namespace dl {
+
+// Caches freed blocks per thread in power-of-two size classes, the sizes a
+// doubling vector asks for. A thread's cache is bounded per class and in
+// total; blocks beyond that, and all of them when the thread exits, go to a
+// shared depot that refills caches on a miss. Blocks are plain operator new
+// memory of the class size, so any thread may free any block.
+class tcache
+{
+public:
+    static constexpr size_t min_shift = 4;
+    static constexpr size_t max_shift = 27;
+    static constexpr size_t num_classes = max_shift - min_shift + 1;
+    static constexpr size_t thread_limit_bytes = size_t(64) << 20;
+    static constexpr size_t depot_limit_bytes = size_t(256) << 20;
+
+    // Index of the class serving bytes, num_classes if it is not cached.
+    static size_t class_index(size_t bytes) noexcept {
+        if (bytes <= class_size(0)) {
+            return 0;
+        }
+        auto shift = static_cast<size_t>(64 - __builtin_clzll(static_cast<unsigned long long>(bytes - 1)));
+        return std::min(shift - min_shift, num_classes);
+    }
+
+    static constexpr size_t class_size(size_t idx) noexcept {
+        return size_t(1) << (idx + min_shift);
+    }
+
+    // Blocks of a class a thread keeps: many small ones, few large ones.
+    static constexpr size_t bin_limit(size_t idx) noexcept {
+        return std::clamp<size_t>((size_t(1) << 20) >> (idx + min_shift), 2, 64);
+    }
+
+    static void* allocate(size_t bytes) {
+        auto idx = class_index(bytes);
+        if (idx == num_classes) {
+            return ::operator new(bytes);
+        }
+        if (auto cache = local()) {
+            if (auto b = cache->pop(idx)) {
+                return b;
+            }
+            if (refill(*cache, idx)) {
+                return cache->pop(idx);
+            }
+        } else if (auto b = depot_pop(idx)) {
+            return b;
+        }
+        return ::operator new(class_size(idx));
+    }
+
+    static void deallocate(void* p, size_t bytes) noexcept {
+        auto idx = class_index(bytes);
+        if (idx == num_classes) {
+            ::operator delete(p);
+            return;
+        }
+        auto b = static_cast<block*>(p);
+        auto cache = local();
+        if (cache && cache->bins[idx].count < bin_limit(idx)
+            && cache->bytes + class_size(idx) <= thread_limit_bytes) {
+            cache->push(idx, b);
+        } else {
+            depot_push(idx, b);
+        }
+    }
+
+    // Hands this thread's blocks to the depot.
+    static void flush() noexcept {
+        if (auto cache = local()) {
+            cache->flush();
+        }
+    }
+
+    // Frees the blocks held by the depot.
+    static void release() noexcept {
+        auto& d = shared();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        for (size_t idx = 0; idx < num_classes; ++idx) {
+            free_list(d.bins[idx].head);
+            d.bins[idx] = bin();
+        }
+        d.bytes = 0;
+    }
+
+    static size_t thread_bytes() noexcept {
+        auto cache = local();
+        return cache ? cache->bytes : 0;
+    }
+
+    static size_t depot_bytes() noexcept {
+        auto& d = shared();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        return d.bytes;
+    }
+
+private:
+    struct block
+    {
+        block* next;
+    };
+
+    struct bin
+    {
+        block* head = nullptr;
+        size_t count = 0;
+    };
+
+    enum class cache_state : unsigned char { fresh, alive, dead };
+
+    struct thread_cache
+    {
+        thread_cache() noexcept {
+            state() = cache_state::alive;
+        }
+
+        ~thread_cache() {
+            flush();
+            state() = cache_state::dead;
+        }
+
+        block* pop(size_t idx) noexcept {
+            auto& b = bins[idx];
+            auto head = b.head;
+            if (head != nullptr) {
+                b.head = head->next;
+                --b.count;
+                bytes -= class_size(idx);
+            }
+            return head;
+        }
+
+        void push(size_t idx, block* p) noexcept {
+            auto& b = bins[idx];
+            p->next = b.head;
+            b.head = p;
+            ++b.count;
+            bytes += class_size(idx);
+        }
+
+        void flush() noexcept {
+            for (size_t idx = 0; idx < num_classes; ++idx) {
+                while (auto p = pop(idx)) {
+                    depot_push(idx, p);
+                }
+            }
+        }
+
+        bin bins[num_classes];
+        size_t bytes = 0;
+    };
+
+    struct depot
+    {
+        std::mutex mutex;
+        bin bins[num_classes];
+        size_t bytes = 0;
+    };
+
+    static cache_state& state() noexcept {
+        thread_local cache_state s = cache_state::fresh;
+        return s;
+    }
+
+    // nullptr once the thread's cache has been destroyed (thread exit).
+    static thread_cache* local() noexcept {
+        if (state() == cache_state::dead) {
+            return nullptr;
+        }
+        thread_local thread_cache cache;
+        return &cache;
+    }
+
+    // Never destroyed: threads may still free blocks during static destruction.
+    static depot& shared() noexcept {
+        static depot* d = new depot;
+        return *d;
+    }
+
+    static void free_list(block* p) noexcept {
+        while (p != nullptr) {
+            auto next = p->next;
+            ::operator delete(p);
+            p = next;
+        }
+    }
+
+    static void depot_push(size_t idx, block* p) noexcept {
+        auto& d = shared();
+        {
+            std::lock_guard<std::mutex> lock(d.mutex);
+            if (d.bytes + class_size(idx) <= depot_limit_bytes) {
+                p->next = d.bins[idx].head;
+                d.bins[idx].head = p;
+                ++d.bins[idx].count;
+                d.bytes += class_size(idx);
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+
+    static block* depot_pop(size_t idx) noexcept {
+        auto& d = shared();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        auto& b = d.bins[idx];
+        auto head = b.head;
+        if (head != nullptr) {
+            b.head = head->next;
+            --b.count;
+            d.bytes -= class_size(idx);
+        }
+        return head;
+    }
+
+    // Moves up to half a bin worth of blocks from the depot in one lock.
+    static bool refill(thread_cache& cache, size_t idx) noexcept {
+        auto& d = shared();
+        std::lock_guard<std::mutex> lock(d.mutex);
+        auto& b = d.bins[idx];
+        auto n = std::min(b.count, std::max<size_t>(bin_limit(idx) / 2, 1));
+        for (size_t i = 0; i < n; ++i) {
+            auto head = b.head;
+            b.head = head->next;
+            cache.push(idx, head);
+        }
+        b.count -= n;
+        d.bytes -= n * class_size(idx);
+        return n != 0;
+    }
+};
+
+template<typename T>
+class tcache_allocator
+{
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using is_always_equal = std::true_type;
+
+public:
+    tcache_allocator() noexcept = default;
+
+    template<typename U>
+    tcache_allocator(const tcache_allocator<U>&) noexcept {}
+
+    T* allocate(size_type n) {
+        if (n > std::numeric_limits<size_type>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        } else {
+            return static_cast<T*>(tcache::allocate(n * sizeof(T)));
+        }
+    }
+
+    void deallocate(T* p, size_type n) noexcept {
+        if (p == nullptr) {
+            return;
+        }
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            ::operator delete(p, std::align_val_t(alignof(T)));
+        } else {
+            tcache::deallocate(p, n * sizeof(T));
+        }
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const tcache_allocator<T>&, const tcache_allocator<U>&) noexcept { return true; }
+
+template<typename T, typename U>
+bool operator!=(const tcache_allocator<T>&, const tcache_allocator<U>&) noexcept { return false; }
+
+} // namespace dl
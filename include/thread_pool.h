@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dl {
+
+// Fork-join pool: run() hands out task indices to the workers and to the
+// calling thread and returns when all of them are done.
+class thread_pool
+{
+public:
+    explicit thread_pool(size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+        threads = std::max<size_t>(threads, 1);
+        workers_.reserve(threads - 1);
+        for (size_t i = 1; i < threads; ++i) {
+            workers_.emplace_back([this] { work(); });
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& w : workers_) {
+            w.join();
+        }
+    }
+
+    size_t size() const noexcept { return workers_.size() + 1; }
+
+    static thread_pool& global() {
+        static thread_pool pool;
+        return pool;
+    }
+
+    // Calls fn(i) for every i in [0, n), rethrows the first exception thrown by fn.
+    template<typename F>
+    void run(size_t n, F&& fn) {
+        if (n == 0) {
+            return;
+        }
+        if (n == 1 || workers_.empty() || inside_worker()) {
+            for (size_t i = 0; i < n; ++i) {
+                fn(i);
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> run_lock(run_mutex_);
+        job j(std::ref(fn), n);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &j;
+            ++generation_;
+        }
+        wake_.notify_all();
+        inside_worker() = true;
+        execute(j);
+        inside_worker() = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [&] { return j.finished == n && j.active == 0; });
+            job_ = nullptr;
+        }
+        if (j.error) {
+            std::rethrow_exception(j.error);
+        }
+    }
+
+    // Splits [0, n) into at most size() * grain_factor contiguous ranges and calls fn(first, last).
+    template<typename F>
+    void for_range(size_t n, F&& fn, size_t grain_factor = 4) {
+        auto tasks = std::min(n, size() * grain_factor);
+        run(tasks, [&](size_t t) {
+            fn(n * t / tasks, n * (t + 1) / tasks);
+        });
+    }
+
+private:
+    struct job
+    {
+        job(std::function<void(size_t)> f, size_t count) : fn(std::move(f)), n(count) {}
+
+        std::function<void(size_t)> fn;
+        size_t n;
+        std::atomic<size_t> next{0};
+        size_t finished = 0;
+        size_t active = 0;
+        std::exception_ptr error;
+    };
+
+    static bool& inside_worker() {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+    void execute(job& j) {
+        size_t count = 0;
+        for (size_t i; (i = j.next.fetch_add(1)) < j.n; ++count) {
+            try {
+                j.fn(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!j.error) {
+                    j.error = std::current_exception();
+                }
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        j.finished += count;
+    }
+
+    void work() {
+        inside_worker() = true;
+        size_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [&] { return stop_ || (job_ != nullptr && generation_ != seen); });
+            if (stop_) {
+                return;
+            }
+            seen = generation_;
+            auto j = job_;
+            ++j->active;
+            lock.unlock();
+            execute(*j);
+            lock.lock();
+            --j->active;
+            if (j->finished == j->n && j->active == 0) {
+                done_.notify_all();
+            }
+        }
+    }
+
+private:
+    std::vector<std::thread> workers_;
+    std::mutex run_mutex_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    job* job_ = nullptr;
+    size_t generation_ = 0;
+    bool stop_ = false;
+};
+
+} // namespace dl
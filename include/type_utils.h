@@ -14,5 +14,13 @@ using is_input_iter =
     typename std::is_convertible<typename std::iterator_traits<T>::iterator_category,
                                  std::input_iterator_tag>;
 
+// Lazy element-wise expressions (vector_expr.h), which containers evaluate
+// on assignment.
+template<typename T, typename = void>
+struct is_vector_expr : std::false_type {};
+
+template<typename T>
+struct is_vector_expr<T, std::void_t<typename T::vector_expr_tag>> : std::true_type {};
+
 
 } // namespace dl
@@ -1,6 +1,7 @@
 #pragma once
 #include <cstddef>
 #include <algorithm>
+#include <cassert>
 #include <initializer_list>
 #include <iterator>
 #include <memory>
@@ -8,19 +9,46 @@
 #include <stdexcept>
 #include <type_traits>
 #include "compressed_pair.h"
+#include "growth_profile.h"
+#include "memory.h"
+#include "ranges.h"
+#include "shrink_policy.h"
 #include "split_buffer.h"
 #include "type_utils.h"
 #include "algorithm.h"
 
 namespace dl {
 
-template<typename T, typename Allocator = std::allocator<T>>
+// The overloads taking a parallel_policy need execution.h, which brings in
+// the thread pool; plain vector users do not.
+class parallel_policy;
+
+template<typename F>
+void parallel_for(const parallel_policy& policy, size_t n, size_t item_bytes, F&& fn);
+
+template<typename Allocator, typename Pointer, typename Construct>
+Pointer parallel_construct(const parallel_policy& policy, Allocator& alloc,
+                           Pointer first, size_t n, Construct construct_one);
+
+// A buffer handed out by vector::release(): the first size elements are
+// constructed. Typed by the allocator, so only a vector with the same
+// allocator type can adopt it; that allocator must also compare equal.
+template<typename Allocator>
+struct vector_buffer
+{
+    typename std::allocator_traits<Allocator>::pointer data;
+    size_t size;
+    size_t capacity;
+};
+
+template<typename T, typename Allocator = std::allocator<T>, typename ShrinkPolicy = no_shrink>
 class vector
 {
 public: // aliases
     using value_type = T;
     using allocator_type = Allocator;
     using allocator_traits = std::allocator_traits<allocator_type>;
+    using shrink_policy_type = ShrinkPolicy;
     using pointer = typename allocator_traits::pointer;
     using const_pointer = typename allocator_traits::const_pointer;
     using reference = value_type&;
@@ -34,17 +62,29 @@ public: // aliases
     using reverse_iterator = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
+    class appender;
+
+    using buffer = vector_buffer<allocator_type>;
+
 public: // constructors
     vector() noexcept = default;
 
     explicit vector(const allocator_type& alloc) noexcept
-        : end_cap_allocator_(nullptr, alloc) {}
+        : end_cap_allocator_(nullptr, alloc, shrink_policy_type()) {}
+
+    explicit vector(const shrink_policy_type& policy, const allocator_type& alloc = allocator_type()) noexcept
+        : end_cap_allocator_(nullptr, alloc, policy) {}
 
     explicit vector(size_type count,
                     const allocator_type& a = allocator_type())
         : vector(a) {
-        allocate_n(count);
-        end_ = construct(alloc(), begin_, begin_ + count);
+        if constexpr (zeroed_value_init_v<allocator_type>) {
+            allocate_n(count, zeroed);
+            end_ = begin_ + count;
+        } else {
+            allocate_n(count);
+            end_ = construct(alloc(), begin_, begin_ + count);
+        }
     }
 
     vector(size_type count, const value_type& value,
@@ -54,6 +94,24 @@ public: // constructors
         end_ = construct(alloc(), begin_, begin_ + count, value);
     }
 
+    vector(const parallel_policy& policy, size_type count,
+           const allocator_type& a = allocator_type())
+        : vector(a) {
+        allocate_n(count);
+        end_ = parallel_construct(policy, alloc(), begin_, count, [this](pointer p, size_type) {
+                                      allocator_traits::construct(alloc(), p);
+                                  });
+    }
+
+    vector(const parallel_policy& policy, size_type count, const value_type& value,
+           const allocator_type& a = allocator_type())
+        : vector(a) {
+        allocate_n(count);
+        end_ = parallel_construct(policy, alloc(), begin_, count, [&](pointer p, size_type) {
+                                      allocator_traits::construct(alloc(), p, value);
+                                  });
+    }
+
     template<typename I,
              std::enable_if_t<is_forward_iter<I>::value, int> = 0>
     vector(I first, I last, const allocator_type& a = allocator_type())
@@ -70,41 +128,104 @@ public: // constructors
         }
     }
 
+    template<typename R>
+    vector(from_range_t, R&& range, const allocator_type& a = allocator_type())
+        : vector(a) {
+        append_range(std::forward<R>(range));
+    }
+
     vector(std::initializer_list<value_type> list, const allocator_type& a = allocator_type())
         : vector(a) {
         create(list.begin(), list.end());
     }
 
+    // Evaluates an element-wise expression in one pass, see vector_expr.h.
+    template<typename E, std::enable_if_t<is_vector_expr<E>::value, int> = 0>
+    vector(const E& expr, const allocator_type& a = allocator_type())
+        : vector(a) {
+        assign(expr);
+    }
+
     vector(const vector& other)
-        : vector(allocator_traits::select_on_container_copy_construction(other.alloc())) {
+        : vector(other.shrink_policy(), allocator_traits::select_on_container_copy_construction(other.alloc())) {
         create(other.begin_, other.end_);
     }
 
     vector(const vector& other, const allocator_type& a)
-        : vector(a) {
+        : vector(other.shrink_policy(), a) {
         create(other.begin_, other.end_);
     }
 
+    vector(const parallel_policy& policy, const vector& other)
+        : vector(policy, other, allocator_traits::select_on_container_copy_construction(other.alloc())) {}
+
+    vector(const parallel_policy& policy, const vector& other, const allocator_type& a)
+        : vector(other.shrink_policy(), a) {
+        allocate_n(other.size());
+        auto src = other.begin_;
+        end_ = parallel_construct(policy, alloc(), begin_, other.size(), [&](pointer p, size_type i) {
+                                      allocator_traits::construct(alloc(), p, src[i]);
+                                  });
+    }
+
     vector(vector&& other)
-        : vector(other.alloc()) {
-        begin_ = other.begin_;
-        end_ = other.end_;
-        end_cap() = other.end_cap();
-        other.begin_ = other.end_ = other.end_cap() = nullptr;
+        : vector(other.shrink_policy(), other.alloc()) {
+        steal(other);
     }
 
     vector(vector&& other, const allocator_type& a)
-        : vector(a) {
+        : vector(other.shrink_policy(), a) {
         if (other.alloc() == a) {
-            begin_ = other.begin_;
-            end_ = other.end_;
-            end_cap() = other.end_cap();
-            other.begin_ = other.end_ = other.end_cap() = nullptr;
+            steal(other);
         } else {
             create(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
         }
     }
 
+    vector& operator=(const vector& other) {
+        if (this != &other) {
+            if constexpr (allocator_traits::propagate_on_container_copy_assignment::value) {
+                if (alloc() != other.alloc()) {
+                    release_buffer();
+                }
+                alloc() = other.alloc();
+            }
+            assign(other.begin_, other.end_);
+        }
+        return *this;
+    }
+
+    // Steals the buffer when the allocator propagates or compares equal,
+    // moves element-wise into the own allocator's memory otherwise.
+    vector& operator=(vector&& other) noexcept(allocator_traits::propagate_on_container_move_assignment::value
+                                               || allocator_traits::is_always_equal::value) {
+        if (this == &other) {
+            return *this;
+        }
+        if constexpr (allocator_traits::propagate_on_container_move_assignment::value) {
+            release_buffer();
+            alloc() = std::move(other.alloc());
+            steal(other);
+        } else if (allocator_traits::is_always_equal::value || alloc() == other.alloc()) {
+            release_buffer();
+            steal(other);
+        } else {
+            assign(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()));
+        }
+        return *this;
+    }
+
+    vector& operator=(std::initializer_list<value_type> list) {
+        assign(list.begin(), list.end());
+        return *this;
+    }
+
+    template<typename E, std::enable_if_t<is_vector_expr<E>::value, int> = 0>
+    vector& operator=(const E& expr) {
+        assign(expr);
+        return *this;
+    }
+
 public: // access members
     const value_type* data() const noexcept { return begin_; }
     value_type* data() noexcept             { return begin_; }
@@ -156,6 +277,15 @@ public: // access members
         return alloc();
     }
 
+    const shrink_policy_type& shrink_policy() const noexcept {
+        return get<2>(end_cap_allocator_);
+    }
+
+    void set_shrink_policy(const shrink_policy_type& policy) {
+        get<2>(end_cap_allocator_) = policy;
+        maybe_shrink();
+    }
+
 public: // assigns
     template<typename I>
     std::enable_if_t<is_forward_iter<I>::value, void>
@@ -187,10 +317,31 @@ public: // assigns
         }
     }
 
+    void assign(const parallel_policy& policy, size_type n, const value_type& value) {
+        if (n > capacity()) {
+            split_buffer<value_type, allocator_type&> buff(0, n, alloc());
+            buff.end = parallel_construct(policy, alloc(), buff.begin, n, [&](pointer p, size_type) {
+                                              allocator_traits::construct(alloc(), p, value);
+                                          });
+            swap(buff);
+        } else {
+            const value_type v(value); // value may live in this vector
+            auto sz = size();
+            parallel_for(policy, std::min(n, sz), sizeof(value_type), [&](size_type lo, size_type hi) {
+                             std::fill(begin_ + lo, begin_ + hi, v);
+                         });
+            end_ = (n < sz)
+                ? destroy(alloc(), begin_ + n, end_)
+                : parallel_construct(policy, alloc(), end_, n - sz, [&](pointer p, size_type) {
+                                         allocator_traits::construct(alloc(), p, v);
+                                     });
+        }
+    }
+
     template<typename I>
     std::enable_if_t<is_input_iter<I>::value && !is_forward_iter<I>::value, void>
     assign(I first, I last) {
-        clear();
+        end_ = destroy(alloc(), begin_, end_);
         for (; first != last; ++first) {
             emplace_back(*first);
         }
@@ -200,9 +351,54 @@ public: // assigns
         assign(list.begin(), list.end());
     }
 
+    // Allocates once for the expression's size and evaluates it in a single
+    // loop. The expression may refer to this vector: element i is read
+    // before it is written, and a new buffer is filled before the old one is
+    // released.
+    template<typename E>
+    std::enable_if_t<is_vector_expr<E>::value, void>
+    assign(const E& expr) {
+        static_assert(std::is_arithmetic_v<value_type>, "element-wise expressions are for arithmetic types");
+        auto n = static_cast<size_type>(expr.size());
+        if (n > capacity()) {
+            split_buffer<value_type, allocator_type&> buff(n, n, alloc());
+            auto out = buff.begin;
+            for (size_type i = 0; i < n; ++i) {
+                allocator_traits::construct(alloc(), out + i, expr[i]);
+            }
+            swap(buff);
+        } else {
+            auto out = begin_;
+            for (size_type i = 0; i < n; ++i) {
+                allocator_traits::construct(alloc(), out + i, expr[i]);
+            }
+            auto old_end = end_;
+            end_ = begin_ + n;
+            if (end_ < old_end) {
+                maybe_shrink();
+            }
+        }
+    }
+
+    template<typename R>
+    void assign_range(R&& range) {
+        auto first = std::begin(range);
+        auto last = std::end(range);
+        if constexpr (is_forward_iter<decltype(first)>::value) {
+            assign(first, last);
+        } else {
+            end_ = destroy(alloc(), begin_, end_);
+            reserve(size_hint(range));
+            for (; first != last; ++first) {
+                emplace_back(*first);
+            }
+        }
+    }
+
 public: // other modification members
     void clear() noexcept {
         end_ = destroy(alloc(), begin_, end_);
+        maybe_shrink();
     }
 
     void reserve(size_type n) {
@@ -212,31 +408,73 @@ public: // other modification members
         }
     }
 
-    void resize(size_type n) {
+    void resize(size_type n DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
+        if constexpr (zeroed_value_init_v<allocator_type>) {
+            if (n > capacity()) {
+                split_buffer<value_type, allocator_type&> buff(n, calc_size(n), alloc(), zeroed);
+                swap_out_buffer(buff);
+                return;
+            }
+        }
         resize_impl(n, [this](pointer begin, pointer end) {
                            return construct(alloc(), begin, end);
                        });
     }
 
-    void resize(size_type n, const value_type& value) {
+    void resize(size_type n, const value_type& value DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
         resize_impl(n, [&](pointer begin, pointer end) {
                            return construct(alloc(), begin, end, value);
                        });
     }
 
-    void push_back(const_reference elem) {
+    // New elements of trivially constructible types are left uninitialized.
+    void resize_for_overwrite(size_type n DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
+        resize_impl(n, [&](pointer begin, pointer end) {
+                           if constexpr (std::is_trivially_default_constructible_v<value_type>) {
+                               return end;
+                           } else {
+                               return construct(alloc(), begin, end);
+                           }
+                       });
+    }
+
+    void resize(const parallel_policy& policy, size_type n DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
+        resize_impl(n, [&](pointer begin, pointer end) {
+                           return parallel_construct(policy, alloc(), begin, end - begin, [this](pointer p, size_type) {
+                                                         allocator_traits::construct(alloc(), p);
+                                                     });
+                       });
+    }
+
+    void resize(const parallel_policy& policy, size_type n, const value_type& value DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
+        resize_impl(n, [&](pointer begin, pointer end) {
+                           return parallel_construct(policy, alloc(), begin, end - begin, [&](pointer p, size_type) {
+                                                         allocator_traits::construct(alloc(), p, value);
+                                                     });
+                       });
+    }
+
+    void push_back(const_reference elem DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
         emplace_back(elem);
     }
 
-    void push_back(value_type&& elem) {
+    void push_back(value_type&& elem DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
         emplace_back(std::move(elem));
     }
 
     template<typename... Args>
-    reference emplace_back(Args&&... args) {
+    DL_GROWTH_CALLER_INLINE reference emplace_back(Args&&... args) {
         if (end_ != end_cap()) {
             fast_push_back(std::forward<Args>(args)...);
         } else {
+            DL_GROWTH_CALLER_SCOPE;
             split_buffer<value_type, allocator_type &> buff(size(), calc_size(size() + 1), alloc());
             buff.emplace_back(std::forward<Args>(args)...);
             swap_out_buffer(buff);
@@ -244,17 +482,45 @@ public: // other modification members
         return back();
     }
 
-    iterator insert(const_iterator pos, const value_type& value) {
+    // Requires spare capacity, e.g. after reserve().
+    template<typename... Args>
+    reference emplace_back_unchecked(Args&&... args) {
+        assert(end_ != end_cap() && "emplace_back_unchecked without spare capacity");
+        fast_push_back(std::forward<Args>(args)...);
+        return back();
+    }
+
+    // Appends gen(i) for i in [0, n) (or gen() if it takes no index) after a single capacity check.
+    template<typename Generator>
+    void append_n(size_type n, Generator gen DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
+        if (n > static_cast<size_type>(end_cap() - end_)) {
+            reserve(calc_size(size() + n));
+        }
+        appender app(*this);
+        for (size_type i = 0; i != n; ++i) {
+            if constexpr (std::is_invocable_v<Generator&, size_type>) {
+                app.emplace_back_unchecked(gen(i));
+            } else {
+                app.emplace_back_unchecked(gen());
+            }
+        }
+    }
+
+    iterator insert(const_iterator pos, const value_type& value DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
         return insert_impl(pos - begin(), value);
     }
 
-    iterator insert(const_iterator pos, value_type&& value) {
+    iterator insert(const_iterator pos, value_type&& value DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
         return insert_impl(pos - begin(), std::move(value));
     }
 
     template<typename I>
     std::enable_if_t<is_forward_iter<I>::value, iterator>
-    insert(const_iterator cpos, I first, I last) {
+    insert(const_iterator cpos, I first, I last DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
         auto n = std::distance(first, last);
         auto idx = cpos - begin();
         auto pos = begin_ + idx;
@@ -275,7 +541,8 @@ public: // other modification members
         return begin() + idx;
     }
 
-    iterator insert(const_iterator cpos, size_type n, const value_type& value) {
+    iterator insert(const_iterator cpos, size_type n, const value_type& value DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
         auto idx = cpos - begin();
         auto pos = begin_ + idx;
         if (end_cap() < end_ + n) {
@@ -298,13 +565,15 @@ public: // other modification members
         return begin() + idx;
     }
 
-    iterator insert(const_iterator pos, std::initializer_list<value_type> list) {
+    iterator insert(const_iterator pos, std::initializer_list<value_type> list DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
         insert(pos, list.begin(), list.end());
     }
 
     template<typename I>
     std::enable_if_t<is_input_iter<I>::value && !is_forward_iter<I>::value, iterator>
-    insert(const_iterator cpos, I first, I last) {
+    insert(const_iterator cpos, I first, I last DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
         auto idx = cpos - begin();
         auto old_size = size();
         for (; first != last && end_ != end_cap(); ++first) {
@@ -320,11 +589,69 @@ public: // other modification members
         return begin() + idx;
     }
 
+    template<typename R>
+    void append_range(R&& range DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
+        auto first = std::begin(range);
+        auto last = std::end(range);
+        if constexpr (is_forward_iter<decltype(first)>::value) {
+            insert(end(), first, last);
+        } else {
+            if (auto n = size() + size_hint(range); n > capacity()) {
+                reserve(calc_size(n));
+            }
+            for (; first != last; ++first) {
+                emplace_back(*first);
+            }
+        }
+    }
+
+    // Single-pass ranges with a size hint are read once: into a new buffer
+    // between the moved head and tail, or into a gap opened at pos.
+    template<typename R>
+    iterator insert_range(const_iterator cpos, R&& range DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
+        auto first = std::begin(range);
+        auto last = std::end(range);
+        if constexpr (is_forward_iter<decltype(first)>::value) {
+            return insert(cpos, first, last);
+        } else {
+            auto idx = cpos - begin();
+            auto n = static_cast<difference_type>(size_hint(range));
+            if (n == 0) {
+                return insert(cpos, first, last);
+            }
+            difference_type k = 0;
+            if (end_cap() - end_ < n) {
+                auto tail = end_ - (begin_ + idx);
+                split_buffer<value_type, allocator_type &> buff(idx, calc_size(size() + n), alloc());
+                try {
+                    for (; first != last && buff.end_cap() - buff.end > tail; ++first, ++k) {
+                        buff.emplace_back(*first);
+                    }
+                } catch (...) {
+                    // [buff.begin, buff.begin + idx) was never constructed
+                    destroy(alloc(), buff.begin + idx, buff.end);
+                    buff.end = buff.begin;
+                    throw;
+                }
+                swap_out_buffer(buff, begin_ + idx);
+            } else {
+                k = fill_gap(begin_ + idx, n, first, last);
+            }
+            if (first != last) {
+                insert(begin_ + idx + k, first, last);
+            }
+            return begin() + idx;
+        }
+    }
+
     template<typename... Args>
-    iterator emplace(const_iterator cpos, Args&&... args) {
+    DL_GROWTH_CALLER_INLINE iterator emplace(const_iterator cpos, Args&&... args) {
         auto idx = cpos - begin();
         auto pos = begin_ + idx;
         if (end_ == end_cap()) {
+            DL_GROWTH_CALLER_SCOPE;
             split_buffer<value_type, allocator_type &> buff(idx, calc_size(size() + 1), alloc());
             buff.emplace_back(std::forward<Args>(args)...);
             swap_out_buffer(buff, pos);
@@ -342,6 +669,7 @@ public: // other modification members
     void pop_back() {
         allocator_traits::destroy(alloc(), end_ - 1);
         --end_;
+        maybe_shrink();
     }
 
     iterator erase(const_iterator pos) {
@@ -352,41 +680,79 @@ public: // other modification members
     }
 
     iterator erase(const_iterator cfirst, const_iterator clast) {
-        auto first = begin_ + (cfirst - begin());
+        auto idx = cfirst - begin();
+        auto first = begin_ + idx;
         auto last = begin_ + (clast - begin());
         std::move(last, end(), first);
         end_ = destroy(alloc(), end_ - (last - first), end_);
-        return first;
+        maybe_shrink();
+        return begin() + idx;
     }
 
+    // Allocators are exchanged only if they propagate on swap; otherwise they
+    // must compare equal. Shrink policies stay with their vectors.
     void swap(vector& other) noexcept {
+        assert((allocator_traits::propagate_on_container_swap::value || alloc() == other.alloc())
+               && "swap of vectors with unequal allocators");
         std::swap(begin_, other.begin_);
         std::swap(end_, other.end_);
-        std::swap(end_cap_allocator_, other.end_cap_allocator_);
+        std::swap(end_cap(), other.end_cap());
+        if constexpr (allocator_traits::propagate_on_container_swap::value) {
+            using std::swap;
+            swap(alloc(), other.alloc());
+        }
     }
 
     void shrink_to_fit() {
         if (capacity() != size()) {
-            split_buffer<value_type, allocator_type&> buff(size(), size(), alloc());
-            swap_out_buffer(buff);
+            shrink_to(size());
         }
     }
 
+    // Takes ownership of a buffer of capacity elements, the first size of them
+    // constructed, that was allocated by an allocator equal to this one (for
+    // malloc'd memory, dl::malloc_allocator). The old contents are freed.
+    void adopt(pointer data, size_type size, size_type capacity) noexcept {
+        assert(size <= capacity && (data != nullptr || capacity == 0) && "adopt of an invalid buffer");
+        release_buffer();
+        begin_ = data;
+        end_ = data + size;
+        end_cap() = data + capacity;
+    }
+
+    void adopt(buffer buff) noexcept {
+        adopt(buff.data, buff.size, buff.capacity);
+    }
+
+    // Gives up the buffer without destroying or copying the elements and
+    // leaves the vector empty. The caller frees it with get_allocator().
+    [[nodiscard]] buffer release() noexcept {
+        buffer buff{begin_, size(), capacity()};
+        begin_ = end_ = end_cap() = nullptr;
+        return buff;
+    }
+
     ~vector() {
-        clear();
-        allocator_traits::deallocate(alloc(), begin_, capacity());
+        static_assert(!is_compressible_v<allocator_type> || !is_compressible_v<shrink_policy_type>
+                      || sizeof(vector) == 3 * sizeof(pointer), "Empty policies must not grow vector");
+        release_buffer();
     }
 
 private:
+    // Called once per reallocation made to grow, which the growth profile
+    // counts. Never 0; spelling that out stops GCC from warning about stores
+    // into an empty buffer when the relocation is not inlined.
     size_t calc_size(size_t new_size) const noexcept {
-        return std::max(new_size, capacity() * 2);
+        auto n = std::max({new_size, capacity() * 2, size_t(1)});
+        DL_GROWTH_RECORD(size() * sizeof(value_type), n * sizeof(value_type));
+        return n;
     }
 
-    allocator_type& alloc()             { return end_cap_allocator_.second(); }
-    const allocator_type& alloc() const { return end_cap_allocator_.second(); }
+    allocator_type& alloc()             { return get<1>(end_cap_allocator_); }
+    const allocator_type& alloc() const { return get<1>(end_cap_allocator_); }
 
-    pointer& end_cap()             { return end_cap_allocator_.first(); }
-    const pointer& end_cap() const { return end_cap_allocator_.first(); }
+    pointer& end_cap()             { return get<0>(end_cap_allocator_); }
+    const pointer& end_cap() const { return get<0>(end_cap_allocator_); }
 
     void swap_out_buffer(split_buffer<value_type, allocator_type&>& buff) {
         uninit_move(buff.alloc(), begin_, end_, buff.begin);
@@ -407,20 +773,66 @@ private:
 
     template<typename... Args>
     void fast_push_back(Args&&... elem) {
-        allocator_traits::construct(alloc(), end_++, std::forward<Args>(elem)...);
+        push_back_at(end_, std::forward<Args>(elem)...);
+    }
+
+    template<typename... Args>
+    void push_back_at(pointer& end, Args&&... elem) {
+        allocator_traits::construct(alloc(), end, std::forward<Args>(elem)...);
+        ++end;
     }
 
     template<typename Constructor>
     void resize_impl(size_type n, const Constructor& constructor) {
         auto sz = size();
         if (n > capacity()) {
-            split_buffer<value_type, allocator_type &> buff(n, calc_size(n), alloc());
-            constructor(buff.begin + sz, buff.end);
+            split_buffer<value_type, allocator_type &> buff(0, calc_size(n), alloc());
+            buff.end = constructor(buff.begin + sz, buff.begin + n);
             swap_out_buffer(buff);
+        } else if (n < sz) {
+            end_ = destroy(alloc(), begin_ + n, end_);
+            maybe_shrink();
         } else {
-            end_ = (n < sz)
-                ? destroy(alloc(), begin_ + n, end_)
-                : constructor(end_, begin_ + n);
+            end_ = constructor(end_, begin_ + n);
+        }
+    }
+
+    // Moves the elements into a buffer of n >= size() elements, or gives back
+    // the tail of the current one if the allocator can.
+    void shrink_to(size_type n) {
+        if constexpr (has_shrink_in_place<allocator_type>::value) {
+            if (n != 0 && alloc().shrink_in_place(begin_, capacity(), n)) {
+                end_cap() = begin_ + n;
+                return;
+            }
+        }
+        if (n == 0) {
+            allocator_traits::deallocate(alloc(), begin_, capacity());
+            begin_ = end_ = end_cap() = nullptr;
+            return;
+        }
+        split_buffer<value_type, allocator_type&> buff(0, n, alloc());
+        if constexpr (std::is_nothrow_move_constructible_v<value_type>) {
+            buff.end = uninit_move(alloc(), begin_, end_, buff.begin);
+        } else {
+            // buff.end follows each copy, so a throw frees the new buffer and keeps the old one
+            for (auto p = begin_; p != end_; ++p) {
+                buff.emplace_back(std::move_if_noexcept(*p));
+            }
+        }
+        swap(buff);
+    }
+
+    // Shrinking only saves memory, so a failed reallocation keeps the old buffer.
+    void maybe_shrink() noexcept {
+        if constexpr (!std::is_same_v<shrink_policy_type, no_shrink>) {
+            auto target = std::max(shrink_policy().shrink_target(size(), capacity()), size());
+            if (target < capacity()) {
+                try {
+                    shrink_to(target);
+                } catch (...) {
+                }
+            }
         }
     }
 
@@ -433,28 +845,92 @@ private:
             swap_out_buffer(buff, pos);
         } else if (pos != end_) {
             end_ = right_shift(pos, 1);
-            auto vr = std::pointer_traits<const_pointer>::pointer_to(value);
-            if (pos <= vr && vr < end_) {
-                ++vr;
+            if constexpr (std::is_lvalue_reference_v<U>) {
+                auto vr = std::pointer_traits<const_pointer>::pointer_to(value);
+                if (pos <= vr && vr < end_) {
+                    ++vr;
+                }
+                *pos = *vr;
+            } else {
+                *pos = std::move(value);
             }
-            *pos = std::forward<U>(*vr);
         } else {
             fast_push_back(std::forward<U>(value));
         }
         return begin() + idx;
     }
 
+    void steal(vector& other) noexcept {
+        begin_ = other.begin_;
+        end_ = other.end_;
+        end_cap() = other.end_cap();
+        other.begin_ = other.end_ = other.end_cap() = nullptr;
+    }
+
+    void release_buffer() noexcept {
+        end_ = destroy(alloc(), begin_, end_);
+        allocator_traits::deallocate(alloc(), begin_, capacity());
+        begin_ = end_ = end_cap() = nullptr;
+    }
+
     void allocate_n(size_type n) {
         end_ = begin_ = allocator_traits::allocate(alloc(), n);
         end_cap() = begin_ + n;
     }
 
+    void allocate_n(size_type n, zeroed_t) {
+        end_ = begin_ = alloc().allocate_zeroed(n);
+        end_cap() = begin_ + n;
+    }
+
     template<typename I>
     void create(I first, I last) {
         allocate_n(std::distance(first, last));
         end_ = uninit_copy(alloc(), first, last, end_);
     }
 
+    // Opens a gap of n at pos (capacity must suffice), fills it from [first, last)
+    // and closes whatever part of the gap the input did not fill.
+    template<typename I>
+    difference_type fill_gap(pointer pos, difference_type n, I& first, I& last) {
+        auto old_end = end_;
+        end_ = right_shift(pos, n);
+        auto live_end = std::min(old_end, pos + n); // gap slots below it hold moved-from elements
+        difference_type k = 0;
+        auto close_gap = [&] {
+            auto filled_end = std::max(live_end, pos + k);
+            auto dst = pos + k;
+            for (auto src = pos + n; src != end_; ++src, ++dst) {
+                if (dst < filled_end || dst >= pos + n) {
+                    *dst = std::move(*src);
+                } else {
+                    allocator_traits::construct(alloc(), dst, std::move(*src));
+                }
+            }
+            if (dst < filled_end) {
+                destroy(alloc(), dst, filled_end);
+            }
+            destroy(alloc(), std::max(dst, pos + n), end_);
+            end_ = dst;
+        };
+        try {
+            for (; k < n && first != last; ++first, ++k) {
+                if (pos + k < live_end) {
+                    pos[k] = *first;
+                } else {
+                    allocator_traits::construct(alloc(), pos + k, *first);
+                }
+            }
+        } catch (...) {
+            close_gap();
+            throw;
+        }
+        if (k < n) {
+            close_gap();
+        }
+        return k;
+    }
+
     pointer right_shift(pointer pos, difference_type n) {
         auto part = end_ - std::min(n, end_ - pos);
         if (part != end_) {
@@ -467,36 +943,113 @@ private:
 private:
     pointer begin_ = nullptr;
     pointer end_ = nullptr;
-    compressed_pair<pointer, allocator_type> end_cap_allocator_;
+    compressed_tuple<pointer, allocator_type, shrink_policy_type> end_cap_allocator_;
+};
+
+// Keeps the end and capacity pointers of a vector in locals so a producing
+// loop does not reload them after every element. The vector must not be used
+// directly while an appender is alive; it sees the new elements on commit()
+// or when the appender is destroyed.
+template<typename T, typename Allocator, typename ShrinkPolicy>
+class vector<T, Allocator, ShrinkPolicy>::appender
+{
+public:
+    explicit appender(vector& vec) noexcept
+        : vec_(vec)
+        , end_(vec.end_)
+        , cap_(vec.end_cap()) {}
+
+    appender(const appender&) = delete;
+    appender& operator=(const appender&) = delete;
+
+    ~appender() {
+        commit();
+    }
+
+    template<typename... Args>
+    DL_GROWTH_CALLER_INLINE reference emplace_back(Args&&... args) {
+        if (end_ == cap_) {
+            DL_GROWTH_CALLER_SCOPE;
+            commit();
+            vec_.emplace_back(std::forward<Args>(args)...);
+            reload();
+            return end_[-1];
+        }
+        return emplace_back_unchecked(std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    reference emplace_back_unchecked(Args&&... args) {
+        assert(end_ != cap_ && "emplace_back_unchecked without spare capacity");
+        vec_.push_back_at(end_, std::forward<Args>(args)...);
+        return end_[-1];
+    }
+
+    void push_back(const value_type& value DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
+        emplace_back(value);
+    }
+
+    void push_back(value_type&& value DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
+        emplace_back(std::move(value));
+    }
+
+    // Makes room for n more elements.
+    void reserve(size_type n DL_GROWTH_SITE) {
+        DL_GROWTH_SCOPE;
+        if (static_cast<size_type>(cap_ - end_) < n) {
+            commit();
+            vec_.reserve(vec_.calc_size(vec_.size() + n));
+            reload();
+        }
+    }
+
+    size_type size() const noexcept { return static_cast<size_type>(end_ - vec_.begin_); }
+
+    void commit() noexcept {
+        vec_.end_ = end_;
+    }
+
+private:
+    void reload() noexcept {
+        end_ = vec_.end_;
+        cap_ = vec_.end_cap();
+    }
+
+private:
+    vector& vec_;
+    pointer end_;
+    pointer cap_;
 };
 
-template<typename T, typename Alloc>
-bool operator==(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs) {
+template<typename T, typename Alloc, typename P>
+bool operator==(const vector<T, Alloc, P>& lhs, const vector<T, Alloc, P>& rhs) {
     return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template<typename T, typename Alloc>
-bool operator!=(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs) {
+template<typename T, typename Alloc, typename P>
+bool operator!=(const vector<T, Alloc, P>& lhs, const vector<T, Alloc, P>& rhs) {
     return !(lhs == rhs);
 }
 
-template<typename T, typename Alloc>
-bool operator<(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs) {
+template<typename T, typename Alloc, typename P>
+bool operator<(const vector<T, Alloc, P>& lhs, const vector<T, Alloc, P>& rhs) {
     return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
 }
 
-template<typename T, typename Alloc>
-bool operator<=(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs) {
+template<typename T, typename Alloc, typename P>
+bool operator<=(const vector<T, Alloc, P>& lhs, const vector<T, Alloc, P>& rhs) {
     return !(lhs > rhs);
 }
 
-template<typename T, typename Alloc>
-bool operator>(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs) {
+template<typename T, typename Alloc, typename P>
+bool operator>(const vector<T, Alloc, P>& lhs, const vector<T, Alloc, P>& rhs) {
     return rhs < lhs;
 }
 
-template<typename T, typename Alloc>
-bool operator>=(const vector<T, Alloc>& lhs, const vector<T, Alloc>& rhs) {
+template<typename T, typename Alloc, typename P>
+bool operator>=(const vector<T, Alloc, P>& lhs, const vector<T, Alloc, P>& rhs) {
     return !(lhs < rhs);
 }
 
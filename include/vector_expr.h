@@ -0,0 +1,284 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include "type_utils.h"
+#include "vector.h"
+
+namespace dl {
+
+// Lazy element-wise expressions over vectors of arithmetic types:
+//
+//     dl::vector<float> c = a * b + d;
+//     auto n = dl::count(a < 0.5f);
+//
+// An expression holds its operands by reference and computes nothing until
+// it is assigned to a vector or reduced; then the whole tree runs as one
+// loop, without temporary vectors. Operands of an expression must have equal
+// sizes, and the vectors it refers to must outlive it. Vectors compared with
+// each other keep the lexicographic operators; wrap one side in lazy() for
+// element-wise comparison.
+
+template<typename T>
+class vector_ref
+{
+public:
+    using vector_expr_tag = void;
+    using value_type = T;
+
+    vector_ref(const T* data, size_t size) noexcept
+        : data_(data)
+        , size_(size) {}
+
+    size_t size() const noexcept { return size_; }
+    const T& operator[](size_t i) const noexcept { return data_[i]; }
+
+private:
+    const T* data_;
+    size_t size_;
+};
+
+// A scalar operand, the same value at every index.
+template<typename T>
+class scalar_expr
+{
+public:
+    using value_type = T;
+
+    explicit scalar_expr(T value) noexcept : value_(value) {}
+
+    T operator[](size_t) const noexcept { return value_; }
+
+private:
+    T value_;
+};
+
+template<typename T>
+struct is_scalar_expr : std::false_type {};
+
+template<typename T>
+struct is_scalar_expr<scalar_expr<T>> : std::true_type {};
+
+template<typename Op, typename E>
+class unary_expr
+{
+public:
+    using vector_expr_tag = void;
+    using value_type = std::decay_t<decltype(Op()(std::declval<typename E::value_type>()))>;
+
+    explicit unary_expr(const E& e) noexcept : e_(e) {}
+
+    size_t size() const noexcept { return e_.size(); }
+    value_type operator[](size_t i) const noexcept { return Op()(e_[i]); }
+
+private:
+    E e_;
+};
+
+template<typename Op, typename L, typename R>
+class binary_expr
+{
+public:
+    using vector_expr_tag = void;
+    using value_type = std::decay_t<decltype(Op()(std::declval<typename L::value_type>(),
+                                                  std::declval<typename R::value_type>()))>;
+
+    binary_expr(const L& l, const R& r) noexcept
+        : l_(l)
+        , r_(r) {
+        if constexpr (!is_scalar_expr<L>::value && !is_scalar_expr<R>::value) {
+            assert(l.size() == r.size() && "element-wise operands of different sizes");
+        }
+    }
+
+    size_t size() const noexcept {
+        if constexpr (is_scalar_expr<L>::value) {
+            return r_.size();
+        } else {
+            return l_.size();
+        }
+    }
+
+    value_type operator[](size_t i) const noexcept { return Op()(l_[i], r_[i]); }
+
+private:
+    L l_;
+    R r_;
+};
+
+template<typename C, typename T, typename F>
+class select_expr
+{
+public:
+    using vector_expr_tag = void;
+    using value_type = std::common_type_t<typename T::value_type, typename F::value_type>;
+
+    select_expr(const C& c, const T& t, const F& f) noexcept
+        : c_(c)
+        , t_(t)
+        , f_(f) {}
+
+    size_t size() const noexcept { return c_.size(); }
+    value_type operator[](size_t i) const noexcept { return c_[i] ? t_[i] : f_[i]; }
+
+private:
+    C c_;
+    T t_;
+    F f_;
+};
+
+// Maps an operand to its expression node: vectors of arithmetic types to
+// vector_ref, arithmetic values to scalar_expr, expressions to themselves.
+template<typename X, typename = void>
+struct expr_operand
+{
+    static constexpr bool is_valid = false;
+    static constexpr bool is_vector = false;
+};
+
+template<typename X>
+struct expr_operand<X, std::enable_if_t<is_vector_expr<X>::value>>
+{
+    static constexpr bool is_valid = true;
+    static constexpr bool is_vector = false;
+    using type = X;
+    static const X& make(const X& x) noexcept { return x; }
+};
+
+template<typename T, typename A, typename P>
+struct expr_operand<vector<T, A, P>, std::enable_if_t<std::is_arithmetic_v<T>>>
+{
+    static constexpr bool is_valid = true;
+    static constexpr bool is_vector = true;
+    using type = vector_ref<T>;
+    static type make(const vector<T, A, P>& v) noexcept { return type(v.data(), v.size()); }
+};
+
+template<typename X>
+struct expr_operand<X, std::enable_if_t<std::is_arithmetic_v<X>>>
+{
+    static constexpr bool is_valid = true;
+    static constexpr bool is_vector = false;
+    using type = scalar_expr<X>;
+    static type make(X x) noexcept { return type(x); }
+};
+
+template<typename X>
+using expr_operand_t = typename expr_operand<std::decay_t<X>>::type;
+
+template<typename X>
+inline constexpr bool is_expr_or_vector_v =
+    is_vector_expr<std::decay_t<X>>::value || (expr_operand<std::decay_t<X>>::is_valid && !std::is_arithmetic_v<std::decay_t<X>>);
+
+// Arithmetic operators take any operand pair with at least one vector or
+// expression; comparisons additionally need an expression or a scalar, so
+// vector == vector keeps its meaning.
+template<typename L, typename R>
+inline constexpr bool is_arith_operands_v = expr_operand<std::decay_t<L>>::is_valid && expr_operand<std::decay_t<R>>::is_valid
+                                            && (is_expr_or_vector_v<L> || is_expr_or_vector_v<R>);
+
+template<typename L, typename R>
+inline constexpr bool is_compare_operands_v = is_arith_operands_v<L, R>
+    && !(expr_operand<std::decay_t<L>>::is_vector && expr_operand<std::decay_t<R>>::is_vector);
+
+template<typename Op, typename L, typename R>
+binary_expr<Op, expr_operand_t<L>, expr_operand_t<R>> make_binary_expr(const L& l, const R& r) {
+    return {expr_operand<L>::make(l), expr_operand<R>::make(r)};
+}
+
+// Wraps a vector as an expression.
+template<typename T, typename A, typename P>
+vector_ref<T> lazy(const vector<T, A, P>& v) noexcept {
+    return vector_ref<T>(v.data(), v.size());
+}
+
+#define DL_VECTOR_EXPR_OP(op, fn, kind)                                                     \
+    template<typename L, typename R, std::enable_if_t<is_##kind##_operands_v<L, R>, int> = 0> \
+    auto operator op(const L& l, const R& r) {                                              \
+        return make_binary_expr<fn<>>(l, r);                                                \
+    }
+
+DL_VECTOR_EXPR_OP(+, std::plus, arith)
+DL_VECTOR_EXPR_OP(-, std::minus, arith)
+DL_VECTOR_EXPR_OP(*, std::multiplies, arith)
+DL_VECTOR_EXPR_OP(/, std::divides, arith)
+DL_VECTOR_EXPR_OP(%, std::modulus, arith)
+DL_VECTOR_EXPR_OP(<, std::less, compare)
+DL_VECTOR_EXPR_OP(<=, std::less_equal, compare)
+DL_VECTOR_EXPR_OP(>, std::greater, compare)
+DL_VECTOR_EXPR_OP(>=, std::greater_equal, compare)
+DL_VECTOR_EXPR_OP(==, std::equal_to, compare)
+DL_VECTOR_EXPR_OP(!=, std::not_equal_to, compare)
+DL_VECTOR_EXPR_OP(&&, std::logical_and, compare)
+DL_VECTOR_EXPR_OP(||, std::logical_or, compare)
+
+#undef DL_VECTOR_EXPR_OP
+
+template<typename E, std::enable_if_t<is_expr_or_vector_v<E>, int> = 0>
+auto operator-(const E& e) {
+    return unary_expr<std::negate<>, expr_operand_t<E>>(expr_operand<E>::make(e));
+}
+
+template<typename E, std::enable_if_t<is_expr_or_vector_v<E>, int> = 0>
+auto operator!(const E& e) {
+    return unary_expr<std::logical_not<>, expr_operand_t<E>>(expr_operand<E>::make(e));
+}
+
+// Element-wise cond ? t : f.
+template<typename C, typename T, typename F>
+auto select(const C& cond, const T& t, const F& f) {
+    return select_expr<expr_operand_t<C>, expr_operand_t<T>, expr_operand_t<F>>(
+        expr_operand<C>::make(cond), expr_operand<T>::make(t), expr_operand<F>::make(f));
+}
+
+// Reductions run over the expression in one pass. sum keeps eight partial
+// sums so floating-point sums vectorize without -ffast-math; the result may
+// differ from a sequential sum in the last bits.
+template<typename E>
+auto sum(const E& expr) {
+    auto e = expr_operand<E>::make(expr);
+    using V = typename decltype(e)::value_type;
+    using T = decltype(V() + V()); // bool sums to int
+    constexpr size_t lanes = 8;
+    T acc[lanes] = {};
+    size_t n = e.size();
+    size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+        for (size_t k = 0; k < lanes; ++k) {
+            acc[k] += e[i + k];
+        }
+    }
+    for (; i < n; ++i) {
+        acc[0] += e[i];
+    }
+    T total{};
+    for (auto a : acc) {
+        total += a;
+    }
+    return total;
+}
+
+// Number of elements that are true (non-zero).
+template<typename E>
+size_t count(const E& expr) {
+    auto e = expr_operand<E>::make(expr);
+    size_t n = e.size();
+    size_t c = 0;
+    for (size_t i = 0; i < n; ++i) {
+        c += static_cast<bool>(e[i]);
+    }
+    return c;
+}
+
+template<typename E>
+bool any(const E& expr) {
+    return count(expr) != 0;
+}
+
+template<typename E>
+bool all(const E& expr) {
+    return count(expr) == expr_operand<E>::make(expr).size();
+}
+
+} // namespace dl
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include "basic_string.h"
+#include "memory_resource.h"
+
+TEST(BasicStringTest, Basic) {
+    dl::string str;
+    // same footprint as dl::vector
+    ASSERT_EQ(sizeof(str), 3 * sizeof(size_t));
+    ASSERT_EQ(dl::string::sso_capacity, 23u);
+    ASSERT_TRUE(str.empty());
+    ASSERT_STREQ(str.c_str(), "");
+
+    dl::string small("abcdefghijklmnopqrstuvw");
+    ASSERT_EQ(small.size(), 23u);
+    ASSERT_TRUE(small.is_small());
+    ASSERT_EQ(small.capacity(), 23u);
+    ASSERT_EQ(small.c_str()[23], '\0');
+
+    small.push_back('x');
+    ASSERT_FALSE(small.is_small());
+    ASSERT_EQ(small.capacity(), 46u);
+    ASSERT_EQ(small, "abcdefghijklmnopqrstuvwx");
+    small.pop_back();
+    small.shrink_to_fit();
+    ASSERT_TRUE(small.is_small());
+    ASSERT_EQ(small, "abcdefghijklmnopqrstuvw");
+
+    dl::string copy = small;
+    ASSERT_EQ(copy, small);
+    copy[0] = 'A';
+    ASSERT_EQ(copy.front(), 'A');
+    ASSERT_EQ(small.front(), 'a');
+    ASSERT_EQ(copy.at(22), 'w');
+    ASSERT_THROW(copy.at(23), std::out_of_range);
+
+    dl::string moved = std::move(copy);
+    ASSERT_TRUE(copy.empty());
+    ASSERT_EQ(moved.back(), 'w');
+
+    dl::string long_str(100, 'z');
+    auto data = long_str.data();
+    dl::string stolen = std::move(long_str);
+    ASSERT_EQ(stolen.data(), data);
+    ASSERT_TRUE(long_str.is_small());
+    stolen.swap(moved);
+    ASSERT_EQ(moved.size(), 100u);
+    ASSERT_EQ(stolen.size(), 23u);
+}
+
+TEST(BasicStringTest, Modify) {
+    dl::string str = "hello";
+    str += ' ';
+    str += "world";
+    str.append(3, '!');
+    ASSERT_EQ(str, "hello world!!!");
+    str.insert(5, ",");
+    ASSERT_EQ(str, "hello, world!!!");
+    str.erase(12);
+    ASSERT_EQ(str, "hello, world");
+    str.erase(str.begin(), str.begin() + 7);
+    ASSERT_EQ(str, "world");
+
+    // sources inside the string itself
+    str.append(str.data(), str.size());
+    ASSERT_EQ(str, "worldworld");
+    str.append(str.data(), str.size()).append(str.data() + 5, 5);
+    ASSERT_EQ(str, "worldworldworldworldworld");
+    str.insert(0, std::string_view(str.data() + 20, 5));
+    ASSERT_EQ(str.size(), 30u);
+    ASSERT_EQ(str.substr(0, 10), "worldworld");
+    str.assign(str.data() + 5, 5);
+    ASSERT_EQ(str, "world");
+
+    str.resize(8, '.');
+    ASSERT_EQ(str, "world...");
+    str.resize(2);
+    ASSERT_EQ(str, "wo");
+    str.resize_for_overwrite(40);
+    for (size_t i = 2; i < str.size(); ++i) {
+        str[i] = 'x';
+    }
+    ASSERT_EQ(str.size(), 40u);
+    ASSERT_EQ(str.c_str()[40], '\0');
+    str.resize_and_overwrite(64, [](char* p, size_t n) {
+        p[40] = 'y';
+        return n - 23;
+    });
+    ASSERT_EQ(str.size(), 41u);
+    ASSERT_EQ(str.back(), 'y');
+
+    ASSERT_EQ(dl::string("ab") + dl::string("cd") + "ef" + 'g', "abcdefg");
+    ASSERT_EQ("x" + dl::string("y"), "xy");
+    str.clear();
+    ASSERT_TRUE(str.empty());
+    ASSERT_GE(str.capacity(), 64u);
+}
+
+TEST(BasicStringTest, FindCompare) {
+    std::mt19937 gen(1);
+    for (int iter = 0; iter < 300; ++iter) {
+        std::string ref;
+        auto n = gen() % 200;
+        for (size_t i = 0; i < n; ++i) {
+            ref.push_back(static_cast<char>('a' + gen() % 3));
+        }
+        dl::string str(ref.data(), ref.size());
+        auto k = gen() % 6;
+        std::string needle;
+        for (size_t i = 0; i < k; ++i) {
+            needle.push_back(static_cast<char>('a' + gen() % 3));
+        }
+        for (size_t pos : {size_t(0), size_t(1), size_t(17), size_t(n)}) {
+            ASSERT_EQ(str.find(needle, pos), ref.find(needle, pos));
+            ASSERT_EQ(str.find('c', pos), ref.find('c', pos));
+        }
+        ASSERT_EQ(str.rfind(needle), ref.rfind(needle));
+
+        auto other = ref;
+        if (!other.empty()) {
+            other[gen() % other.size()] = static_cast<char>(gen());
+        }
+        auto sign = [](int x) { return (x > 0) - (x < 0); };
+        ASSERT_EQ(sign(str.compare(other)), sign(ref.compare(other)));
+        ASSERT_EQ(str == dl::string(other.data(), other.size()), ref == other);
+    }
+    dl::string high("\xff");
+    ASSERT_GT(high, dl::string("a"));
+    ASSERT_LT(dl::string("abc"), dl::string("abd"));
+    ASSERT_LT(dl::string("ab"), dl::string("abc"));
+    ASSERT_TRUE(dl::string("prefix.suffix").starts_with("prefix"));
+    ASSERT_TRUE(dl::string("prefix.suffix").ends_with(".suffix"));
+    ASSERT_FALSE(dl::string("fix").ends_with(".suffix"));
+    ASSERT_TRUE(dl::string("needle in a haystack").contains("hay"));
+
+    std::unordered_set<dl::string> set{"a", "b"};
+    ASSERT_EQ(set.count("a"), 1u);
+    ASSERT_EQ(std::hash<dl::string>()("abc"), std::hash<std::string_view>()("abc"));
+}
+
+TEST(BasicStringTest, Vector) {
+    dl::vector<char> vec;
+    vec.reserve(64);
+    for (char c : std::string_view("no copies here")) {
+        vec.push_back(c);
+    }
+    auto data = vec.data();
+    dl::string str(std::move(vec));
+    ASSERT_TRUE(vec.empty());
+    ASSERT_EQ(vec.capacity(), 0u);
+    ASSERT_EQ(str.data(), data);
+    ASSERT_EQ(str, "no copies here");
+    ASSERT_EQ(str.capacity(), 63u);
+
+    str.append(" either");
+    auto back = std::move(str).to_vector();
+    ASSERT_EQ(back.data(), data);
+    ASSERT_EQ(back.capacity(), 64u);
+    ASSERT_EQ(std::string_view(back.data(), back.size()), "no copies here either");
+    ASSERT_TRUE(str.empty());
+
+    // a full vector grows once for the terminator
+    dl::vector<char> full{'a', 'b'};
+    dl::string from_full(std::move(full));
+    ASSERT_EQ(from_full, "ab");
+    auto small = dl::string("tiny").to_vector();
+    ASSERT_EQ(small.size(), 4u);
+}
+
+TEST(BasicStringTest, Allocator) {
+    dl::pmr::counting_resource resource;
+    using pmr_string = dl::basic_string<char, std::char_traits<char>, dl::pmr::polymorphic_allocator<char>>;
+    {
+        pmr_string a("short", &resource);
+        ASSERT_EQ(resource.allocations(), 0u);
+        pmr_string b(std::string_view("a string too long for the inline buffer"), &resource);
+        ASSERT_EQ(resource.allocations(), 1u);
+        b += b;
+        ASSERT_EQ(resource.allocations(), 2u);
+        ASSERT_EQ(b.get_allocator().resource(), &resource);
+        auto vec = std::move(b).to_vector();
+        ASSERT_EQ(vec.get_allocator().resource(), &resource);
+    }
+    ASSERT_EQ(resource.bytes_in_use(), 0u);
+
+    dl::basic_string<char16_t> wide(u"wide characters");
+    ASSERT_EQ(dl::basic_string<char16_t>::sso_capacity, 11u);
+    ASSERT_FALSE(wide.is_small());
+    ASSERT_EQ(wide.find(u"char"), 5u);
+    ASSERT_EQ(wide.find(u'z'), dl::basic_string<char16_t>::npos);
+}
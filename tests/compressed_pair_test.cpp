@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include "compressed_pair.h"
+#include "memory.h"
+#include "shrink_policy.h"
+#include "split_buffer.h"
+#include "vector.h"
+
+namespace {
+
+struct empty_a {};
+struct empty_b {};
+
+struct final_empty final {};
+
+struct tagged
+{
+    constexpr tagged() = default;
+    constexpr explicit tagged(int v) : value(v) {}
+    int value = 0;
+};
+
+constexpr int constexpr_sum() {
+    dl::compressed_tuple<int, empty_a, tagged, long> t(1, empty_a(), tagged(2), 3L);
+    dl::get<0>(t) += 10;
+    return dl::get<0>(t) + dl::get<2>(t).value + static_cast<int>(t.get<3>());
+}
+
+} // namespace
+
+TEST(CompressedTupleTest, Layout) {
+    static_assert(sizeof(dl::compressed_tuple<int*, empty_a, empty_b>) == sizeof(int*));
+    static_assert(sizeof(dl::compressed_tuple<empty_a, int*, empty_b>) == sizeof(int*));
+    static_assert(sizeof(dl::compressed_tuple<int*, final_empty>) == 2 * sizeof(int*));
+    static_assert(sizeof(dl::compressed_tuple<int*, std::allocator<int>&>) == 2 * sizeof(int*));
+
+    // the containers built on it
+    static_assert(sizeof(dl::vector<int>) == 3 * sizeof(int*));
+    static_assert(sizeof(dl::vector<int, std::allocator<int>, dl::fraction_shrink<>>) == 3 * sizeof(int*));
+    static_assert(sizeof(dl::split_buffer<int, std::allocator<int>>) == 3 * sizeof(int*));
+    static_assert(sizeof(dl::unique_ptr<int>) == sizeof(int*));
+}
+
+TEST(CompressedTupleTest, Access) {
+    dl::compressed_tuple<std::string, int, int, empty_a, empty_a> t("abc", 1, 2, empty_a(), empty_a());
+    ASSERT_EQ(dl::get<0>(t), "abc");
+    ASSERT_EQ(dl::get<1>(t), 1);
+    ASSERT_EQ(dl::get<2>(t), 2);
+    dl::get<2>(t) = 5;
+    ASSERT_EQ(t.get<1>(), 1);
+    ASSERT_EQ(t.get<2>(), 5);
+    ASSERT_NE(static_cast<void*>(&dl::get<3>(t)), static_cast<void*>(&dl::get<4>(t)));
+
+    auto copy = t;
+    dl::get<0>(copy) += "d";
+    ASSERT_EQ(dl::get<0>(copy), "abcd");
+    ASSERT_EQ(dl::get<0>(t), "abc");
+
+    // members are value-initialized by default
+    dl::compressed_tuple<int*, int, empty_b> zero;
+    ASSERT_EQ(dl::get<0>(zero), nullptr);
+    ASSERT_EQ(dl::get<1>(zero), 0);
+
+    int x = 7;
+    dl::compressed_tuple<int&, empty_a> ref(x, empty_a());
+    dl::get<0>(ref) = 8;
+    ASSERT_EQ(x, 8);
+
+    dl::compressed_tuple<std::unique_ptr<int>> single(std::make_unique<int>(3));
+    auto moved = std::move(single);
+    ASSERT_EQ(*dl::get<0>(moved), 3);
+    ASSERT_EQ(dl::get<0>(single), nullptr);
+}
+
+TEST(CompressedTupleTest, Constexpr) {
+    static_assert(constexpr_sum() == 16);
+    constexpr dl::compressed_tuple<int, empty_a> t(4, empty_a());
+    static_assert(dl::get<0>(t) == 4);
+}
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "cow_vector.h"
+#include "memory_resource.h"
+#include "test_type.h"
+
+using trace_int = trace_type<int>;
+
+TEST(CowVectorTest, copy_on_write) {
+    dl::cow_vector<int> empty;
+    ASSERT_TRUE(empty.empty());
+    ASSERT_EQ(empty.use_count(), 0u);
+    ASSERT_EQ(empty.begin(), empty.end());
+
+    dl::cow_vector<int> a{1, 2, 3};
+    auto b = a;
+    ASSERT_TRUE(a.shares_with(b));
+    ASSERT_EQ(a.use_count(), 2u);
+    ASSERT_EQ(a.data(), b.data());
+
+    b.push_back(4);
+    ASSERT_FALSE(a.shares_with(b));
+    ASSERT_EQ(a.use_count(), 1u);
+    ASSERT_EQ(a, (dl::cow_vector<int>{1, 2, 3}));
+    ASSERT_EQ(b, (dl::cow_vector<int>{1, 2, 3, 4}));
+
+    // a unique buffer is modified in place
+    auto data = b.data();
+    b.set(0, 7);
+    ASSERT_EQ(b.data(), data);
+    ASSERT_EQ(b[0], 7);
+    ASSERT_THROW(b.at(4), std::out_of_range);
+
+    auto c = b;
+    c.clear();
+    ASSERT_TRUE(c.empty());
+    ASSERT_EQ(b.size(), 4u);
+    c.emplace_back(5);
+    ASSERT_EQ(c.front(), 5);
+
+    empty.edit().assign({9, 9});
+    ASSERT_EQ(empty.size(), 2u);
+}
+
+TEST(CowVectorTest, copies) {
+    trace_int::init();
+    {
+        dl::vector<trace_int> vec;
+        vec.reserve(4);
+        for (int i = 0; i < 4; ++i) {
+            vec.emplace_back(i);
+        }
+        dl::cow_vector<trace_int> a(std::move(vec));
+        dl::cow_vector<trace_int> b = a;
+        dl::cow_vector<trace_int> c = b;
+        ASSERT_EQ(trace_int::copy_lval_construct, 0u);
+
+        c.pop_back();
+        ASSERT_EQ(trace_int::copy_lval_construct, 4u);
+        ASSERT_EQ(c.size(), 3u);
+        ASSERT_EQ(a.use_count(), 2u);
+        b.edit();
+        ASSERT_EQ(trace_int::copy_lval_construct, 8u);
+        a.edit();
+        ASSERT_EQ(trace_int::copy_lval_construct, 8u);
+    }
+    ASSERT_EQ(trace_int::destruct, trace_int::basic_construct + trace_int::copy_lval_construct);
+}
+
+TEST(CowVectorTest, allocator) {
+    dl::pmr::counting_resource resource;
+    {
+        dl::cow_vector<int, dl::pmr::polymorphic_allocator<int>> a(dl::pmr::vector<int>({1, 2}, &resource));
+        ASSERT_EQ(resource.allocations(), 2u);
+        auto b = a;
+        b.push_back(3); // detached copy, its rep, then growth
+        ASSERT_EQ(b.get().get_allocator().resource(), &resource);
+        ASSERT_EQ(resource.allocations(), 5u);
+    }
+    ASSERT_EQ(resource.bytes_in_use(), 0u);
+}
+
+TEST(CowVectorTest, publish_acquire) {
+    dl::atomic_cow_vector<int> slot;
+    ASSERT_TRUE(slot.acquire().empty());
+
+    dl::cow_vector<int> v{1, 2, 3};
+    slot.publish(v);
+    auto snap = slot.acquire();
+    ASSERT_TRUE(snap.shares_with(v));
+    ASSERT_EQ(v.use_count(), 3u);
+
+    // the published version stays intact while the writer edits its copy
+    v.push_back(4);
+    ASSERT_EQ(slot.acquire().size(), 3u);
+    auto version = slot.version();
+    slot.publish(v);
+    ASSERT_NE(slot.version(), version);
+    ASSERT_EQ(slot.acquire().size(), 4u);
+    ASSERT_EQ(snap.size(), 3u);
+    ASSERT_EQ(snap.use_count(), 1u);
+
+    dl::cow_reader<int> reader(slot);
+    ASSERT_TRUE(reader.get().shares_with(v));
+    auto held = reader.get();
+    ASSERT_EQ(held.use_count(), 4u);
+}
+
+TEST(CowVectorTest, concurrent) {
+    constexpr int versions = 2000;
+    dl::atomic_cow_vector<int> slot(dl::cow_vector<int>{0, 0, 0, 0});
+    std::atomic<bool> done{false};
+    dl::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t] {
+            dl::cow_reader<int> reader(slot);
+            int last = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                auto snap = (t % 2 == 0) ? slot.acquire() : reader.get();
+                // every published vector holds one value repeated
+                auto first = snap[0];
+                for (auto x : snap) {
+                    ASSERT_EQ(x, first);
+                }
+                ASSERT_GE(first, last);
+                last = first;
+            }
+        });
+    }
+    dl::cow_vector<int> v = slot.acquire();
+    for (int i = 1; i <= versions; ++i) {
+        for (size_t j = 0; j < v.size(); ++j) {
+            v.set(j, i);
+        }
+        slot.publish(v);
+    }
+    done = true;
+    for (auto& r : readers) {
+        r.join();
+    }
+    ASSERT_EQ(slot.acquire()[3], versions);
+}
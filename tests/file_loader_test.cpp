@@ -0,0 +1,168 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "file_loader.h"
+#include "thread_pool.h"
+#include "vector.h"
+
+class FileLoaderTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {
+        path = ::testing::TempDir() + "file_loader_test." + std::to_string(::getpid());
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    dl::vector<char> make_file(size_t n) {
+        dl::vector<char> content;
+        for (size_t i = 0; i < n; ++i) {
+            content.push_back(static_cast<char>('a' + i % 26));
+        }
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        if (!content.empty()) {
+            std::fwrite(content.data(), 1, content.size(), f);
+        }
+        std::fclose(f);
+        return content;
+    }
+
+    std::string path;
+};
+
+TEST_F(FileLoaderTest, Load) {
+    {
+        auto content = make_file(0);
+        auto res = dl::load_file(path);
+        ASSERT_TRUE(res.empty());
+    }
+    {
+        auto content = make_file(1000);
+        auto res = dl::load_file(path);
+        ASSERT_EQ(res, content);
+        ASSERT_EQ(res.capacity(), content.size());
+    }
+    {
+        auto content = make_file(100003);
+        dl::thread_pool pool(4);
+        dl::load_options opts;
+        opts.chunk_bytes = 4096;
+        opts.advice = dl::file_advice::willneed;
+        dl::vector<char> res{'x'};
+        dl::load_file(path, res, dl::par.on(pool).with_threshold(0), opts);
+        ASSERT_EQ(res, content);
+    }
+    {
+        make_file(4 * 10);
+        auto res = dl::load_file<uint32_t>(path);
+        ASSERT_EQ(res.size(), 10u);
+        make_file(4 * 10 + 1);
+        ASSERT_THROW(dl::load_file<uint32_t>(path), std::runtime_error);
+    }
+    ASSERT_THROW(dl::load_file(path + ".missing"), std::system_error);
+}
+
+namespace {
+
+// Writes the pieces into a pipe with a pause before each one after the first,
+// so that the reader sees them as separate short reads.
+class pipe_writer
+{
+public:
+    explicit pipe_writer(std::vector<std::string> pieces) {
+        if (::pipe(fds_) != 0) {
+            throw std::runtime_error("pipe");
+        }
+        thread_ = std::thread([this, pieces = std::move(pieces)] {
+            for (size_t i = 0; i < pieces.size(); ++i) {
+                if (i != 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                }
+                for (size_t done = 0; done < pieces[i].size();) {
+                    auto n = ::write(fds_[1], pieces[i].data() + done, pieces[i].size() - done);
+                    if (n <= 0) {
+                        break;
+                    }
+                    done += static_cast<size_t>(n);
+                }
+            }
+            ::close(fds_[1]);
+        });
+    }
+
+    ~pipe_writer() {
+        thread_.join();
+        ::close(fds_[0]);
+    }
+
+    std::string path() const { return "/dev/fd/" + std::to_string(fds_[0]); }
+
+private:
+    int fds_[2];
+    std::thread thread_;
+};
+
+} // namespace
+
+TEST_F(FileLoaderTest, Pipe) {
+    {
+        // one element split over two reads
+        uint32_t values[2] = {0x01020304, 0x05060708};
+        std::string bytes(reinterpret_cast<const char*>(values), sizeof(values));
+        pipe_writer writer({bytes.substr(0, 2), bytes.substr(2)});
+        auto res = dl::load_file<uint32_t>(writer.path());
+        ASSERT_EQ(res.size(), 2u);
+        ASSERT_EQ(res[0], values[0]);
+        ASSERT_EQ(res[1], values[1]);
+    }
+    {
+        // many short reads grow the buffer geometrically, not once per read
+        std::vector<std::string> pieces;
+        dl::vector<char> content;
+        for (size_t i = 0; i < 40; ++i) {
+            std::string piece(1000 + i * 997, static_cast<char>('a' + i % 26));
+            content.insert(content.end(), piece.begin(), piece.end());
+            pieces.push_back(std::move(piece));
+        }
+        pipe_writer writer(std::move(pieces));
+        dl::load_options opts;
+        opts.chunk_bytes = 4096;
+        auto res = dl::load_file<char>(writer.path(), dl::par, opts);
+        ASSERT_EQ(res, content);
+        ASSERT_LT(res.capacity(), 2 * content.size());
+    }
+    {
+        // a partial element at the end throws and keeps the whole ones
+        uint32_t value = 42;
+        std::string bytes(reinterpret_cast<const char*>(&value), sizeof(value));
+        pipe_writer writer({bytes, "abc"});
+        dl::vector<uint32_t> res{1, 2, 3, 4, 5};
+        ASSERT_THROW(dl::load_file(writer.path(), res), std::runtime_error);
+        ASSERT_EQ(res.size(), 1u);
+        ASSERT_EQ(res[0], 42u);
+    }
+}
+
+TEST_F(FileLoaderTest, Chunked) {
+    auto content = make_file(10000);
+    dl::chunked_file_reader reader(path, 3000);
+    dl::vector<char> chunk;
+    dl::vector<char> res;
+    size_t chunks = 0;
+    while (reader.next(chunk)) {
+        ASSERT_LE(chunk.size(), 3000u);
+        res.insert(res.end(), chunk.begin(), chunk.end());
+        ++chunks;
+    }
+    ASSERT_EQ(chunks, 4u);
+    ASSERT_EQ(res, content);
+    ASSERT_EQ(reader.offset(), 10000);
+}
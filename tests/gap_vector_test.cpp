@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <type_traits>
+#include "gap_vector.h"
+#include "test_type.h"
+#include "vector.h"
+
+int value_of(int v) { return v; }
+int value_of(const trace_type<int>& v) { return v.value; }
+
+template<typename G>
+dl::vector<int> values(const G& g) {
+    dl::vector<int> res;
+    for (const auto& v : g) {
+        res.push_back(value_of(v));
+    }
+    return res;
+}
+
+TEST(GapVectorTest, Basic) {
+    dl::gap_vector<int> vec{1, 2, 3, 4, 5};
+    ASSERT_EQ(sizeof(vec), 4 * sizeof(void*));
+    ASSERT_EQ(vec.size(), 5u);
+    vec.insert(vec.begin() + 2, 10);
+    ASSERT_EQ(vec.gap_position(), 3u);
+    ASSERT_EQ(values(vec), (dl::vector<int>{1, 2, 10, 3, 4, 5}));
+    vec.insert(vec.begin() + 3, 11);
+    vec.erase(vec.begin() + 4);
+    ASSERT_EQ(values(vec), (dl::vector<int>{1, 2, 10, 11, 4, 5}));
+    ASSERT_EQ(vec[3], 11);
+    ASSERT_EQ(vec[4], 4);
+    ASSERT_EQ(vec.at(5), 5);
+    ASSERT_THROW(vec.at(6), std::out_of_range);
+    ASSERT_EQ(vec.front(), 1);
+    ASSERT_EQ(vec.back(), 5);
+
+    vec.move_gap(0);
+    ASSERT_EQ(*vec.begin(), 1);
+    vec.push_back(6);
+    vec.pop_back();
+    vec.pop_back();
+    ASSERT_EQ(values(vec), (dl::vector<int>{1, 2, 10, 11, 4}));
+
+    auto p = vec.contiguous();
+    ASSERT_TRUE(std::equal(p, p + vec.size(), vec.begin()));
+    ASSERT_EQ(vec.gap_position(), vec.size());
+
+    vec.erase(vec.begin() + 1, vec.begin() + 4);
+    ASSERT_EQ(values(vec), (dl::vector<int>{1, 4}));
+    vec.insert(vec.begin() + 1, 3, 7);
+    ASSERT_EQ(values(vec), (dl::vector<int>{1, 7, 7, 7, 4}));
+    vec.insert(vec.end(), {8, 9});
+    ASSERT_EQ(values(vec), (dl::vector<int>{1, 7, 7, 7, 4, 8, 9}));
+    vec.resize(3);
+    vec.resize(4, 2);
+    ASSERT_EQ(values(vec), (dl::vector<int>{1, 7, 7, 2}));
+    vec.clear();
+    ASSERT_TRUE(vec.empty());
+    ASSERT_EQ(vec.begin(), vec.end());
+}
+
+TEST(GapVectorTest, Iterator) {
+    dl::gap_vector<int> vec;
+    for (int i = 0; i < 100; ++i) {
+        vec.push_back(99 - i);
+    }
+    vec.reserve(200);
+    vec.move_gap(40);
+    auto first = vec.begin();
+    auto last = vec.end();
+    ASSERT_EQ(last - first, 100);
+    ASSERT_EQ(first + 40 - first, 40);
+    ASSERT_EQ(*(first + 40), 59);
+    ASSERT_EQ(*(last - 60), 59);
+    ASSERT_EQ(*(first + 39), 60);
+    ASSERT_EQ(first[41], 58);
+    ASSERT_EQ((first + 45) - (first + 35), 10);
+    ASSERT_EQ((first + 35) - (first + 45), -10);
+    ASSERT_TRUE(first + 39 < first + 40);
+    auto it = first + 39;
+    ++it;
+    ASSERT_EQ(*it, 59);
+    --it;
+    ASSERT_EQ(*it, 60);
+
+    std::sort(vec.begin(), vec.end());
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(vec[i], i);
+    }
+    ASSERT_EQ(*std::lower_bound(vec.begin(), vec.end(), 70), 70);
+    ASSERT_EQ(std::distance(vec.rbegin(), vec.rend()), 100);
+    ASSERT_EQ(*vec.rbegin(), 99);
+
+    const auto& cvec = vec;
+    dl::gap_vector<int>::const_iterator cit = vec.begin();
+    ASSERT_EQ(cit, cvec.begin());
+
+    std::istringstream in("1 2 3");
+    vec.insert(vec.begin() + 50, std::istream_iterator<int>(in), std::istream_iterator<int>());
+    ASSERT_EQ(vec[50], 1);
+    ASSERT_EQ(vec[52], 3);
+    ASSERT_EQ(vec[53], 50);
+}
+
+TEST(GapVectorTest, CursorEdits) {
+    using trace_int = trace_type<int>;
+    dl::gap_vector<trace_int> vec;
+    vec.reserve(16);
+    for (int i = 0; i < 8; ++i) {
+        vec.emplace_back(i);
+    }
+    vec.move_gap(4);
+    trace_int::init();
+    // typing and deleting at the cursor touches no other element
+    vec.emplace(vec.begin() + 4, 100);
+    vec.emplace(vec.begin() + 5, 101);
+    vec.erase(vec.begin() + 6);
+    vec.erase(vec.begin() + 5);
+    ASSERT_EQ(trace_int::basic_construct, 2u);
+    ASSERT_EQ(trace_int::move_rval_construct, 0u);
+    ASSERT_EQ(trace_int::destruct, 2u);
+
+    // moving the cursor moves only the elements it passes
+    trace_int::init();
+    vec.move_gap(2);
+    ASSERT_EQ(trace_int::move_rval_construct, 3u);
+    ASSERT_EQ(values(vec), (dl::vector<int>{0, 1, 2, 3, 100, 5, 6, 7}));
+
+    // inserting an element of the container itself
+    vec.insert(vec.begin() + 6, vec[4]);
+    vec.insert(vec.begin(), vec.back());
+    ASSERT_EQ(values(vec), (dl::vector<int>{7, 0, 1, 2, 3, 100, 5, 100, 6, 7}));
+
+    // growth keeps the gap where it is
+    vec.insert(vec.begin() + 3, 20, trace_int(5));
+    ASSERT_EQ(vec.size(), 30u);
+    ASSERT_EQ(vec.gap_position(), 23u);
+    ASSERT_EQ(vec[2].value, 1);
+    ASSERT_EQ(vec[23].value, 2);
+
+    dl::gap_vector<trace_int> copy(vec);
+    ASSERT_EQ(copy, vec);
+    dl::gap_vector<trace_int> moved(std::move(copy));
+    ASSERT_EQ(moved, vec);
+    ASSERT_TRUE(copy.empty());
+    copy = moved;
+    ASSERT_EQ(copy, vec);
+    moved.clear();
+    moved = std::move(copy);
+    ASSERT_EQ(moved, vec);
+    moved.shrink_to_fit();
+    ASSERT_EQ(moved.capacity(), moved.size());
+}
+
+template<typename T>
+struct tagged_allocator : std::allocator<T>
+{
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::false_type;
+
+    template<typename U>
+    struct rebind { using other = tagged_allocator<U>; };
+
+    explicit tagged_allocator(int id = 0) noexcept : id(id) {}
+    template<typename U>
+    tagged_allocator(const tagged_allocator<U>& other) noexcept : id(other.id) {}
+
+    bool operator==(const tagged_allocator& other) const noexcept { return id == other.id; }
+    bool operator!=(const tagged_allocator& other) const noexcept { return id != other.id; }
+
+    int id;
+};
+
+TEST(GapVectorTest, AllocatorPropagation) {
+    using tagged = dl::gap_vector<int, tagged_allocator<int>>;
+    static_assert(std::is_nothrow_move_assignable_v<tagged>);
+    tagged src({1, 2, 3}, tagged_allocator<int>(1));
+    tagged copy(tagged_allocator<int>(2));
+    copy.insert(copy.end(), 9);
+    copy = src;
+    ASSERT_EQ(copy.get_allocator().id, 1);
+    ASSERT_EQ(values(copy), (dl::vector<int>{1, 2, 3}));
+
+    tagged moved(tagged_allocator<int>(3));
+    moved.insert(moved.end(), 9);
+    auto data = &*src.begin();
+    moved = std::move(src);
+    ASSERT_EQ(moved.get_allocator().id, 1);
+    ASSERT_EQ(&*moved.begin(), data);
+    ASSERT_EQ(values(moved), (dl::vector<int>{1, 2, 3}));
+}
+
+TEST(GapVectorTest, RandomEdits) {
+    std::mt19937 gen(3);
+    dl::gap_vector<int> gap;
+    dl::vector<int> ref;
+    size_t cursor = 0;
+    for (int i = 0; i < 20000; ++i) {
+        cursor = std::min<size_t>(ref.size(), cursor + gen() % 7 - std::min<size_t>(cursor, 3));
+        if (gen() % 3 != 0 || ref.empty() || cursor == ref.size()) {
+            gap.insert(gap.begin() + cursor, i);
+            ref.insert(ref.begin() + cursor, i);
+        } else {
+            auto pos = (cursor != 0 && gen() % 2 == 0) ? cursor - 1 : cursor; // backspace or delete
+            gap.erase(gap.begin() + pos);
+            ref.erase(ref.begin() + pos);
+            cursor = pos;
+        }
+    }
+    ASSERT_EQ(values(gap), ref);
+}
@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <cstring>
+#include <dlfcn.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "vector.h"
+
+// Built as its own test binary with DL_GROWTH_PROFILE defined.
+
+namespace {
+
+using entry = dl::growth_profile::entry;
+
+const entry* find_line(const std::vector<entry>& entries, unsigned line) {
+    for (auto& e : entries) {
+        if (e.site.file && std::strstr(e.site.file, "growth_profile_test.cpp") && e.site.line == line) {
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+// Exported (the test links with ENABLE_EXPORTS) so dladdr can name it.
+[[gnu::noinline]] size_t growth_profile_emplace_site(dl::vector<std::string>& strings, int n) {
+    for (int i = 0; i < n; ++i) {
+        strings.emplace_back(3, 'x');
+    }
+    return strings.size();
+}
+
+TEST(GrowthProfileTest, CountsPerCallSite) {
+    auto& profile = dl::growth_profile::instance();
+    profile.reset();
+
+    unsigned push_line = 0;
+    dl::vector<int> grown;
+    for (int i = 0; i < 1000; ++i) {
+        grown.push_back(i); push_line = __LINE__;
+    }
+
+    unsigned reserved_line = 0;
+    dl::vector<int> reserved;
+    reserved.reserve(1000);
+    for (int i = 0; i < 1000; ++i) {
+        reserved.push_back(i); reserved_line = __LINE__;
+    }
+
+    dl::vector<int> resized;
+    resized.resize(10); unsigned resize_line = __LINE__;
+    resized.insert(resized.end(), grown.begin(), grown.end()); unsigned insert_line = __LINE__;
+
+    auto entries = profile.entries();
+    auto push = find_line(entries, push_line);
+    ASSERT_NE(push, nullptr);
+    ASSERT_EQ(push->reallocations, 11u);                      // capacity 1, 2, 4, ..., 1024
+    ASSERT_EQ(push->bytes_moved, (1u + 2 + 4 + 8 + 16 + 32 + 64 + 128 + 256 + 512) * sizeof(int));
+    ASSERT_EQ(push->capacity_bytes, 1024 * sizeof(int));
+
+    ASSERT_EQ(find_line(entries, reserved_line), nullptr);
+
+    auto resize = find_line(entries, resize_line);
+    ASSERT_NE(resize, nullptr);
+    ASSERT_EQ(resize->reallocations, 1u);
+    ASSERT_EQ(resize->bytes_moved, 0u);
+    auto insert = find_line(entries, insert_line);
+    ASSERT_NE(insert, nullptr);
+    ASSERT_EQ(insert->bytes_moved, 10 * sizeof(int));
+    ASSERT_EQ(insert->capacity_bytes, 1010 * sizeof(int));
+
+    // the three sites above and nothing for the calls they make internally
+    ASSERT_EQ(entries.size(), 3u);
+    ASSERT_EQ(entries.front().site.line, push_line); // most bytes moved first
+}
+
+TEST(GrowthProfileTest, EmplaceUsesReturnAddress) {
+    auto& profile = dl::growth_profile::instance();
+    profile.reset();
+
+    dl::vector<std::string> strings;
+    ASSERT_EQ(growth_profile_emplace_site(strings, 100), 100u);
+    auto entries = profile.entries();
+    ASSERT_EQ(entries.size(), 1u);
+    ASSERT_EQ(entries[0].site.file, nullptr);
+    ASSERT_EQ(entries[0].reallocations, 8u); // up to capacity 128
+
+    // the address is inside the function that called emplace_back
+    Dl_info info{};
+    ASSERT_NE(::dladdr(entries[0].site.caller, &info), 0);
+    ASSERT_EQ(info.dli_saddr, reinterpret_cast<void*>(&growth_profile_emplace_site));
+
+    auto out = std::tmpfile();
+    ASSERT_NE(out, nullptr);
+    profile.dump(out);
+    std::rewind(out);
+    char buf[4096] = {};
+    auto n = std::fread(buf, 1, sizeof(buf) - 1, out);
+    std::fclose(out);
+    ASSERT_GT(n, 0u);
+    ASSERT_NE(std::strstr(buf, "dl growth profile: 1 sites"), nullptr);
+    ASSERT_NE(std::strstr(buf, "(emplace)"), nullptr);
+}
@@ -0,0 +1,113 @@
+#include <cstdint>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+#include "mapped_vector.h"
+
+struct point
+{
+    int32_t x;
+    int32_t y;
+};
+
+class MappedVectorTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {
+        path = ::testing::TempDir() + "mapped_vector_test." + std::to_string(::getpid());
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    std::string path;
+};
+
+TEST_F(MappedVectorTest, Basic) {
+    {
+        dl::mapped_vector<point> vec(path, dl::mapped_mode::create);
+        ASSERT_TRUE(vec.is_open());
+        ASSERT_TRUE(vec.empty());
+        for (int i = 0; i < 1000; ++i) {
+            vec.push_back({i, -i});
+        }
+        ASSERT_EQ(vec.size(), 1000u);
+        ASSERT_EQ(vec.capacity(), 1024u);
+        ASSERT_EQ(vec.back().x, 999);
+        vec.pop_back();
+        vec.sync();
+    }
+    {
+        dl::mapped_vector<point> vec(path, dl::mapped_mode::open);
+        ASSERT_EQ(vec.size(), 999u);
+        int i = 0;
+        for (const auto& p : vec) {
+            ASSERT_EQ(p.x, i);
+            ASSERT_EQ(p.y, -i);
+            ++i;
+        }
+        vec.resize(2000, point{7, 7});
+        ASSERT_EQ(vec[1999].y, 7);
+        vec.resize(10);
+        vec.shrink_to_fit();
+        ASSERT_EQ(vec.capacity(), 10u);
+        ASSERT_THROW(vec.at(10), std::out_of_range);
+    }
+    {
+        dl::mapped_vector<point> vec(path);
+        ASSERT_EQ(vec.size(), 10u);
+        ASSERT_EQ(vec[9].x, 9);
+        vec.clear();
+        vec.reserve(100);
+        ASSERT_EQ(vec.capacity(), 100u);
+    }
+}
+
+TEST_F(MappedVectorTest, Reject) {
+    {
+        dl::mapped_vector<uint64_t> vec(path, dl::mapped_mode::create);
+        vec.push_back(1);
+    }
+    ASSERT_THROW(dl::mapped_vector<uint32_t>(path, dl::mapped_mode::open), std::runtime_error);
+    ASSERT_THROW(dl::mapped_vector<uint64_t>(path + ".missing", dl::mapped_mode::open), std::system_error);
+
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    std::fputs("not a vector, just some text that is long enough to hold a header "
+               "not a vector, just some text that is long enough to hold a header", f);
+    std::fclose(f);
+    ASSERT_THROW(dl::mapped_vector<uint64_t>(path, dl::mapped_mode::open), std::runtime_error);
+
+    // open does not turn an empty file into a vector
+    std::fclose(std::fopen(path.c_str(), "wb"));
+    ASSERT_THROW(dl::mapped_vector<uint64_t>(path, dl::mapped_mode::open), std::runtime_error);
+    std::FILE* empty = std::fopen(path.c_str(), "rb");
+    ASSERT_EQ(std::fgetc(empty), EOF);
+    std::fclose(empty);
+    dl::mapped_vector<uint64_t>(path, dl::mapped_mode::open_or_create).push_back(1);
+
+    // a capacity whose byte size wraps around
+    {
+        dl::mapped_vector<uint64_t>::header hdr;
+        f = std::fopen(path.c_str(), "r+b");
+        ASSERT_EQ(std::fread(&hdr, sizeof(hdr), 1, f), 1u);
+        hdr.capacity = uint64_t(1) << 61;
+        std::rewind(f);
+        std::fwrite(&hdr, sizeof(hdr), 1, f);
+        std::fclose(f);
+    }
+    ASSERT_THROW(dl::mapped_vector<uint64_t>(path, dl::mapped_mode::open), std::runtime_error);
+}
+
+TEST_F(MappedVectorTest, Move) {
+    dl::mapped_vector<int> a(path, dl::mapped_mode::create);
+    a.push_back(1);
+    a.push_back(a.front());
+    dl::mapped_vector<int> b(std::move(a));
+    ASSERT_FALSE(a.is_open());
+    ASSERT_EQ(b.size(), 2u);
+    ASSERT_EQ(b[1], 1);
+    a = std::move(b);
+    ASSERT_EQ(a.size(), 2u);
+}
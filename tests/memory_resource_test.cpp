@@ -0,0 +1,144 @@
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <thread>
+#include "memory_resource.h"
+
+TEST(MemoryResourceTest, monotonic) {
+    dl::pmr::counting_resource upstream;
+    {
+        alignas(16) char buffer[256];
+        dl::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), &upstream);
+        auto p = arena.allocate(100, 8);
+        ASSERT_EQ(static_cast<char*>(p), buffer);
+        auto q = arena.allocate(10, 64);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(q) % 64, 0u);
+        ASSERT_EQ(upstream.allocations(), 0u);
+        arena.allocate(1000);
+        ASSERT_EQ(upstream.allocations(), 1u);
+        arena.deallocate(p, 100, 8);
+        arena.release();
+        ASSERT_EQ(upstream.bytes_in_use(), 0u);
+        ASSERT_EQ(arena.allocate(8), static_cast<void*>(buffer));
+        arena.allocate(1 << 20);
+    }
+    ASSERT_EQ(upstream.allocations(), 2u);
+    ASSERT_EQ(upstream.deallocations(), 2u);
+    ASSERT_EQ(upstream.bytes_in_use(), 0u);
+}
+
+TEST(MemoryResourceTest, pool) {
+    dl::pmr::counting_resource upstream;
+    {
+        dl::pmr::unsynchronized_pool_resource pool(dl::pmr::pool_options{4, 1024}, &upstream);
+        ASSERT_EQ(pool.options().largest_required_pool_block, 1024u);
+        auto a = pool.allocate(24);
+        auto b = pool.allocate(32);
+        ASSERT_NE(a, b);
+        ASSERT_EQ(upstream.allocations(), 1u);
+        pool.deallocate(a, 24);
+        ASSERT_EQ(pool.allocate(30), a);
+        auto aligned = pool.allocate(8, 256);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(aligned) % 256, 0u);
+        auto large = pool.allocate(5000, 128);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(large) % 128, 0u);
+        auto large2 = pool.allocate(10000);
+        pool.deallocate(large, 5000, 128);
+        (void)large2; // released with the pool
+    }
+    ASSERT_EQ(upstream.bytes_in_use(), 0u);
+    ASSERT_EQ(upstream.allocations(), upstream.deallocations());
+    ASSERT_GT(upstream.peak_bytes(), 10000u);
+
+    dl::pmr::synchronized_pool_resource shared(&upstream);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            dl::pmr::vector<int> vec(&shared);
+            for (int i = 0; i < 10000; ++i) {
+                vec.push_back(i);
+            }
+            ASSERT_EQ(vec[9999], 9999);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+TEST(MemoryResourceTest, null_and_default) {
+    ASSERT_THROW(dl::pmr::null_memory_resource()->allocate(1), std::bad_alloc);
+    ASSERT_TRUE(*dl::pmr::new_delete_resource() == *dl::pmr::new_delete_resource());
+    ASSERT_FALSE(*dl::pmr::new_delete_resource() == *dl::pmr::null_memory_resource());
+
+    dl::pmr::counting_resource counting(dl::pmr::new_delete_resource());
+    auto old = dl::pmr::set_default_resource(&counting);
+    ASSERT_EQ(old, dl::pmr::new_delete_resource());
+    {
+        dl::pmr::vector<int> vec{1, 2, 3};
+        ASSERT_EQ(vec.get_allocator().resource(), &counting);
+        ASSERT_EQ(counting.allocations(), 1u);
+    }
+    dl::pmr::set_default_resource(nullptr);
+    ASSERT_EQ(dl::pmr::get_default_resource(), dl::pmr::new_delete_resource());
+
+    // a monotonic arena over the null resource must not fall back to the heap
+    char buffer[64];
+    dl::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), dl::pmr::null_memory_resource());
+    dl::pmr::vector<char> vec(&arena);
+    vec.reserve(32);
+    ASSERT_THROW(vec.reserve(1024), std::bad_alloc);
+}
+
+TEST(MemoryResourceTest, vector_propagation) {
+    dl::pmr::counting_resource r1;
+    dl::pmr::counting_resource r2;
+    dl::pmr::vector<int> a({1, 2, 3}, &r1);
+    dl::pmr::vector<int> b({4, 5}, &r2);
+
+    // copies use the default resource, allocator-extended copies the given one
+    dl::pmr::vector<int> copy(a);
+    ASSERT_EQ(copy.get_allocator().resource(), dl::pmr::get_default_resource());
+    dl::pmr::vector<int> copy2(a, &r2);
+    ASSERT_EQ(copy2.get_allocator().resource(), &r2);
+
+    // assignment keeps the target's resource
+    b = a;
+    ASSERT_EQ(b.get_allocator().resource(), &r2);
+    ASSERT_EQ(b, a);
+
+    auto data = a.data();
+    b = std::move(a);
+    ASSERT_EQ(b.get_allocator().resource(), &r2);
+    ASSERT_NE(b.data(), data);
+    ASSERT_EQ(b, (dl::pmr::vector<int>{1, 2, 3}));
+
+    dl::pmr::vector<int> c({7}, &r2);
+    data = c.data();
+    b = std::move(c);
+    ASSERT_EQ(b.data(), data);
+    ASSERT_TRUE(c.empty());
+
+    dl::pmr::vector<int> d({8, 9}, &r2);
+    b.swap(d);
+    ASSERT_EQ(b, (dl::pmr::vector<int>{8, 9}));
+    ASSERT_EQ(d.get_allocator().resource(), &r2);
+
+    // move construction takes the resource along with the buffer
+    dl::pmr::vector<int> moved(std::move(d));
+    ASSERT_EQ(moved.get_allocator().resource(), &r2);
+    ASSERT_EQ(moved.data(), data);
+}
+
+TEST(MemoryResourceTest, uses_allocator) {
+    dl::pmr::monotonic_buffer_resource arena;
+    dl::pmr::vector<dl::pmr::vector<int>> outer(&arena);
+    outer.emplace_back(3);
+    outer.emplace_back();
+    outer.back().push_back(5);
+    outer.reserve(16); // inner vectors are moved, not copied to another resource
+    for (auto& inner : outer) {
+        ASSERT_EQ(inner.get_allocator().resource(), &arena);
+    }
+    ASSERT_EQ(outer[0].size(), 3u);
+    ASSERT_EQ(outer[1][0], 5);
+}
@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <random>
+#include "packed_vector.h"
+#include "vector.h"
+
+TEST(PackedVectorTest, Basic) {
+    dl::packed_vector<uint32_t> vec(5);
+    ASSERT_EQ(vec.bit_width(), 5u);
+    ASSERT_TRUE(vec.empty());
+
+    for (uint32_t i = 0; i < 100; ++i) {
+        vec.push_back(i % 32);
+    }
+    ASSERT_EQ(vec.size(), 100u);
+    for (uint32_t i = 0; i < 100; ++i) {
+        ASSERT_EQ(vec[i], i % 32);
+    }
+    ASSERT_EQ(vec.front(), 0u);
+    ASSERT_EQ(vec.back(), 99u % 32);
+    ASSERT_LE(vec.memory_bytes(), 2 * (100 * 5 / 8 + 16));
+
+    vec.set(10, 31);
+    ASSERT_EQ(vec[9], 9u);
+    ASSERT_EQ(vec[10], 31u);
+    ASSERT_EQ(vec[11], 11u);
+
+    vec.pop_back();
+    ASSERT_EQ(vec.size(), 99u);
+    ASSERT_THROW(vec.at(99), std::out_of_range);
+    ASSERT_THROW(dl::packed_vector<uint8_t>(9), std::invalid_argument);
+}
+
+TEST(PackedVectorTest, Widths) {
+    std::mt19937_64 gen(42);
+    for (unsigned width = 1; width <= 64; ++width) {
+        dl::packed_vector<uint64_t> vec(width);
+        dl::vector<uint64_t> res;
+        for (int i = 0; i < 257; ++i) {
+            auto v = gen() & dl::low_mask(width);
+            vec.push_back(v);
+            res.push_back(v);
+        }
+        dl::vector<uint64_t> out;
+        vec.unpack(out);
+        ASSERT_EQ(out, res) << "width " << width;
+        for (size_t i = 0; i < res.size(); ++i) {
+            ASSERT_EQ(vec[i], res[i]);
+        }
+    }
+}
+
+TEST(PackedVectorTest, Resize) {
+    dl::packed_vector<uint16_t> vec(3, 4, 7);
+    vec.resize(6, 2);
+    dl::vector<uint16_t> out;
+    vec.unpack(out);
+    ASSERT_EQ(out, (dl::vector<uint16_t>{7, 7, 7, 7, 2, 2}));
+
+    vec.resize(2);
+    ASSERT_EQ(vec.size(), 2u);
+    vec.clear();
+    ASSERT_TRUE(vec.empty());
+}
+
+TEST(DeltaPackedVectorTest, Basic) {
+    dl::delta_packed_vector<uint64_t, 8> vec;
+    dl::vector<uint64_t> res;
+    uint64_t cur = 1000;
+    std::mt19937_64 gen(7);
+    for (int i = 0; i < 100; ++i) {
+        cur += gen() % (i % 3 == 0 ? 1 : 50);
+        vec.push_back(cur);
+        res.push_back(cur);
+    }
+    ASSERT_EQ(vec.size(), res.size());
+    ASSERT_EQ(vec.blocks().size(), 100u / 8);
+    for (size_t i = 0; i < res.size(); ++i) {
+        ASSERT_EQ(vec[i], res[i]);
+    }
+    dl::vector<uint64_t> out;
+    vec.unpack(out);
+    ASSERT_EQ(out, res);
+
+    for (auto v : {uint64_t(0), res[0], res[17], res[17] + 1, res[64], res[99], res[99] + 1}) {
+        auto expected = std::lower_bound(res.begin(), res.end(), v) - res.begin();
+        ASSERT_EQ(vec.lower_bound(v), static_cast<size_t>(expected)) << v;
+    }
+    ASSERT_THROW(vec.push_back(0), std::invalid_argument);
+}
+
+TEST(DeltaPackedVectorTest, Constant) {
+    dl::vector<uint32_t> res(300, 5);
+    dl::delta_packed_vector<uint32_t> vec(res.begin(), res.end());
+    ASSERT_EQ(vec.blocks()[0].width, 0u);
+    dl::vector<uint32_t> out;
+    vec.unpack(out);
+    ASSERT_EQ(out, res);
+    ASSERT_EQ(vec[200], 5u);
+}
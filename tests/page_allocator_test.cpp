@@ -0,0 +1,165 @@
+#include <cstdint>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "page_allocator.h"
+#include "prefault.h"
+#include "split_buffer.h"
+#include "vector.h"
+
+template<typename Vector>
+void fill_and_check(Vector& vec, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        vec.push_back(i);
+    }
+    ASSERT_EQ(vec.size(), n);
+    for (size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(vec[i], i);
+    }
+}
+
+TEST(HugepageAllocatorTest, Basic) {
+    dl::vector<size_t, dl::hugepage_allocator<size_t>> vec;
+    fill_and_check(vec, 1 << 20);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(vec.data()) % dl::huge_page_size, 0u);
+
+    dl::vector<size_t, dl::hugepage_allocator<size_t>> small{1, 2, 3};
+    ASSERT_EQ(small.size(), 3u);
+
+    dl::hugepage_allocator<int> a;
+    dl::hugepage_allocator<char> b(a);
+    ASSERT_TRUE(a == b);
+
+    dl::split_buffer<int, dl::hugepage_allocator<int>&> buff(0, 1 << 20, a);
+    buff.construct_at_end(1 << 20, 5);
+    ASSERT_EQ(buff.begin[(1 << 20) - 1], 5);
+}
+
+TEST(NumaAllocatorTest, Basic) {
+    for (auto policy : {dl::numa_policy::local, dl::numa_policy::interleave, dl::numa_policy::bind}) {
+        dl::numa_allocator<size_t> alloc(policy);
+        ASSERT_NE(alloc.nodes(), 0u);
+        dl::vector<size_t, dl::numa_allocator<size_t>> vec(alloc);
+        fill_and_check(vec, 1 << 18);
+        ASSERT_EQ(vec.get_allocator().policy(), policy);
+    }
+}
+
+TEST(HugepageAllocatorTest, shrink_in_place) {
+    dl::vector<size_t, dl::hugepage_allocator<size_t>, dl::fraction_shrink<>> vec;
+    fill_and_check(vec, 1 << 20);
+    auto data = vec.data();
+    vec.resize(1 << 17);
+    ASSERT_EQ(vec.data(), data);
+    ASSERT_EQ(vec.capacity(), size_t(1) << 18);
+    ASSERT_EQ(vec.back(), (1u << 17) - 1);
+
+    dl::hugepage_allocator<char> a;
+    auto p = a.allocate(1000);
+    ASSERT_FALSE(a.shrink_in_place(p, 1000, 10));
+    a.deallocate(p, 1000);
+}
+
+// Fraction of the pages under [p, p + bytes) that are resident.
+static double resident_fraction(const void* p, size_t bytes) {
+    auto page = dl::system_page_size();
+    auto start = reinterpret_cast<uintptr_t>(p) / page * page;
+    auto len = dl::round_up(reinterpret_cast<uintptr_t>(p) + bytes, page) - start;
+    std::vector<unsigned char> status(len / page);
+    if (::mincore(reinterpret_cast<void*>(start), len, status.data()) != 0) {
+        return -1;
+    }
+    size_t resident = 0;
+    for (auto s : status) {
+        resident += s & 1;
+    }
+    return static_cast<double>(resident) / static_cast<double>(status.size());
+}
+
+static size_t locked_kib() {
+    size_t kib = 0;
+    std::ifstream status("/proc/self/status");
+    for (std::string line; std::getline(status, line);) {
+        if (line.rfind("VmLck:", 0) == 0) {
+            kib = std::stoul(line.substr(6));
+        }
+    }
+    return kib;
+}
+
+// The sanitizer runtimes turn mlock into a no-op.
+#if defined(__SANITIZE_ADDRESS__)
+#define DL_TEST_NO_MLOCK
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define DL_TEST_NO_MLOCK
+#endif
+#endif
+
+TEST(LockedAllocatorTest, Basic) {
+    size_t n = size_t(1) << 18;
+    auto before = locked_kib();
+    {
+        dl::vector<size_t, dl::locked_allocator<size_t>> vec;
+        vec.reserve(n);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(vec.data()) % dl::system_page_size(), 0u);
+        ASSERT_EQ(resident_fraction(vec.data(), n * sizeof(size_t)), 1.0);
+#ifndef DL_TEST_NO_MLOCK
+        rlimit limit{};
+        ::getrlimit(RLIMIT_MEMLOCK, &limit);
+        if (limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur >= 2 * n * sizeof(size_t)) {
+            ASSERT_GE(locked_kib(), before + n * sizeof(size_t) / 1024);
+        }
+#endif
+        auto data = vec.data();
+        fill_and_check(vec, n);
+        ASSERT_EQ(vec.data(), data);
+    }
+    ASSERT_EQ(locked_kib(), before);
+
+    dl::vector<int, dl::locked_allocator<int>, dl::fraction_shrink<>> small{1, 2, 3};
+    small.resize(4000);
+    auto data = small.data();
+    small.resize(10);
+    ASSERT_LT(small.capacity(), 4000u);
+    ASSERT_EQ(small.data(), data); // gave back pages in place
+    ASSERT_EQ(small[2], 3);
+
+    dl::locked_allocator<int> a;
+    ASSERT_TRUE(a == dl::locked_allocator<char>());
+    a.deallocate(a.allocate(0), 0);
+}
+
+TEST(PrefaultTest, reserve_prefault) {
+    size_t n = size_t(1) << 20;
+    dl::vector<size_t> vec{1, 2, 3};
+    dl::reserve_prefault(vec, n);
+    ASSERT_EQ(vec.capacity(), n);
+    ASSERT_EQ(vec.size(), 3u);
+    ASSERT_EQ(vec[2], 3u);
+    ASSERT_GE(resident_fraction(vec.data(), n * sizeof(size_t)), 0.99);
+
+    // spare capacity of the current buffer
+    dl::vector<size_t> other;
+    other.reserve(n);
+    auto data = other.data();
+    other.push_back(7);
+    dl::reserve_prefault(other, n / 2);
+    ASSERT_EQ(other.data(), data);
+    ASSERT_EQ(other[0], 7u);
+    ASSERT_GE(resident_fraction(other.data(), n * sizeof(size_t)), 0.99);
+
+    std::vector<size_t> std_vec{1};
+    dl::reserve_prefault(std_vec, n);
+    ASSERT_GE(std_vec.capacity(), n);
+    ASSERT_GE(resident_fraction(std_vec.data(), n * sizeof(size_t)), 0.99);
+
+    char buf[100];
+    buf[0] = 'x';
+    buf[99] = 'y';
+    dl::prefault(buf + 1, 98);
+    ASSERT_EQ(buf[0], 'x');
+    ASSERT_EQ(buf[99], 'y');
+}
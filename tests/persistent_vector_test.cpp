@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "persistent_vector.h"
+#include "test_type.h"
+#include "vector.h"
+
+template<typename T, typename A>
+static void check_equal(const dl::persistent_vector<T, A>& vec, const dl::vector<int>& model) {
+    ASSERT_EQ(vec.size(), model.size());
+    size_t i = 0;
+    for (auto& x : vec) {
+        ASSERT_EQ(x, model[i]);
+        ASSERT_EQ(vec[i], model[i]);
+        ++i;
+    }
+    ASSERT_EQ(i, model.size());
+}
+
+TEST(PersistentVectorTest, push_back) {
+    dl::persistent_vector<int> empty;
+    ASSERT_TRUE(empty.empty());
+    ASSERT_EQ(empty.begin(), empty.end());
+
+    // every version stays valid while later ones are built on it
+    dl::vector<dl::persistent_vector<int>> versions;
+    versions.push_back(empty);
+    for (int i = 0; i < 40000; ++i) {
+        versions.push_back(versions.back().push_back(i));
+    }
+    for (size_t n = 0; n < versions.size(); n += 997) {
+        ASSERT_EQ(versions[n].size(), n);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_EQ(versions[n][i], static_cast<int>(i));
+        }
+    }
+    auto& last = versions.back();
+    ASSERT_EQ(last.back(), 39999);
+    ASSERT_EQ(last.at(1234), 1234);
+    ASSERT_THROW(last.at(40000), std::out_of_range);
+    ASSERT_TRUE(last.shares_leaf(versions[20000], 100));
+
+    auto it = last.end();
+    for (int i = 39999; i >= 0; --i) {
+        ASSERT_EQ(*--it, i);
+    }
+    ASSERT_EQ(last.end() - last.begin(), 40000);
+    ASSERT_EQ(*(last.begin() + 33000), 33000);
+    ASSERT_EQ(last.begin()[1055], 1055);
+    ASSERT_EQ(*last.rbegin(), 39999);
+}
+
+TEST(PersistentVectorTest, set) {
+    dl::persistent_vector<int> base;
+    for (int i = 0; i < 5000; ++i) {
+        base = std::move(base).push_back(i);
+    }
+    auto changed = base.set(100, -1).set(4999, -2);
+    ASSERT_EQ(base[100], 100);
+    ASSERT_EQ(base[4999], 4999);
+    ASSERT_EQ(changed[100], -1);
+    ASSERT_EQ(changed[4999], -2);
+    ASSERT_FALSE(changed.shares_leaf(base, 100));
+    ASSERT_TRUE(changed.shares_leaf(base, 200));
+    ASSERT_TRUE(changed != base);
+    ASSERT_TRUE(changed.set(100, 100).set(4999, 4999) == base);
+
+    // an rvalue with unshared nodes is changed in place
+    auto same = changed.set(7, 7);
+    auto leaf = &same[7];
+    same = std::move(same).set(7, 8);
+    ASSERT_EQ(&same[7], leaf);
+    ASSERT_EQ(same[7], 8);
+}
+
+TEST(PersistentVectorTest, pop_back) {
+    dl::persistent_vector<int> vec;
+    dl::vector<int> model;
+    for (int i = 0; i < 2000; ++i) {
+        vec = std::move(vec).push_back(i);
+        model.push_back(i);
+    }
+    auto full = vec;
+    while (!vec.empty()) {
+        vec = vec.pop_back();
+        model.pop_back();
+        if (model.size() % 31 == 0 || model.size() < 40) {
+            check_equal(vec, model);
+        }
+    }
+    ASSERT_EQ(full.size(), 2000u);
+    ASSERT_EQ(full.back(), 1999);
+    vec = full.push_back(2000).pop_back().pop_back();
+    ASSERT_EQ(vec.back(), 1998);
+}
+
+TEST(PersistentVectorTest, transient) {
+    dl::persistent_vector<int> base{1, 2, 3};
+    auto t = base.transient();
+    for (int i = 0; i < 3000; ++i) {
+        t.push_back(i);
+    }
+    t.set(0, 9);
+    t.pop_back();
+    auto built = t.persistent();
+    t.set(1, 8); // copies the nodes now shared with built
+    ASSERT_EQ(base, (dl::persistent_vector<int>{1, 2, 3}));
+    ASSERT_EQ(built.size(), 3002u);
+    ASSERT_EQ(built[0], 9);
+    ASSERT_EQ(built[1], 2);
+    ASSERT_EQ(built.back(), 2998);
+    ASSERT_EQ(t[1], 8);
+    ASSERT_EQ(std::move(t).persistent()[0], 9);
+}
+
+TEST(PersistentVectorTest, random_versions) {
+    trace_int::init();
+    {
+        std::mt19937 gen(42);
+        dl::vector<dl::persistent_vector<trace_int>> versions(1);
+        dl::vector<dl::vector<int>> models(1);
+        for (int step = 0; step < 3000; ++step) {
+            auto from = std::uniform_int_distribution<size_t>(0, versions.size() - 1)(gen);
+            auto vec = versions[from];
+            auto model = models[from];
+            auto op = gen() % 8;
+            if (op == 0 && !model.empty()) {
+                vec = vec.pop_back();
+                model.pop_back();
+            } else if (op <= 2 && !model.empty()) {
+                auto i = gen() % model.size();
+                vec = vec.set(i, trace_int(step));
+                model[i] = step;
+            } else {
+                for (int k = 0, n = static_cast<int>(gen() % 70); k < n; ++k) {
+                    vec = std::move(vec).push_back(trace_int(step));
+                    model.push_back(step);
+                }
+            }
+            versions.push_back(std::move(vec));
+            models.push_back(std::move(model));
+        }
+        for (size_t v = 0; v < versions.size(); ++v) {
+            ASSERT_EQ(versions[v].size(), models[v].size());
+            for (size_t i = 0; i < models[v].size(); ++i) {
+                ASSERT_EQ(versions[v][i].value, models[v][i]);
+            }
+        }
+    }
+    ASSERT_EQ(trace_int::destruct, trace_int::basic_construct + trace_int::copy_lval_construct
+                                   + trace_int::move_rval_construct);
+}
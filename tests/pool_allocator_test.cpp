@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "pool_allocator.h"
+#include "vector.h"
+
+TEST(PoolAllocatorTest, reuse) {
+    struct alignas(32) node
+    {
+        char data[40];
+    };
+    using pool = dl::pool_allocator<node>::pool;
+    static_assert(pool::block_size == 64);
+
+    dl::pool_allocator<node> alloc;
+    auto a = alloc.allocate(1);
+    auto b = alloc.allocate(1);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(a) % 32, 0u);
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(b) % 32, 0u);
+    ASSERT_NE(a, b);
+    alloc.deallocate(a, 1);
+    ASSERT_EQ(alloc.allocate(1), a);
+    auto reserved = pool::reserved_bytes();
+    ASSERT_GT(reserved, 0u);
+
+    // arrays bypass the pool
+    auto array = alloc.allocate(10);
+    alloc.deallocate(array, 10);
+    ASSERT_EQ(pool::reserved_bytes(), reserved);
+    alloc.deallocate(a, 1);
+    alloc.deallocate(b, 1);
+}
+
+TEST(PoolAllocatorTest, threads) {
+    using pool = dl::object_pool<24, 8>;
+    dl::vector<void*> blocks;
+    for (int i = 0; i < 1000; ++i) {
+        blocks.push_back(pool::allocate());
+    }
+    // blocks freed by other threads, then the threads exit
+    dl::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            for (size_t i = t; i < blocks.size(); i += 4) {
+                pool::deallocate(blocks[i]);
+            }
+            for (int i = 0; i < 500; ++i) {
+                pool::deallocate(pool::allocate());
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto reserved = pool::reserved_bytes();
+    for (auto& b : blocks) {
+        b = pool::allocate();
+    }
+    ASSERT_EQ(pool::reserved_bytes(), reserved);
+    for (auto b : blocks) {
+        pool::deallocate(b);
+    }
+}
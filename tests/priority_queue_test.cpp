@@ -0,0 +1,242 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <gtest/gtest.h>
+#include <limits>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include "priority_queue.h"
+#include "vector.h"
+
+namespace {
+
+template<size_t Arity>
+void check_against_std(uint64_t seed) {
+    std::mt19937_64 gen(seed);
+    dl::priority_queue<int, std::less<int>, Arity> queue;
+    std::priority_queue<int> expected;
+    for (int step = 0; step < 20000; ++step) {
+        auto op = gen() % 8;
+        int value = static_cast<int>(gen() % 1000);
+        if (op < 4 || expected.empty()) {
+            queue.push(value);
+            expected.push(value);
+        } else if (op < 7) {
+            queue.pop();
+            expected.pop();
+        } else {
+            queue.pop_push(value);
+            expected.pop();
+            expected.push(value);
+        }
+        ASSERT_EQ(queue.size(), expected.size());
+        if (!expected.empty()) {
+            ASSERT_EQ(queue.top(), expected.top());
+        }
+    }
+    ASSERT_TRUE((dl::is_dary_heap<Arity>(queue.container().begin(), queue.container().end())));
+}
+
+// Keeps the heap index of every node of a graph in a side table.
+struct node_position
+{
+    dl::vector<size_t>* index;
+
+    void operator()(const std::pair<uint32_t, uint32_t>& entry, size_t i) const noexcept {
+        (*index)[entry.second] = i;
+    }
+};
+
+// Single-pass input whose dereference throws at position fail.
+struct throwing_input
+{
+    using iterator_category = std::input_iterator_tag;
+    using value_type = int;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const int*;
+    using reference = int;
+
+    int operator*() const {
+        if (pos == fail)
+            throw std::runtime_error("input");
+        return pos;
+    }
+    throwing_input& operator++() { ++pos; return *this; }
+    void operator++(int) { ++pos; }
+    bool operator==(const throwing_input& o) const { return pos == o.pos; }
+    bool operator!=(const throwing_input& o) const { return pos != o.pos; }
+
+    int pos;
+    int fail;
+};
+
+} // namespace
+
+TEST(PriorityQueueTest, MatchesStd) {
+    check_against_std<2>(1);
+    check_against_std<4>(2);
+    check_against_std<8>(3);
+}
+
+TEST(PriorityQueueTest, HeapAlgorithms) {
+    std::mt19937 gen(4);
+    dl::vector<int> vec(1001);
+    for (auto& v : vec) {
+        v = static_cast<int>(gen() % 100);
+    }
+    dl::make_dary_heap<4>(vec.begin(), vec.end(), std::greater<>());
+    ASSERT_TRUE((dl::is_dary_heap<4>(vec.begin(), vec.end(), std::greater<>())));
+    ASSERT_FALSE((dl::is_dary_heap<4>(vec.begin(), vec.end())));
+
+    vec.push_back(-1);
+    dl::push_dary_heap<4>(vec.begin(), vec.end(), std::greater<>());
+    ASSERT_EQ(vec.front(), -1);
+
+    // popping everything leaves the range sorted, largest first
+    for (auto last = vec.end(); last != vec.begin(); --last) {
+        dl::pop_dary_heap<4>(vec.begin(), last, std::greater<>());
+    }
+    ASSERT_TRUE(std::is_sorted(vec.begin(), vec.end(), std::greater<>()));
+    ASSERT_EQ(vec.back(), -1);
+}
+
+TEST(PriorityQueueTest, PushRange) {
+    dl::vector<int> input;
+    for (int i = 0; i < 5000; ++i) {
+        input.push_back((i * 7919) % 5000);
+    }
+
+    dl::priority_queue<int, std::greater<int>, 8> queue(input.begin(), input.begin() + 100);
+    ASSERT_EQ(queue.top(), 0);
+    queue.push_range(input.begin() + 100, input.begin() + 110); // sifted up one by one
+    queue.push_range(input.begin() + 110, input.end());          // rebuilt bottom-up
+    ASSERT_EQ(queue.size(), 5000u);
+    for (int i = 0; i < 5000; ++i) {
+        ASSERT_EQ(queue.top(), i);
+        queue.pop();
+    }
+    ASSERT_TRUE(queue.empty());
+
+    queue.push_range(dl::vector<int>{3, 1, 2});
+    ASSERT_EQ(queue.top(), 1);
+    dl::priority_queue<int> from_list{4, 9, 2};
+    ASSERT_EQ(from_list.top(), 9);
+}
+
+TEST(PriorityQueueTest, PushRangeThrows) {
+    dl::priority_queue<int> queue{4, 9, 2};
+    ASSERT_THROW(queue.push_range(throwing_input{10, 15}, throwing_input{20, 15}), std::runtime_error);
+    ASSERT_EQ(queue.size(), 3u);
+    ASSERT_EQ(queue.top(), 9);
+    ASSERT_TRUE((dl::is_dary_heap<4>(queue.container().begin(), queue.container().end())));
+    queue.push_range(throwing_input{10, 30}, throwing_input{20, 30});
+    ASSERT_EQ(queue.size(), 13u);
+    ASSERT_EQ(queue.top(), 19);
+}
+
+TEST(PriorityQueueTest, DecreaseKey) {
+    // Dijkstra on a grid with random weights, against a lazy-deletion
+    // std::priority_queue.
+    constexpr uint32_t side = 40;
+    constexpr uint32_t nodes = side * side;
+    std::mt19937 gen(5);
+    dl::vector<uint32_t> weight(nodes);
+    for (auto& w : weight) {
+        w = 1 + gen() % 50;
+    }
+    auto neighbours = [&](uint32_t v, auto&& fn) {
+        auto x = v % side;
+        auto y = v / side;
+        if (x > 0) fn(v - 1);
+        if (x + 1 < side) fn(v + 1);
+        if (y > 0) fn(v - side);
+        if (y + 1 < side) fn(v + side);
+    };
+    constexpr auto inf = std::numeric_limits<uint32_t>::max();
+
+    using entry = std::pair<uint32_t, uint32_t>; // distance, node
+    dl::vector<uint32_t> expected(nodes, inf);
+    std::priority_queue<entry, std::vector<entry>, std::greater<>> lazy;
+    expected[0] = 0;
+    lazy.push({0, 0});
+    while (!lazy.empty()) {
+        auto [d, v] = lazy.top();
+        lazy.pop();
+        if (d != expected[v]) {
+            continue;
+        }
+        neighbours(v, [&](uint32_t u) {
+            if (d + weight[u] < expected[u]) {
+                expected[u] = d + weight[u];
+                lazy.push({expected[u], u});
+            }
+        });
+    }
+
+    constexpr size_t absent = ~size_t(0);
+    dl::vector<size_t> index(nodes, absent);
+    dl::vector<uint32_t> dist(nodes, inf);
+    dl::priority_queue<entry, std::greater<>, 4, node_position> queue(std::greater<>(), node_position{&index});
+    dist[0] = 0;
+    queue.push({0, 0});
+    size_t pushes = 1;
+    while (!queue.empty()) {
+        auto [d, v] = queue.top();
+        queue.pop();
+        index[v] = absent;
+        neighbours(v, [&](uint32_t u) {
+            if (d + weight[u] >= dist[u]) {
+                return;
+            }
+            dist[u] = d + weight[u];
+            if (index[u] == absent) {
+                queue.push({dist[u], u});
+                ++pushes;
+            } else {
+                ASSERT_EQ(queue.container()[index[u]].second, u);
+                queue.decrease_key(index[u], {dist[u], u});
+            }
+        });
+    }
+    ASSERT_EQ(dist, expected);
+    ASSERT_EQ(pushes, size_t(nodes)); // one entry per node, updated in place
+}
+
+TEST(PriorityQueueTest, UpdateErase) {
+    using entry = std::pair<uint32_t, uint32_t>; // priority, id
+    dl::vector<size_t> index(100);
+    dl::priority_queue<entry, std::less<>, 8, node_position> queue(std::less<>(), node_position{&index});
+    dl::vector<entry> input;
+    for (uint32_t i = 0; i < 100; ++i) {
+        input.push_back({i * 37 % 100, i});
+    }
+    queue.push_range(input);
+    for (uint32_t i = 0; i < 100; ++i) {
+        ASSERT_EQ(queue.container()[index[i]].second, i);
+    }
+
+    auto top_id = queue.top().second;
+    queue.update(index[top_id], {0, top_id}); // down
+    ASSERT_NE(queue.top().second, top_id);
+    queue.update(index[7], {1000, 7});        // up
+    ASSERT_EQ(queue.top(), (entry{1000, 7}));
+    queue.erase(index[7]);
+    queue.erase(index[42]);
+    ASSERT_EQ(queue.size(), 98u);
+    ASSERT_TRUE((dl::is_dary_heap<8>(queue.container().begin(), queue.container().end())));
+
+    uint32_t last = ~0u;
+    while (!queue.empty()) {
+        ASSERT_NE(queue.top().second, 42u);
+        ASSERT_LE(queue.top().first, last);
+        last = queue.top().first;
+        queue.pop();
+    }
+}
+
+TEST(PriorityQueueTest, EmptyPolicies) {
+    ASSERT_EQ(sizeof(dl::priority_queue<int>), sizeof(dl::vector<int>));
+}
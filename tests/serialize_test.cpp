@@ -0,0 +1,97 @@
+#include <cstdint>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include "serialize.h"
+#include "vector.h"
+
+class SerializeTest : public ::testing::Test
+{
+protected:
+    void SetUp() override {
+        file = std::tmpfile();
+        fd = ::fileno(file);
+    }
+
+    void TearDown() override {
+        std::fclose(file);
+    }
+
+    void rewind() {
+        ::lseek(fd, 0, SEEK_SET);
+    }
+
+    std::FILE* file = nullptr;
+    int fd = -1;
+};
+
+TEST_F(SerializeTest, Flat) {
+    dl::vector<uint32_t> vec{1, 2, 3, 4, 5};
+    dl::vector<uint32_t> empty;
+    dl::write(fd, vec);
+    dl::write(fd, empty);
+    dl::write(fd, vec);
+
+    rewind();
+    dl::vector<uint32_t> res{9, 9};
+    dl::read(fd, res);
+    ASSERT_EQ(res, vec);
+    dl::read(fd, res);
+    ASSERT_TRUE(res.empty());
+    dl::read(fd, res);
+    ASSERT_EQ(res, vec);
+    ASSERT_THROW(dl::read(fd, res), std::runtime_error);
+
+    auto next = dl::pread(fd, 0, res);
+    ASSERT_EQ(res, vec);
+    ASSERT_EQ(next, static_cast<off_t>(sizeof(uint64_t) + 5 * sizeof(uint32_t)));
+    next = dl::pread(fd, next, res);
+    ASSERT_TRUE(res.empty());
+    dl::pread(fd, next, res);
+    ASSERT_EQ(res, vec);
+    ASSERT_EQ(res.capacity(), vec.size());
+}
+
+TEST_F(SerializeTest, Truncated) {
+    dl::vector<uint32_t> vec{1, 2, 3, 4, 5};
+    dl::write(fd, vec);
+    ASSERT_EQ(::ftruncate(fd, sizeof(uint64_t) + 3 * sizeof(uint32_t)), 0);
+
+    rewind();
+    dl::vector<uint32_t> res{9, 9};
+    ASSERT_THROW(dl::read(fd, res), std::runtime_error);
+    ASSERT_TRUE(res.empty());
+    ASSERT_THROW(dl::pread(fd, 0, res), std::runtime_error);
+    ASSERT_TRUE(res.empty());
+}
+
+TEST_F(SerializeTest, Nested) {
+    dl::vector<dl::vector<double>> vec{{1.5}, {}, {2.5, 3.5, 4.5}};
+    dl::write(fd, vec);
+
+    rewind();
+    dl::vector<dl::vector<double>> res;
+    dl::read(fd, res);
+    ASSERT_EQ(res, vec);
+}
+
+TEST_F(SerializeTest, Stream) {
+    dl::vector_writer<int> writer(fd);
+    dl::vector<int> chunk{1, 2, 3};
+    writer.write(chunk);
+    writer.write(dl::vector<int>(1000, 7));
+    writer.write(chunk.data(), 0);
+    writer.finish();
+    writer.finish();
+    ASSERT_EQ(writer.written(), 1003u);
+
+    rewind();
+    dl::vector_reader<int> reader(fd);
+    dl::vector<int> res;
+    ASSERT_TRUE(reader.next(res));
+    ASSERT_EQ(res, chunk);
+    ASSERT_TRUE(reader.next(res));
+    ASSERT_EQ(res, dl::vector<int>(1000, 7));
+    ASSERT_FALSE(reader.next(res));
+    ASSERT_FALSE(reader.next(res));
+}
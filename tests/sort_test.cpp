@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include "memory_resource.h"
+#include "sort.h"
+#include "thread_pool.h"
+#include "vector.h"
+
+template<typename T>
+dl::vector<T> random_vector(size_t n, uint64_t seed) {
+    std::mt19937_64 gen(seed);
+    dl::vector<T> vec;
+    vec.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        vec.push_back(static_cast<T>(gen()));
+    }
+    return vec;
+}
+
+TEST(ThreadPoolTest, Run) {
+    dl::thread_pool pool(4);
+    ASSERT_EQ(pool.size(), 4u);
+    dl::vector<int> hits(1000, 0);
+    pool.run(hits.size(), [&](size_t i) { ++hits[i]; });
+    ASSERT_EQ(hits, dl::vector<int>(1000, 1));
+
+    ASSERT_THROW(pool.run(10, [](size_t i) {
+                     if (i == 7)
+                         throw std::runtime_error("task");
+                 }), std::runtime_error);
+
+    size_t total = 0;
+    pool.for_range(100, [&](size_t first, size_t last) {
+        pool.run(last - first, [&](size_t) {}); // nested runs are serial
+        __atomic_add_fetch(&total, last - first, __ATOMIC_RELAXED);
+    });
+    ASSERT_EQ(total, 100u);
+}
+
+TEST(RadixSortTest, Integers) {
+    for (unsigned bits : {8u, 11u, 16u}) {
+        auto vec = random_vector<uint64_t>(10000, bits);
+        auto res = vec;
+        std::sort(res.begin(), res.end());
+        dl::radix_sort(vec, dl::identity_key(), bits);
+        ASSERT_EQ(vec, res);
+    }
+    {
+        auto vec = random_vector<int32_t>(5000, 3);
+        auto res = vec;
+        std::sort(res.begin(), res.end());
+        dl::radix_sort(vec.begin(), vec.end());
+        ASSERT_EQ(vec, res);
+    }
+    dl::vector<int> vec{2, 1};
+    ASSERT_THROW(dl::radix_sort(vec, dl::identity_key(), 17), std::invalid_argument);
+}
+
+TEST(RadixSortTest, Floats) {
+    dl::vector<double> vec{3.5, -1.0, 0.0, -0.0, 1e300, -1e-300, 2.25, -7.5};
+    auto res = vec;
+    std::sort(res.begin(), res.end());
+    dl::radix_sort(vec);
+    for (size_t i = 0; i < vec.size(); ++i) {
+        ASSERT_EQ(vec[i], res[i]);
+    }
+}
+
+TEST(RadixSortTest, KeyValue) {
+    dl::vector<std::pair<uint32_t, int>> vec;
+    for (int i = 0; i < 1000; ++i) {
+        vec.push_back({static_cast<uint32_t>((i * 7919) % 100), i});
+    }
+    auto res = vec;
+    std::stable_sort(res.begin(), res.end(), [](auto& a, auto& b) { return a.first < b.first; });
+    dl::radix_sort(vec, [](const auto& p) { return p.first; }, 11);
+    ASSERT_EQ(vec, res);
+}
+
+TEST(RadixSortTest, ThrowingKey) {
+    auto shared = std::make_shared<int>(0);
+    dl::vector<std::pair<uint32_t, std::shared_ptr<int>>> vec;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        vec.push_back({(i * 7919) % 1000, shared});
+    }
+    size_t calls = 0;
+    auto key = [&](const auto& p) {
+        if (++calls == vec.size() + 500) { // halfway through the first scatter
+            throw std::runtime_error("key");
+        }
+        return p.first;
+    };
+    ASSERT_THROW(dl::radix_sort(vec, key), std::runtime_error);
+    // 499 elements had been moved to scratch space, which released them
+    ASSERT_EQ(shared.use_count(), 1 + 501);
+}
+
+TEST(RadixSortTest, Allocator) {
+    dl::pmr::counting_resource resource;
+    dl::pmr::vector<uint32_t> vec{dl::pmr::polymorphic_allocator<uint32_t>(&resource)};
+    for (uint32_t i = 0; i < 1000; ++i) {
+        vec.push_back((i * 7919) % 1000);
+    }
+    auto before = resource.allocations();
+    dl::radix_sort(vec);
+    ASSERT_TRUE(std::is_sorted(vec.begin(), vec.end()));
+    ASSERT_EQ(resource.allocations(), before + 3); // counters, bucket starts, scratch
+    ASSERT_EQ(resource.deallocations(), resource.allocations() - 1);
+}
+
+TEST(ParallelSortTest, Basic) {
+    dl::thread_pool pool(4);
+    auto vec = random_vector<uint32_t>(200000, 5);
+    auto res = vec;
+    std::sort(res.begin(), res.end());
+    dl::parallel_sort(vec.begin(), vec.end(), std::less<>(), pool);
+    ASSERT_EQ(vec, res);
+
+    std::sort(res.begin(), res.end(), std::greater<>());
+    dl::parallel_sort(vec, std::greater<>(), pool);
+    ASSERT_EQ(vec, res);
+
+    dl::vector<int> dups(100000, 3);
+    dups[500] = 1;
+    dl::parallel_sort(dups, std::less<>(), pool);
+    ASSERT_TRUE(std::is_sorted(dups.begin(), dups.end()));
+    ASSERT_EQ(dups[0], 1);
+}
@@ -0,0 +1,85 @@
+#include <array>
+#include <gtest/gtest.h>
+#include <numeric>
+#include "span.h"
+#include "test_type.h"
+#include "vector.h"
+
+static int sum(dl::span<const int> s) {
+    return std::accumulate(s.begin(), s.end(), 0);
+}
+
+TEST(SpanTest, Basic) {
+    dl::span<int> empty;
+    ASSERT_TRUE(empty.empty());
+    ASSERT_EQ(empty.data(), nullptr);
+    ASSERT_EQ(sizeof(empty), 2 * sizeof(void*));
+
+    int arr[] = {1, 2, 3, 4};
+    dl::span s(arr);
+    static_assert(std::is_same_v<decltype(s), dl::span<int>>);
+    ASSERT_EQ(s.size(), 4u);
+    ASSERT_EQ(s.size_bytes(), sizeof(arr));
+    ASSERT_EQ(s.front(), 1);
+    ASSERT_EQ(s.back(), 4);
+    ASSERT_EQ(s.at(2), 3);
+    ASSERT_THROW(s.at(4), std::out_of_range);
+    ASSERT_EQ(*s.rbegin(), 4);
+    s[0] = 9;
+    ASSERT_EQ(arr[0], 9);
+
+    ASSERT_EQ(dl::span<int>(arr + 1, arr + 3).size(), 2u);
+    ASSERT_EQ(dl::span<int>(arr, 0).size(), 0u);
+    ASSERT_EQ(dl::as_bytes(s).size(), sizeof(arr));
+    dl::as_writable_bytes(s)[0] = std::byte{0};
+    ASSERT_EQ(arr[0] & 0xff, 0);
+
+    std::array<int, 3> std_arr{1, 2, 3};
+    ASSERT_EQ(sum(std_arr), 6);
+    ASSERT_EQ(sum(arr), 9);
+}
+
+TEST(SpanTest, vector) {
+    trace_int::init();
+    dl::vector<trace_int> vec(10);
+    for (int i = 0; i < 10; ++i) {
+        vec[static_cast<size_t>(i)].value = i;
+    }
+    const auto& cvec = vec;
+
+    dl::span s(vec);
+    dl::span cs(cvec);
+    static_assert(std::is_same_v<decltype(s), dl::span<trace_int>>);
+    static_assert(std::is_same_v<decltype(cs), dl::span<const trace_int>>);
+    static_assert(!std::is_constructible_v<dl::span<trace_int>, const dl::vector<trace_int>&>);
+    static_assert(!std::is_constructible_v<dl::span<trace_int>, dl::span<const trace_int>>);
+    dl::span<const trace_int> converted = s;
+    ASSERT_EQ(converted.data(), vec.data());
+
+    // slices refer to the vector's elements
+    auto mid = s.subspan(2, 5);
+    ASSERT_EQ(mid.data(), vec.data() + 2);
+    ASSERT_EQ(mid.size(), 5u);
+    ASSERT_EQ(mid.front().value, 2);
+    ASSERT_EQ(s.subspan(7).size(), 3u);
+    ASSERT_EQ(s.subspan(7, 100).size(), 3u);
+    ASSERT_EQ(s.subspan(10).size(), 0u);
+    ASSERT_THROW(s.subspan(11), std::out_of_range);
+    ASSERT_EQ(s.first(3).back().value, 2);
+    ASSERT_EQ(s.last(3).front().value, 7);
+    ASSERT_EQ(s.drop_front(4).drop_back(4).size(), 2u);
+    ASSERT_EQ(s.drop_front(4).front().value, 4);
+    mid[0].value = 42;
+    ASSERT_EQ(vec[2].value, 42);
+
+    // none of it copied or constructed anything
+    ASSERT_EQ(trace_int::basic_construct, 10u);
+    ASSERT_EQ(trace_int::copy_lval_construct, 0u);
+    ASSERT_EQ(trace_int::move_rval_construct, 0u);
+    ASSERT_EQ(trace_int::operator_lval_construct, 0u);
+    ASSERT_EQ(trace_int::destruct, 0u);
+
+    dl::vector<int> ints{1, 2, 3, 4};
+    ASSERT_EQ(sum(ints), 10);
+    ASSERT_EQ(sum(dl::span<const int>(ints).subspan(1, 2)), 5);
+}
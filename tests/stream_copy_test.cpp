@@ -0,0 +1,43 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include "memory_resource.h"
+#include "stream_copy.h"
+#include "test_type.h"
+#include "vector.h"
+
+TEST(StreamCopyTest, Basic) {
+    dl::vector<unsigned char> src(5000);
+    for (size_t i = 0; i < src.size(); ++i) {
+        src[i] = static_cast<unsigned char>(i * 7 + 3);
+    }
+    dl::vector<unsigned char> dst(src.size() + 64);
+    for (size_t offset : {0, 1, 17, 31, 32}) {
+        for (size_t n : {0, 1, 100, 255, 256, 257, 1000, 4096, 4999 - 32}) {
+            std::fill(dst.begin(), dst.end(), 0);
+            dl::stream_copy(dst.data() + offset, src.data() + 1, n);
+            ASSERT_EQ(std::memcmp(dst.data() + offset, src.data() + 1, n), 0) << offset << " " << n;
+            ASSERT_TRUE(std::all_of(dst.begin(), dst.begin() + offset, [](auto c) { return c == 0; }));
+            ASSERT_TRUE(std::all_of(dst.begin() + offset + n, dst.end(), [](auto c) { return c == 0; }));
+        }
+    }
+}
+
+TEST(StreamCopyTest, vector) {
+    static_assert(dl::is_bitwise_copy_v<std::allocator<int>, const int*, int*>);
+    static_assert(!dl::is_bitwise_copy_v<std::allocator<trace_int>, trace_int*, trace_int*>);
+    static_assert(!dl::is_bitwise_copy_v<std::allocator<int>, std::move_iterator<int*>, int*>);
+    static_assert(!dl::is_bitwise_copy_v<dl::pmr::polymorphic_allocator<int>, int*, int*>);
+
+    ASSERT_EQ(dl::stream_copy_threshold(), ~size_t(0)); // off unless asked for
+    dl::set_stream_copy_threshold(1024);
+    dl::vector<uint64_t> vec;
+    for (uint64_t i = 0; i < 100000; ++i) {
+        vec.push_back(i); // growth relocates through stream_copy
+    }
+    auto copy = vec;
+    dl::set_stream_copy_threshold(~size_t(0));
+    ASSERT_EQ(copy, vec);
+    ASSERT_EQ(copy[99999], 99999u);
+}
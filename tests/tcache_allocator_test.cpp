@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "tcache_allocator.h"
+#include "vector.h"
+
+TEST(TcacheAllocatorTest, size_classes) {
+    ASSERT_EQ(dl::tcache::class_index(0), 0u);
+    ASSERT_EQ(dl::tcache::class_index(16), 0u);
+    ASSERT_EQ(dl::tcache::class_index(17), 1u);
+    ASSERT_EQ(dl::tcache::class_index(4096), 8u);
+    ASSERT_EQ(dl::tcache::class_size(dl::tcache::class_index(3000)), 4096u);
+    ASSERT_EQ(dl::tcache::class_index(size_t(1) << 40), dl::tcache::num_classes);
+}
+
+TEST(TcacheAllocatorTest, reuse) {
+    dl::tcache_allocator<int> alloc;
+    auto p = alloc.allocate(100);
+    alloc.deallocate(p, 100);
+    auto q = alloc.allocate(120); // same 512 byte class
+    ASSERT_EQ(p, q);
+    alloc.deallocate(q, 120);
+
+    dl::vector<size_t, dl::tcache_allocator<size_t>> vec;
+    for (size_t i = 0; i < 100000; ++i) {
+        vec.push_back(i);
+    }
+    for (size_t i = 0; i < vec.size(); ++i) {
+        ASSERT_EQ(vec[i], i);
+    }
+}
+
+TEST(TcacheAllocatorTest, bounded) {
+    dl::tcache::flush();
+    dl::tcache::release();
+    constexpr size_t bytes = size_t(1) << 20;
+    auto limit = dl::tcache::bin_limit(dl::tcache::class_index(bytes));
+    dl::vector<void*> blocks;
+    for (size_t i = 0; i < limit + 3; ++i) {
+        blocks.push_back(dl::tcache::allocate(bytes));
+    }
+    for (auto p : blocks) {
+        dl::tcache::deallocate(p, bytes);
+    }
+    ASSERT_EQ(dl::tcache::thread_bytes(), limit * bytes);
+    ASSERT_EQ(dl::tcache::depot_bytes(), 3 * bytes);
+    dl::tcache::flush();
+    ASSERT_EQ(dl::tcache::thread_bytes(), 0u);
+    ASSERT_EQ(dl::tcache::depot_bytes(), (limit + 3) * bytes);
+    dl::tcache::release();
+    ASSERT_EQ(dl::tcache::depot_bytes(), 0u);
+}
+
+TEST(TcacheAllocatorTest, thread_exit) {
+    dl::tcache::flush();
+    dl::tcache::release();
+    constexpr size_t bytes = size_t(1) << 18;
+    void* freed = nullptr;
+    std::thread([&] {
+        dl::vector<char, dl::tcache_allocator<char>> vec(bytes);
+        freed = vec.data();
+    }).join();
+    ASSERT_EQ(dl::tcache::depot_bytes(), bytes);
+    auto p = dl::tcache::allocate(bytes - 100);
+    ASSERT_EQ(p, freed);
+    dl::tcache::deallocate(p, bytes - 100);
+
+    // blocks allocated on one thread may be freed on another
+    dl::vector<int, dl::tcache_allocator<int>> shared(1000, 1);
+    std::thread([&] {
+        auto moved = std::move(shared);
+        ASSERT_EQ(moved[999], 1);
+    }).join();
+    dl::tcache::flush();
+    dl::tcache::release();
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "memory_resource.h"
+#include "vector.h"
+#include "vector_expr.h"
+
+template<typename T>
+struct counting_allocator : std::allocator<T>
+{
+    template<typename U>
+    struct rebind
+    {
+        using other = counting_allocator<U>;
+    };
+
+    counting_allocator() = default;
+    template<typename U>
+    counting_allocator(const counting_allocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        ++allocations;
+        return std::allocator<T>::allocate(n);
+    }
+
+    static inline int allocations = 0;
+};
+
+template<typename T, typename U>
+bool operator==(const counting_allocator<T>&, const counting_allocator<U>&) { return true; }
+
+template<typename T, typename U>
+bool operator!=(const counting_allocator<T>&, const counting_allocator<U>&) { return false; }
+
+TEST(VectorExprTest, arithmetic) {
+    using fvector = dl::vector<float, counting_allocator<float>>;
+    fvector a, b, d;
+    for (int i = 0; i < 1000; ++i) {
+        a.push_back(static_cast<float>(i));
+        b.push_back(static_cast<float>(i % 7));
+        d.push_back(0.5f);
+    }
+
+    counting_allocator<float>::allocations = 0;
+    fvector c = a * b + d;
+    ASSERT_EQ(counting_allocator<float>::allocations, 1); // the result only, no temporaries
+    ASSERT_EQ(c.size(), 1000u);
+    ASSERT_EQ(c.capacity(), 1000u);
+    for (size_t i = 0; i < c.size(); ++i) {
+        ASSERT_EQ(c[i], a[i] * b[i] + d[i]);
+    }
+
+    // reuses c's buffer
+    c = (a - 1.0f) / 2.0f + -b;
+    ASSERT_EQ(counting_allocator<float>::allocations, 1);
+    ASSERT_EQ(c[9], (9.0f - 1.0f) / 2.0f - 2.0f);
+
+    // the target may appear in the expression
+    c = c * 2.0f + c;
+    ASSERT_EQ(c[9], 3 * ((9.0f - 1.0f) / 2.0f - 2.0f));
+
+    auto e = a * 2.0f; // nothing computed yet
+    a[3] = 100.0f;
+    fvector lazy_result(e);
+    ASSERT_EQ(lazy_result[3], 200.0f);
+
+    dl::vector<int> ints{1, 2, 3, 4, 5};
+    dl::vector<int> rem = ints % 2 * 10;
+    ASSERT_EQ(rem, (dl::vector<int>{10, 0, 10, 0, 10}));
+    dl::vector<int> small{7};
+    small.assign(ints + ints);
+    ASSERT_EQ(small, (dl::vector<int>{2, 4, 6, 8, 10}));
+    small = dl::lazy(ints) * 0 + 1;
+    ASSERT_EQ(small, (dl::vector<int>(5, 1)));
+    ASSERT_EQ(dl::sum(small * 0), 0);
+}
+
+TEST(VectorExprTest, compare_reduce) {
+    dl::vector<double> a{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+    dl::vector<double> b(11, 5.0);
+
+    ASSERT_EQ(dl::sum(a), 66.0);
+    ASSERT_EQ(dl::sum(a * b), 330.0);
+    ASSERT_EQ(dl::count(a > 5.0), 6u);
+    ASSERT_EQ(dl::count(dl::lazy(a) == b), 1u);
+    ASSERT_EQ(dl::sum(a <= 3.0), 3); // bools sum as int
+    ASSERT_TRUE(dl::any(a > 10.0));
+    ASSERT_FALSE(dl::any(a > 11.0));
+    ASSERT_TRUE(dl::all(a > 0.0 && a < 12.0));
+    ASSERT_FALSE(dl::all(!(a > 1.0) || a > 2.0));
+
+    dl::vector<double> clipped = dl::select(a > 5.0, b, a);
+    ASSERT_EQ(clipped, (dl::vector<double>{1, 2, 3, 4, 5, 5, 5, 5, 5, 5, 5}));
+    dl::vector<bool> mask = dl::lazy(a) != b;
+    ASSERT_EQ(dl::count(mask), 10u);
+
+    // vector against vector still compares lexicographically
+    ASSERT_TRUE(a < b);
+    ASSERT_FALSE(a == b);
+
+    // operators found through ADL leave other types alone
+    std::vector<dl::vector<int>> nested(3);
+    ASSERT_TRUE(nested.begin() < nested.end());
+
+    dl::pmr::vector<double> pa(a.begin(), a.end());
+    dl::pmr::vector<double> twice = pa + pa;
+    ASSERT_EQ(twice[10], 22.0);
+}
@@ -1,9 +1,14 @@
 #include <algorithm>
+#include <atomic>
 #include <gtest/gtest.h>
 #include <iterator>
 #include <sstream>
+#include <string>
+#include "memory.h"
 #include "vector.h"
 #include "test_type.h"
+#include "execution.h"
+#include "thread_pool.h"
 
 using size_type = dl::vector<int>::size_type;
 size_type cast(int n) {
@@ -565,4 +570,496 @@ TEST(VectorTest, emplace) {
     }
 }
 
+
+dl::hinted_range<std::istream_iterator<int>> stream_range(std::stringstream& stream, size_t hint) {
+    return dl::hinted(std::istream_iterator<int>(stream), std::istream_iterator<int>(), hint);
+}
+
+TEST(VectorTest, ranges) {
+    { // constructor, exact hint: single allocation
+        std::stringstream stream("1 2 3 4 5");
+        dl::vector<int> vec(dl::from_range, stream_range(stream, 5));
+        CHECK_VECTOR(vec, (dl::vector<int>{1, 2, 3, 4, 5}), 5);
+    }
+    { // forward range
+        std::initializer_list<int> list{1, 2, 3};
+        dl::vector<int> vec(dl::from_range, list);
+        CHECK_VECTOR(vec, (dl::vector<int>{1, 2, 3}), 3);
+        ASSERT_EQ(dl::size_hint(list), cast(3));
+    }
+    { // append, hint too small
+        std::stringstream stream("3 4 5");
+        dl::vector<int> vec{1, 2};
+        vec.append_range(stream_range(stream, 1));
+        ASSERT_EQ(vec, (dl::vector<int>{1, 2, 3, 4, 5}));
+    }
+    { // assign
+        std::stringstream stream("7 8");
+        dl::vector<int> vec{1, 2, 3};
+        vec.assign_range(stream_range(stream, 2));
+        ASSERT_EQ(vec, (dl::vector<int>{7, 8}));
+    }
+    { // insert with reallocation
+        std::stringstream stream("1 2");
+        auto vec = makeVector({0, 3, 4, 5});
+        trace_int::init();
+        auto res = vec.insert_range(vec.begin() + 1, stream_range(stream, 2));
+        EXPECT_EQ(res, vec.begin() + 1);
+        CHECK_TRACE(2, 0, 4, 0, 0, 4);
+        CHECK_VECTOR(vec, makeVector({0, 1, 2, 3, 4, 5}), 8);
+    }
+    { // insert in place, no rotate
+        std::stringstream stream("1 2");
+        auto vec = makeVector({0, 3, 4, 5});
+        vec.reserve(6);
+        trace_int::init();
+        vec.insert_range(vec.begin() + 1, stream_range(stream, 2));
+        CHECK_TRACE(2, 0, 2, 0, 3, 2);
+        CHECK_VECTOR(vec, makeVector({0, 1, 2, 3, 4, 5}), 6);
+    }
+    { // insert in place, hint larger than input and than tail
+        std::stringstream stream("1 2");
+        auto vec = makeVector({0, 3, 4});
+        vec.reserve(10);
+        vec.insert_range(vec.begin() + 1, stream_range(stream, 5));
+        CHECK_VECTOR(vec, makeVector({0, 1, 2, 3, 4}), 10);
+    }
+    { // insert in place, hint larger than input but smaller than tail
+        std::stringstream stream("1");
+        auto vec = makeVector({0, 3, 4, 5, 6});
+        vec.reserve(10);
+        vec.insert_range(vec.begin() + 1, stream_range(stream, 3));
+        CHECK_VECTOR(vec, makeVector({0, 1, 3, 4, 5, 6}), 10);
+    }
+    { // insert in place, input longer than hint
+        std::stringstream stream("1 2 3");
+        dl::vector<int> vec{0, 4, 5};
+        vec.reserve(10);
+        vec.insert_range(vec.begin() + 1, stream_range(stream, 1));
+        ASSERT_EQ(vec, (dl::vector<int>{0, 1, 2, 3, 4, 5}));
+    }
+    { // no hint
+        std::stringstream stream("1 2");
+        dl::vector<int> vec{0, 3};
+        vec.insert_range(vec.begin() + 1, stream_range(stream, 0));
+        ASSERT_EQ(vec, (dl::vector<int>{0, 1, 2, 3}));
+    }
+}
+
+// Single-pass iterator whose dereference throws once `left` reaches zero.
+struct throwing_input
+{
+    using iterator_category = std::input_iterator_tag;
+    using value_type = std::string;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string*;
+    using reference = std::string;
+
+    std::string operator*() const {
+        if (--*left == 0)
+            throw std::runtime_error("input");
+        return std::string(32, static_cast<char>('a' + pos));
+    }
+    throwing_input& operator++() { ++pos; return *this; }
+    void operator++(int) { ++pos; }
+    bool operator==(const throwing_input& o) const { return pos == o.pos; }
+    bool operator!=(const throwing_input& o) const { return pos != o.pos; }
+
+    int pos = 0;
+    int* left = nullptr;
+};
+
+TEST(VectorTest, insert_range_throwing_input) {
+    dl::vector<std::string> vec{"0", "1", "2", "3"};
+    vec.shrink_to_fit();
+    int left = 3;
+    auto range = dl::hinted(throwing_input{0, &left}, throwing_input{5, &left}, 5);
+    EXPECT_THROW(vec.insert_range(vec.begin() + 3, range), std::runtime_error);
+    ASSERT_EQ(vec, (dl::vector<std::string>{"0", "1", "2", "3"}));
+    ASSERT_EQ(vec.capacity(), cast(4));
+}
+
+TEST(VectorTest, batch_append) {
+    {
+        dl::vector<int> vec{1};
+        vec.append_n(4, [](size_t i) { return static_cast<int>(i) * 2; });
+        CHECK_VECTOR(vec, (dl::vector<int>{1, 0, 2, 4, 6}), 5);
+        int next = 10;
+        vec.append_n(2, [&] { return next++; });
+        CHECK_VECTOR(vec, (dl::vector<int>{1, 0, 2, 4, 6, 10, 11}), 10);
+    }
+    { // unchecked after reserve
+        auto vec = makeVector({1});
+        vec.reserve(3);
+        trace_int::init();
+        vec.emplace_back_unchecked(2);
+        vec.emplace_back_unchecked(3);
+        CHECK_TRACE(2, 0, 0, 0, 0, 0);
+        CHECK_VECTOR(vec, makeVector({1, 2, 3}), 3);
+    }
+    { // appender
+        auto vec = makeVector({1});
+        {
+            decltype(vec)::appender app(vec);
+            app.reserve(2);
+            trace_int::init();
+            app.emplace_back_unchecked(2);
+            app.emplace_back(3);
+            CHECK_TRACE(2, 0, 0, 0, 0, 0);
+            ASSERT_EQ(app.size(), cast(3));
+            app.push_back(trace_int(4)); // grows
+            ASSERT_EQ(app.size(), cast(4));
+        }
+        CHECK_VECTOR(vec, makeVector({1, 2, 3, 4}), 6);
+    }
+}
+
+template<typename T>
+struct tail_allocator
+{
+    using value_type = T;
+
+    tail_allocator() = default;
+    template<typename U>
+    tail_allocator(const tail_allocator<U>&) noexcept {}
+
+    T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T))); }
+    void deallocate(T* p, size_t) noexcept { ::operator delete(p); }
+    bool shrink_in_place(T*, size_t, size_t) noexcept { ++shrinks; return true; }
+
+    static inline int shrinks = 0;
+};
+
+template<typename T, typename U>
+bool operator==(const tail_allocator<T>&, const tail_allocator<U>&) { return true; }
+
+template<typename T, typename U>
+bool operator!=(const tail_allocator<T>&, const tail_allocator<U>&) { return false; }
+
+TEST(VectorTest, assignment) {
+    auto vec = makeVector({1, 2});
+    auto other = makeVector({3, 4, 5});
+    trace_int::init();
+    vec = other; // reallocates
+    CHECK_TRACE(0, 3, 0, 0, 0, 2);
+    CHECK_VECTOR(vec, makeVector({3, 4, 5}), 3);
+    vec.pop_back();
+    trace_int::init();
+    vec = other; // reuses the buffer
+    CHECK_TRACE(0, 1, 0, 2, 0, 0);
+
+    auto data = other.data();
+    trace_int::init();
+    vec = std::move(other);
+    CHECK_TRACE(0, 0, 0, 0, 0, 3);
+    ASSERT_EQ(vec.data(), data);
+    ASSERT_TRUE(other.empty());
+
+    vec = {trace_int(6)};
+    CHECK_VECTOR(vec, makeVector({6}), 3);
+}
+
+TEST(VectorTest, shrink_policy) {
+    using shrinking = dl::vector<int, std::allocator<int>, dl::fraction_shrink<1, 4, 16>>;
+    static_assert(sizeof(shrinking) == 3 * sizeof(size_t));
+    {
+        shrinking vec;
+        vec.append_n(1000, [](size_t i) { return static_cast<int>(i); });
+        ASSERT_EQ(vec.capacity(), cast(1000));
+        vec.resize(250);
+        ASSERT_EQ(vec.capacity(), cast(1000));
+        vec.pop_back();
+        ASSERT_EQ(vec.capacity(), cast(498));
+        ASSERT_EQ(vec.size(), cast(249));
+        ASSERT_EQ(vec.back(), 248);
+        // half full after a shrink: no reallocation until it doubles or falls below a quarter
+        vec.append_n(249, [](size_t) { return 0; });
+        ASSERT_EQ(vec.capacity(), cast(498));
+        vec.erase(vec.begin() + 125, vec.end());
+        ASSERT_EQ(vec.capacity(), cast(498));
+        vec.erase(vec.begin() + 10, vec.end());
+        ASSERT_EQ(vec.capacity(), cast(20));
+        ASSERT_EQ(vec, (shrinking{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+        vec.clear();
+        ASSERT_EQ(vec.capacity(), cast(16));
+    }
+    { // per-instance threshold
+        using dynamic = dl::vector<int, std::allocator<int>, dl::dynamic_shrink>;
+        dynamic vec(dl::dynamic_shrink(0.5, 0));
+        vec.resize(100);
+        vec.resize(51);
+        ASSERT_EQ(vec.capacity(), cast(100));
+        vec.resize(49);
+        ASSERT_EQ(vec.capacity(), cast(98));
+        dynamic copy(vec);
+        ASSERT_EQ(copy.shrink_policy().fraction(), 0.5);
+        vec.clear();
+        ASSERT_EQ(vec.capacity(), cast(0));
+        vec.set_shrink_policy(dl::dynamic_shrink());
+        vec.resize(100);
+        vec.resize(30);
+        ASSERT_EQ(vec.capacity(), cast(100));
+    }
+    { // in place when the allocator supports it
+        dl::vector<int, tail_allocator<int>, dl::fraction_shrink<>> vec(1000, 7);
+        auto data = vec.data();
+        vec.resize(10);
+        ASSERT_EQ(tail_allocator<int>::shrinks, 1);
+        ASSERT_EQ(vec.data(), data);
+        ASSERT_EQ(vec.capacity(), cast(64));
+        vec.push_back(7);
+        ASSERT_EQ(vec.size(), cast(11));
+    }
+    { // elements are moved into the smaller buffer
+        dl::vector<trace_int, std::allocator<trace_int>, dl::fraction_shrink<1, 4, 2>> vec;
+        vec.reserve(16);
+        vec.emplace_back(1);
+        vec.emplace_back(2);
+        vec.emplace_back(3);
+        trace_int::init();
+        vec.pop_back();
+        CHECK_TRACE(0, 0, 2, 0, 0, 3);
+        ASSERT_EQ(vec.capacity(), cast(4));
+    }
+}
+
+struct throw_on_copy
+{
+    throw_on_copy() { ++alive; }
+    throw_on_copy(const throw_on_copy& o) : armed(o.armed) {
+        if (armed && --countdown == 0)
+            throw std::runtime_error("copy");
+        ++alive;
+    }
+    ~throw_on_copy() { --alive; }
+
+    bool armed = false;
+    static std::atomic<int> alive;
+    static std::atomic<int> countdown;
+};
+
+std::atomic<int> throw_on_copy::alive{0};
+std::atomic<int> throw_on_copy::countdown{0};
+
+TEST(VectorTest, shrink_rollback) {
+    throw_on_copy::alive = 0;
+    {
+        dl::vector<throw_on_copy, std::allocator<throw_on_copy>, dl::fraction_shrink<1, 4, 4>> vec(64);
+        vec.resize(16);
+        ASSERT_EQ(vec.capacity(), cast(64));
+        for (auto& e : vec) {
+            e.armed = true;
+        }
+        throw_on_copy::countdown = 10;
+        vec.pop_back();
+        ASSERT_EQ(vec.size(), cast(15));
+        ASSERT_EQ(vec.capacity(), cast(64));
+        ASSERT_EQ(throw_on_copy::alive, 15);
+        throw_on_copy::countdown = 0;
+        vec.pop_back();
+        ASSERT_EQ(vec.capacity(), cast(28));
+        ASSERT_EQ(throw_on_copy::alive, 14);
+    }
+    ASSERT_EQ(throw_on_copy::alive, 0);
+}
+
+TEST(VectorTest, parallel) {
+    dl::thread_pool pool(4);
+    auto policy = dl::par.on(pool).with_threshold(0);
+    {
+        trace_int::init();
+        dl::vector<trace_int> vec(policy, 1000);
+        CHECK_TRACE(1000, 0, 0, 0, 0, 0);
+        CHECK_VECTOR(vec, dl::vector<trace_int>(1000), 1000);
+    }
+    {
+        dl::vector<int> vec(policy, 1000, 7);
+        CHECK_VECTOR(vec, dl::vector<int>(1000, 7), 1000);
+
+        dl::vector<int> copy(policy, vec);
+        CHECK_VECTOR(copy, vec, 1000);
+
+        vec.assign(policy, 500, vec[3] + 1);
+        CHECK_VECTOR(vec, dl::vector<int>(500, 8), 1000);
+        vec.assign(policy, 800, vec[0]);
+        CHECK_VECTOR(vec, dl::vector<int>(800, 8), 1000);
+        vec.assign(policy, 2000, 1);
+        CHECK_VECTOR(vec, dl::vector<int>(2000, 1), 2000);
+
+        vec.resize(policy, 3000);
+        ASSERT_EQ(vec.size(), cast(3000));
+        ASSERT_EQ(vec[1999], 1);
+        ASSERT_EQ(vec[2999], 0);
+        vec.resize(policy, 5000, vec[0]);
+        ASSERT_EQ(vec[4999], 1);
+    }
+    { // the copy keeps the shrink policy, like the serial one
+        using dynamic = dl::vector<int, std::allocator<int>, dl::dynamic_shrink>;
+        dynamic vec(dl::dynamic_shrink(0.5, 0));
+        vec.resize(1000);
+        dynamic copy(policy, vec);
+        ASSERT_EQ(copy.shrink_policy().fraction(), 0.5);
+        ASSERT_EQ(copy.shrink_policy().min_capacity(), cast(0));
+    }
+    { // below the threshold everything stays serial
+        dl::vector<int> vec(dl::par.on(pool), 10, 1);
+        CHECK_VECTOR(vec, dl::vector<int>(10, 1), 10);
+    }
+    { // exception cleanup
+        throw_on_copy proto;
+        proto.armed = true;
+        throw_on_copy::countdown = 700;
+        ASSERT_THROW(dl::vector<throw_on_copy>(policy, 1000, proto), std::runtime_error);
+        ASSERT_EQ(throw_on_copy::alive, 1);
+
+        dl::vector<throw_on_copy> vec(10);
+        throw_on_copy::countdown = 500;
+        ASSERT_THROW(vec.resize(policy, 1000, proto), std::runtime_error);
+        ASSERT_EQ(vec.size(), cast(10));
+        ASSERT_EQ(throw_on_copy::alive, 11);
+    }
+}
+
+template<typename T>
+struct counting_malloc_allocator : dl::malloc_allocator<T>
+{
+    template<typename U>
+    struct rebind
+    {
+        using other = counting_malloc_allocator<U>;
+    };
+
+    counting_malloc_allocator() = default;
+    template<typename U>
+    counting_malloc_allocator(const counting_malloc_allocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        ++allocations;
+        return dl::malloc_allocator<T>::allocate(n);
+    }
+
+    static inline int allocations = 0;
+};
+
+template<typename V, typename B, typename = void>
+struct can_adopt : std::false_type {};
+
+template<typename V, typename B>
+struct can_adopt<V, B, std::void_t<decltype(std::declval<V&>().adopt(std::declval<B>()))>> : std::true_type {};
+
+TEST(VectorTest, adopt_release) {
+    using vector = dl::vector<trace_int, counting_malloc_allocator<trace_int>>;
+    static_assert(can_adopt<vector, vector::buffer>::value);
+    static_assert(can_adopt<dl::vector<trace_int, counting_malloc_allocator<trace_int>, dl::fraction_shrink<>>,
+                            vector::buffer>::value);
+    static_assert(!can_adopt<dl::vector<trace_int>, vector::buffer>::value);
+    static_assert(!can_adopt<dl::vector<trace_int, dl::malloc_allocator<trace_int>>, vector::buffer>::value);
+    // a buffer from C code
+    auto raw = static_cast<trace_int*>(std::malloc(8 * sizeof(trace_int)));
+    for (int i = 0; i < 5; ++i) {
+        new (raw + i) trace_int(i);
+    }
+    trace_int::init();
+    counting_malloc_allocator<trace_int>::allocations = 0;
+    {
+        vector vec;
+        vec.adopt(raw, 5, 8);
+        ASSERT_EQ(vec.size(), cast(5));
+        ASSERT_EQ(vec.capacity(), cast(8));
+        ASSERT_EQ(vec[4].value, 4);
+        ASSERT_EQ(vec.data(), raw);
+        vec.push_back(trace_int(5)); // fits in the adopted capacity
+        ASSERT_EQ(vec.data(), raw);
+
+        auto buff = vec.release();
+        ASSERT_TRUE(vec.empty());
+        ASSERT_EQ(vec.capacity(), cast(0));
+        ASSERT_EQ(buff.data, raw);
+        ASSERT_EQ(buff.size, cast(6));
+        ASSERT_EQ(buff.capacity, cast(8));
+
+        vector other(1);
+        trace_int::init();
+        other.adopt(buff); // frees what other held
+        ASSERT_EQ(other.data(), raw);
+        ASSERT_EQ(other.back().value, 5);
+        CHECK_TRACE(0, 0, 0, 0, 0, 1);
+        vec = std::move(other);
+        ASSERT_EQ(vec.data(), raw);
+        trace_int::init();
+    }
+    CHECK_TRACE(0, 0, 0, 0, 0, 6);
+    ASSERT_EQ(counting_malloc_allocator<trace_int>::allocations, 1);
+
+    // and back to C
+    dl::vector<int, dl::malloc_allocator<int>> ints{1, 2, 3};
+    auto buff = ints.release();
+    ASSERT_EQ(buff.data[2], 3);
+    std::free(buff.data);
+}
+
+template<typename T>
+struct counting_zeroing_allocator : dl::zeroing_allocator<T>
+{
+    template<typename U>
+    struct rebind
+    {
+        using other = counting_zeroing_allocator<U>;
+    };
+
+    counting_zeroing_allocator() = default;
+    template<typename U>
+    counting_zeroing_allocator(const counting_zeroing_allocator<U>&) noexcept {}
+
+    T* allocate_zeroed(size_t n) {
+        ++zeroed;
+        return dl::zeroing_allocator<T>::allocate_zeroed(n);
+    }
+
+    static inline int zeroed = 0;
+};
+
+struct point
+{
+    int x;
+    int y;
+};
+
+template<>
+struct dl::is_zero_initializable<point> : std::true_type {};
+
+TEST(VectorTest, zeroed_value_init) {
+    static_assert(dl::zeroed_value_init_v<dl::zeroing_allocator<double>>);
+    static_assert(!dl::zeroed_value_init_v<std::allocator<int>>);
+    static_assert(!dl::zeroed_value_init_v<dl::zeroing_allocator<trace_int>>);
+
+    counting_zeroing_allocator<int>::zeroed = 0;
+    dl::vector<int, counting_zeroing_allocator<int>> vec(1000);
+    ASSERT_EQ(counting_zeroing_allocator<int>::zeroed, 1);
+    ASSERT_EQ(std::count(vec.begin(), vec.end(), 0), 1000);
+
+    vec[999] = 5;
+    vec.resize(5000); // fresh zeroed buffer
+    ASSERT_EQ(counting_zeroing_allocator<int>::zeroed, 2);
+    ASSERT_EQ(vec.size(), cast(5000));
+    ASSERT_EQ(vec[999], 5);
+    ASSERT_EQ(std::count(vec.begin(), vec.end(), 0), 4999);
+
+    vec.assign(vec.capacity(), 7);
+    vec.resize(10);
+    vec.resize(20); // reuses the buffer, so constructs
+    ASSERT_EQ(counting_zeroing_allocator<int>::zeroed, 2);
+    ASSERT_EQ(vec[9], 7);
+    ASSERT_EQ(std::count(vec.begin(), vec.end(), 0), 10);
+
+    dl::vector<point, dl::zeroing_allocator<point>> points(100);
+    ASSERT_EQ(points[99].x + points[99].y, 0);
+
+    // not zero-initializable: constructed as usual
+    trace_int::init();
+    dl::vector<trace_int, dl::zeroing_allocator<trace_int>> traced(10);
+    traced.resize(30);
+    ASSERT_EQ(trace_int::basic_construct, cast(30));
+}
+
 #undef CHECK_TRACE